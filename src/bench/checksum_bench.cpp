@@ -0,0 +1,111 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures the cost of page checksums: raw CRC32C throughput (hardware and
+ * portable) per page size, and the per-page cost of File::writePage and
+ * File::readPage with checksums on and off.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "checksum.h"
+#include "file.h"
+#include "page.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const int kCrcRounds = 20000;
+const PageId kFilePages = 2000;
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+void benchCrc(const std::size_t page_size)
+{
+  std::vector<char> buffer(page_size);
+  for (std::size_t i = 0; i < page_size; i++) {
+    buffer[i] = static_cast<char>(i * 31);
+  }
+
+  std::uint32_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < kCrcRounds; r++) {
+    sink += Crc32c::extend(r, &buffer[0], page_size);
+  }
+  const double fast = secondsSince(start);
+
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < kCrcRounds; r++) {
+    sink += Crc32c::extendPortable(r, &buffer[0], page_size);
+  }
+  const double portable = secondsSince(start);
+
+  const double bytes = static_cast<double>(page_size) * kCrcRounds;
+  std::cout << "crc32c page=" << page_size
+            << "\tdefault=" << (bytes / fast / (1 << 30)) << " GiB/s ("
+            << (fast / kCrcRounds * 1e9) << " ns/page)"
+            << "\tportable=" << (bytes / portable / (1 << 30)) << " GiB/s ("
+            << (portable / kCrcRounds * 1e9) << " ns/page)"
+            << "\t[" << sink << "]\n";
+}
+
+void benchFile(const bool checksums)
+{
+  const std::string filename = "bench.crc";
+  try {
+    File::remove(filename);
+  } catch (const FileNotFoundException&) {
+  }
+  File::setChecksumsEnabled(checksums);
+  {
+    File file = File::create(filename);
+    std::vector<PageId> pages;
+    for (PageId p = 0; p < kFilePages; p++) {
+      Page page = file.allocatePage();
+      while (page.hasSpaceForRecord("benchmark record")) {
+        page.insertRecord("benchmark record");
+      }
+      file.writePage(page);
+      pages.push_back(page.page_number());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (PageId p = 0; p < kFilePages; p++) {
+      file.writePage(file.readPage(pages[p]));
+    }
+    const double secs = secondsSince(start);
+    std::cout << "file read+write checksums=" << (checksums ? "on " : "off")
+              << "\t" << (secs / kFilePages * 1e6) << " us/page\n";
+  }
+  File::remove(filename);
+  File::setChecksumsEnabled(true);
+}
+
+}
+
+int main()
+{
+  std::cout << "hardware crc32c: "
+            << (Crc32c::isHardwareAccelerated() ? "yes" : "no") << "\n";
+  for (std::size_t size = Page::MIN_SIZE; size <= Page::MAX_SIZE; size *= 2) {
+    benchCrc(size);
+  }
+  benchFile(false);
+  benchFile(true);
+  return 0;
+}
@@ -0,0 +1,161 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures the clock's search for a victim through a BufMgr of the smallest
+ * page size, in a small pool and in one of as many frames as fit in memory
+ * next to the operating system's cache of the file.  Each pool is timed in
+ * three phases:
+ *
+ *  - fill: pages read in random order into the empty pool, each a miss that
+ *    takes a free frame without running the clock;
+ *  - hits: random reads of the pages filled in, all hits;
+ *  - mixed: random reads of a file a sixteenth larger than the pool, so
+ *    about one read in seventeen misses and runs the clock, whose hand
+ *    passes over the frames the hits in between referenced.
+ *
+ * Reads of the mixed phase are timed one by one, and told apart by whether
+ * the page was buffered beforehand.  A miss there less a miss of the fill
+ * phase, which reads the page the same way, is the clock's search and the
+ * eviction it leads to.  If the search grew with the number of frames, so
+ * would that difference.
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const std::size_t kPageSize = Page::MIN_SIZE;
+const std::uint32_t kSmallFrames = 1 << 16;
+const std::uint32_t kMaxFrames = 1 << 21;
+// Memory a frame takes besides its page: descriptor, page table entry, ...
+const std::size_t kFrameOverhead = 512;
+const int kReads = 4000000;
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Returns the number of frames that fit in half the free memory, leaving the
+ * other half to cache the file.
+ */
+std::uint32_t largestPool()
+{
+  const std::size_t free_bytes =
+      static_cast<std::size_t>(sysconf(_SC_AVPHYS_PAGES)) *
+      static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  const std::size_t frames = free_bytes / 2 / (kPageSize + kFrameOverhead);
+  // Whole segments of the clock's bitmaps
+  return static_cast<std::uint32_t>(std::min<std::size_t>(frames, kMaxFrames)) &
+         ~std::uint32_t(511);
+}
+
+/**
+ * Reads the given page through the pool and unpins it.
+ */
+void readPage(BufMgr& pool, File& file, const PageId page_number)
+{
+  Page* page;
+  pool.readPage(&file, page_number, page);
+  pool.unPinPage(&file, page_number, false);
+}
+
+
+/**
+ * Times the three phases in a pool of <frames> frames and prints the cost of
+ * a hit, of a miss without the clock and of a miss with it, in nanoseconds.
+ */
+void measureClock(File& file, const std::uint32_t frames)
+{
+  BufMgr pool(frames, kPageSize);
+  std::mt19937 random(frames);
+
+  std::vector<PageId> fill(frames);
+  for (std::uint32_t f = 0; f < frames; f++) {
+    fill[f] = f + 1;
+  }
+  std::shuffle(fill.begin(), fill.end(), random);
+  auto start = std::chrono::steady_clock::now();
+  for (std::uint32_t f = 0; f < frames; f++) {
+    readPage(pool, file, fill[f]);
+  }
+  const double free_miss = secondsSince(start) / frames * 1e9;
+
+  std::uniform_int_distribution<PageId> pick_filled(1, frames);
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < kReads; r++) {
+    readPage(pool, file, pick_filled(random));
+  }
+  const double hit = secondsSince(start) / kReads * 1e9;
+
+  std::uniform_int_distribution<PageId> pick(1, frames + frames / 16);
+  double miss_seconds = 0;
+  std::uint64_t misses = 0;
+  for (int r = 0; r < kReads; r++) {
+    const PageId page_number = pick(random);
+    const bool buffered = pool.prefetchPage(&file, page_number);
+    start = std::chrono::steady_clock::now();
+    readPage(pool, file, page_number);
+    if (!buffered) {
+      miss_seconds += secondsSince(start);
+      misses++;
+    }
+  }
+  const double clock_miss = miss_seconds / misses * 1e9;
+
+  std::cout << "frames=" << frames
+            << "\thit=" << hit << " ns"
+            << "\tmiss from free list=" << free_miss << " ns"
+            << "\tmiss with clock=" << clock_miss << " ns"
+            << "\tclock search=" << clock_miss - free_miss << " ns"
+            << "\t[" << misses << " misses]\n";
+}
+
+}
+
+int main()
+{
+  const std::string filename = "bench.clock_sweep";
+  try {
+    File::remove(filename);
+  } catch (const FileNotFoundException&) {
+  }
+
+  const std::uint32_t large = largestPool();
+  const std::uint32_t counts[] = {kSmallFrames, large};
+  {
+    File file = File::create(filename, Page::DEFAULT_FORMAT, kPageSize);
+    for (std::uint32_t p = 0; p < large + large / 16; p++) {
+      file.allocatePage();
+    }
+    for (int c = 0; c < 2; c++) {
+      if (counts[c] < kSmallFrames) {
+        std::cout << "frames=" << counts[c] << "\tnot enough memory\n";
+        continue;
+      }
+      measureClock(file, counts[c]);
+    }
+  }
+  File::remove(filename);
+  return 0;
+}
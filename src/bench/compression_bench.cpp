@@ -0,0 +1,151 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Compares scans of a plain file and an LZ-compressed file holding the same
+ * text records: bytes stored on disk, scan throughput and CPU time spent per
+ * page, plus raw codec speed.  Scans go through a small BufMgr so every page
+ * is a miss.  The OS page cache is not dropped, so the disk side of the
+ * trade-off shows up as the bytes-on-disk ratio rather than as wall time.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "file_iterator.h"
+#include "lz.h"
+#include "page_iterator.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const std::size_t kRecords = 60000;
+const int kScanRounds = 3;
+
+std::vector<std::string> makeRecords()
+{
+  const char* statuses[] = {"shipped", "pending", "returned", "cancelled"};
+  const char* regions[] = {"north", "south", "east", "west"};
+  std::vector<std::string> records;
+  char buf[128];
+  for (std::size_t r = 0; r < kRecords; r++) {
+    std::snprintf(buf, sizeof(buf),
+                  "order=%zu customer=%zu status=%s region=%s note=archived",
+                  r, (r * 7919) % 50000, statuses[r % 4], regions[(r / 3) % 4]);
+    records.push_back(buf);
+  }
+  return records;
+}
+
+std::uint64_t fileBytes(const std::string& filename)
+{
+  std::ifstream in(filename.c_str(), std::ios::binary | std::ios::ate);
+  return in.tellg();
+}
+
+void benchScan(const std::string& filename, const PageCompression compression,
+               const std::vector<std::string>& records)
+{
+  try {
+    File::remove(filename);
+  } catch (const FileNotFoundException&) {
+  }
+  PageId num_pages = 0;
+  {
+    File file = File::create(filename, Page::DEFAULT_FORMAT, Page::SIZE,
+                             compression);
+    BufMgr loader(64);
+    num_pages = loader.loadRecords(&file, records);
+    loader.flushFile(&file);
+  }
+  std::uint64_t disk_bytes = fileBytes(filename);
+  if (compression != PageCompression::NONE) {
+    disk_bytes += fileBytes(File::pageMapFilename(filename));
+  }
+
+  std::uint64_t seen = 0;
+  double secs, cpu;
+  {
+    File file = File::open(filename);
+    BufMgr pool(16);
+    const std::clock_t cpu_start = std::clock();
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kScanRounds; round++) {
+      for (PageId p = 1; p <= num_pages; p++) {
+        Page* page;
+        pool.readPage(&file, p, page);
+        for (PageIterator it = page->begin(); it != page->end(); ++it) {
+          seen++;
+        }
+        pool.unPinPage(&file, p, false);
+      }
+    }
+    secs = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    cpu = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+  }
+  const double logical = static_cast<double>(num_pages) * Page::SIZE * kScanRounds;
+
+  std::cout << (compression == PageCompression::NONE ? "plain" : "lz   ")
+            << "\tpages=" << num_pages
+            << "\tdisk=" << (disk_bytes >> 10) << " KiB"
+            << "\tratio=" << (static_cast<double>(num_pages) * Page::SIZE / disk_bytes)
+            << "\tscan=" << (logical / secs / (1 << 20)) << " MiB/s"
+            << "\tcpu=" << (cpu / (num_pages * kScanRounds) * 1e6) << " us/page"
+            << "\t[" << seen << " records]\n";
+  File::remove(filename);
+}
+
+void benchCodec(const std::vector<std::string>& records)
+{
+  // Typical page contents: a run of records, as a full page would hold.
+  std::string raw;
+  for (std::size_t r = 0; raw.size() < Page::SIZE; r++) {
+    raw += records[r];
+  }
+  raw.resize(Page::SIZE);
+  std::vector<char> out(LzCodec::maxCompressedSize(raw.size()));
+  std::vector<char> back(raw.size());
+
+  const int rounds = 20000;
+  std::size_t length = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    length = LzCodec::compress(raw.data(), raw.size(), &out[0], out.size());
+  }
+  const double comp = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    LzCodec::decompress(&out[0], length, &back[0], back.size());
+  }
+  const double decomp = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  const double bytes = static_cast<double>(raw.size()) * rounds;
+  std::cout << "codec\tcompress=" << (bytes / comp / (1 << 20)) << " MiB/s"
+            << "\tdecompress=" << (bytes / decomp / (1 << 20)) << " MiB/s\n";
+}
+
+}
+
+int main()
+{
+  const std::vector<std::string> records = makeRecords();
+  benchCodec(records);
+  benchScan("bench.plain", PageCompression::NONE, records);
+  benchScan("bench.lz", PageCompression::LZ, records);
+  return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Compares counting a file's used pages, records and free bytes with a full
+ * FileIterator and PageIterator pass against reading them from File::stats(),
+ * and measures what keeping the statistics costs a page write-back: flushing
+ * pages whose record counts changed (the file header is rewritten too)
+ * against flushing pages whose counts did not.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "file_iterator.h"
+#include "page_iterator.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const std::size_t kRecords = 120000;
+const int kRounds = 20;
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+void benchCounting(File& file)
+{
+  std::uint64_t records = 0;
+  std::uint64_t free_bytes = 0;
+  PageId pages = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; round++) {
+    for (FileIterator it = file.begin(); it != file.end(); ++it) {
+      Page page = *it;
+      pages++;
+      free_bytes += page.getFreeSpace();
+      for (PageIterator rec = page.begin(); rec != page.end(); ++rec) {
+        records++;
+      }
+    }
+  }
+  const double scan = secondsSince(start) / kRounds;
+
+  FileStats stats = file.stats();
+  start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; round++) {
+    stats = file.stats();
+  }
+  const double header = secondsSince(start) / kRounds;
+
+  std::cout << "full scan=" << (scan * 1e6) << " us"
+            << "\tstats()=" << (header * 1e6) << " us"
+            << "\tspeedup=" << (scan / header)
+            << "\t[scan: " << pages / kRounds << " pages, "
+            << records / kRounds << " records, " << free_bytes / kRounds
+            << " free bytes; stats: " << stats.used_pages << " pages, "
+            << stats.num_records << " records, " << stats.free_bytes
+            << " free bytes]\n";
+}
+
+/**
+ * Dirties every page of the file through a pool that holds it all, either
+ * deleting and reinserting a record (counts unchanged) or deleting one
+ * (counts changed), and times flushing the pool.
+ */
+double flushPages(File& file, const PageId pages, const bool change_counts)
+{
+  BufMgr pool(pages + 1);
+  for (PageId p = 1; p <= pages; p++) {
+    Page* page;
+    pool.readPage(&file, p, page);
+    PageIterator rec = page->begin();
+    const RecordId record_id = rec.record_id();
+    const std::string record = *rec;
+    page->deleteRecord(record_id);
+    if (!change_counts) {
+      page->insertRecord(record);
+    }
+    pool.unPinPage(&file, p, true);
+  }
+  const auto start = std::chrono::steady_clock::now();
+  pool.flushFile(&file);
+  return secondsSince(start);
+}
+
+}
+
+int main()
+{
+  const std::string filename = "bench.stats";
+  try {
+    File::remove(filename);
+  } catch (const FileNotFoundException&) {
+  }
+
+  std::vector<std::string> records;
+  char buf[64];
+  for (std::size_t r = 0; r < kRecords; r++) {
+    std::snprintf(buf, sizeof(buf), "record %zu payload abcdefghij", r);
+    records.push_back(buf);
+  }
+
+  {
+    File file = File::create(filename);
+    PageId pages;
+    {
+      BufMgr loader(64);
+      pages = loader.loadRecords(&file, records);
+      loader.flushFile(&file);
+    }
+    std::cout << "pages=" << pages << "\n";
+    benchCounting(file);
+
+    const double same = flushPages(file, pages, false);
+    const double changed = flushPages(file, pages, true);
+    std::cout << "flush, counts unchanged=" << (same / pages * 1e6)
+              << " us/page\tflush, counts changed="
+              << (changed / pages * 1e6) << " us/page\n";
+  }
+  File::remove(filename);
+  return 0;
+}
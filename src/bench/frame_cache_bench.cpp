@@ -0,0 +1,105 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures pins of a few hot pages, like the upper levels of an index that
+ * point lookups keep going through, with the frame caches off and on.  Every
+ * pin is a hit either way; with the caches on, repeat pins skip the shard
+ * mutex and hash table.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "buffer.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const std::uint32_t kFrames = 256;
+const PageId kHotPages = 32;
+const int kPinsPerThread = 500000;
+const unsigned kThreadCounts[] = {1, 2, 4, 8};
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Returns pins per second of <threads> threads pinning and unpinning random
+ * hot pages.
+ */
+double pinHotPages(BufMgr& pool, File& file, const unsigned threads)
+{
+  std::vector<std::thread> readers;
+  const auto start = std::chrono::steady_clock::now();
+  for (unsigned t = 0; t < threads; t++) {
+    readers.push_back(std::thread([&, t]() {
+      std::mt19937 random(t);
+      std::uniform_int_distribution<PageId> pick(1, kHotPages);
+      for (int r = 0; r < kPinsPerThread; r++) {
+        const PageId page_number = pick(random);
+        Page* page;
+        pool.readPage(&file, page_number, page);
+        pool.unPinPage(&file, page_number, false);
+      }
+    }));
+  }
+  for (unsigned t = 0; t < threads; t++) {
+    readers[t].join();
+  }
+  return threads * kPinsPerThread / secondsSince(start);
+}
+
+}
+
+int main()
+{
+  const std::string filename = "bench.frame_cache";
+  try {
+    File::remove(filename);
+  } catch (const FileNotFoundException&) {
+  }
+
+  std::vector<std::string> records;
+  char buf[64];
+  for (int r = 0; r < 20000; r++) {
+    std::snprintf(buf, sizeof(buf), "frame cache bench record %d", r);
+    records.push_back(buf);
+  }
+
+  {
+    File file = File::create(filename);
+    BufMgr pool(kFrames, Page::SIZE, 4);
+    const PageId pages = pool.loadRecords(&file, records);
+    std::cout << "pages=" << pages << "\thot pages=" << kHotPages << "\n";
+
+    for (unsigned c = 0; c < sizeof(kThreadCounts) / sizeof(unsigned); c++) {
+      const unsigned threads = kThreadCounts[c];
+      std::cout << "threads=" << threads;
+      for (int cached = 0; cached <= 1; cached++) {
+        pool.setFrameCache(cached);
+        std::cout << "\t" << (cached ? "cache on: " : "cache off: ")
+                  << pinHotPages(pool, file, threads) << " pins/s";
+      }
+      std::cout << "\n";
+    }
+    pool.flushFile(&file);
+  }
+  File::remove(filename);
+  return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures random page reads that hit in a pool much larger than the TLB
+ * covers with ordinary pages, each followed by a read of the page's record
+ * through its slot directory, for a pool whose frames are allocated one by
+ * one against one
+ * whose frames share a huge page arena.  The backing the arena got is
+ * printed; without huge pages on the machine both runs use ordinary pages.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "buffer.h"
+#include "page_iterator.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+// 64 MiB of frames
+const std::uint32_t kFrames = 8192;
+const int kReads = 2000000;
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Fills the pool with new pages of the file and returns reads per second of
+ * random pages among them.
+ */
+double readRandomPages(BufMgr& pool, File& file)
+{
+  for (std::uint32_t p = 0; p < kFrames; p++) {
+    PageId page_number;
+    Page* page;
+    pool.allocPage(&file, page_number, page);
+    page->insertRecord("huge page bench record");
+    pool.unPinPage(&file, page_number, false);
+  }
+
+  std::mt19937 random(1);
+  std::uniform_int_distribution<PageId> pick(1, kFrames);
+  std::size_t record_bytes = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < kReads; r++) {
+    const PageId page_number = pick(random);
+    Page* page;
+    pool.readPage(&file, page_number, page);
+    // The slot directory and the record lie at opposite ends of the page
+    record_bytes += page->getRecord(page->begin().record_id()).size();
+    pool.unPinPage(&file, page_number, false);
+  }
+  const double rate = kReads / secondsSince(start);
+  if (record_bytes == 0) {
+    std::cout << "no records read\n";
+  }
+  return rate;
+}
+
+}
+
+int main()
+{
+  const std::string filename = "bench.huge_pages";
+  for (int huge = 0; huge <= 1; huge++) {
+    try {
+      File::remove(filename);
+    } catch (const FileNotFoundException&) {
+    }
+    {
+      File file = File::create(filename);
+      BufMgr pool(kFrames, Page::SIZE, 1, PageTableType::CHAINED, huge);
+      const double rate = readRandomPages(pool, file);
+      std::cout << "backing=" << arenaBackingName(pool.getFrameBacking())
+                << "\tframes=" << kFrames << "\t" << rate << " reads/s\n";
+    }
+    File::remove(filename);
+  }
+  return 0;
+}
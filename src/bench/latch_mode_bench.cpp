@@ -0,0 +1,114 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures threads reading one hot page, each pinning it, reading its records
+ * and unpinning it, with the page latched shared against latched exclusively
+ * (which is how readers had to serialize before latch modes).  Runs once with
+ * reads that only use the CPU and once with reads that also wait briefly while
+ * holding the page, as on a cache miss or a lock held elsewhere; the second is
+ * where sharing pays off on a machine with few cores.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "buffer.h"
+#include "page_iterator.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const int kReadsPerThread = 2000;
+const unsigned kThreadCounts[] = {1, 2, 4, 8};
+const std::chrono::microseconds kWait(20);
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Returns reads per second of <threads> threads reading the page in <mode>.
+ */
+double readHotPage(BufMgr& pool, File& file, const PageId page_number,
+                   const unsigned threads, const LatchMode mode,
+                   const bool wait)
+{
+  std::vector<std::thread> readers;
+  std::vector<std::size_t> bytes(threads, 0);
+  const auto start = std::chrono::steady_clock::now();
+  for (unsigned t = 0; t < threads; t++) {
+    readers.push_back(std::thread([&, t]() {
+      for (int r = 0; r < kReadsPerThread; r++) {
+        Page* page;
+        pool.readPage(&file, page_number, page, ReadHint::NORMAL, mode);
+        for (PageIterator rec = page->begin(); rec != page->end(); ++rec) {
+          bytes[t] += (*rec).size();
+        }
+        if (wait) {
+          std::this_thread::sleep_for(kWait);
+        }
+        pool.unPinPage(&file, page_number, false, mode);
+      }
+    }));
+  }
+  for (unsigned t = 0; t < threads; t++) {
+    readers[t].join();
+  }
+  return threads * kReadsPerThread / secondsSince(start);
+}
+
+}
+
+int main()
+{
+  const std::string filename = "bench.latch";
+  try {
+    File::remove(filename);
+  } catch (const FileNotFoundException&) {
+  }
+
+  {
+    File file = File::create(filename);
+    BufMgr pool(16);
+    PageId page_number;
+    Page* page;
+    pool.allocPage(&file, page_number, page);
+    char buf[64];
+    for (int r = 0; r < 100; r++) {
+      std::snprintf(buf, sizeof(buf), "hot record %d", r);
+      page->insertRecord(buf);
+    }
+    pool.unPinPage(&file, page_number, true);
+
+    for (int wait = 0; wait < 2; wait++) {
+      for (unsigned c = 0; c < sizeof(kThreadCounts) / sizeof(unsigned); c++) {
+        const unsigned threads = kThreadCounts[c];
+        const double exclusive = readHotPage(pool, file, page_number, threads,
+                                             LatchMode::EXCLUSIVE, wait);
+        const double shared = readHotPage(pool, file, page_number, threads,
+                                          LatchMode::SHARED, wait);
+        std::cout << (wait ? "cpu+wait" : "cpu only")
+                  << "\tthreads=" << threads
+                  << "\texclusive=" << exclusive << " reads/s"
+                  << "\tshared=" << shared << " reads/s"
+                  << "\tspeedup=" << (shared / exclusive) << "\n";
+      }
+    }
+    pool.flushFile(&file);
+  }
+  File::remove(filename);
+  return 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures BufHashTbl under the churn of a buffer pool missing on every read:
+ * each operation removes the page in one frame and inserts another, taking
+ * entries from the heap or from a NodePool.  Each thread churns a table of
+ * its own, as each shard of a pool does, so only the allocator is shared.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bufHashTbl.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const PageId kFrames = 1024;
+const int kOpsPerThread = 2000000;
+const unsigned kThreadCounts[] = {1, 2, 4};
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Returns replacements per second of <threads> threads, each cycling pages
+ * through a table of kFrames entries.
+ */
+double churn(const File* file, const unsigned threads, const bool pooled)
+{
+  std::vector<std::thread> workers;
+  const auto start = std::chrono::steady_clock::now();
+  for (unsigned t = 0; t < threads; t++) {
+    workers.push_back(std::thread([&]() {
+      NodePool<hashBucket> nodes(pooled ? kFrames : 0);
+      BufHashTbl table(kFrames * 6 / 5 + 1, pooled ? &nodes : NULL);
+      for (PageId p = 0; p < kFrames; p++) {
+        table.insert(file, p, p);
+      }
+      for (int o = 0; o < kOpsPerThread; o++) {
+        const PageId evicted = o;
+        table.remove(file, evicted);
+        table.insert(file, evicted + kFrames, evicted % kFrames);
+      }
+    }));
+  }
+  for (unsigned t = 0; t < threads; t++) {
+    workers[t].join();
+  }
+  return threads * kOpsPerThread / secondsSince(start);
+}
+
+}
+
+int main()
+{
+  const std::string filename = "bench.node_pool";
+  try {
+    File::remove(filename);
+  } catch (const FileNotFoundException&) {
+  }
+
+  {
+    // Only the address of the file is used, as part of each key
+    File file = File::create(filename);
+    for (unsigned c = 0; c < sizeof(kThreadCounts) / sizeof(unsigned); c++) {
+      const unsigned threads = kThreadCounts[c];
+      std::cout << "threads=" << threads
+                << "\theap: " << churn(&file, threads, false)
+                << " replacements/s\tnode pool: " << churn(&file, threads, true)
+                << " replacements/s\n";
+    }
+  }
+  File::remove(filename);
+  return 0;
+}
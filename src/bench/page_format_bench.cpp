@@ -0,0 +1,80 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Compares the STANDARD and COMPACT slot directory layouts: how many records
+ * of a given size fit on one page, and how fast a full page can be scanned
+ * with a PageIterator.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "page.h"
+#include "page_iterator.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const int kScanPages = 2000;
+
+Page fillPage(const PageFormat format, const std::string& record)
+{
+  Page page(format);
+  while (page.hasSpaceForRecord(record)) {
+    page.insertRecord(record);
+  }
+  return page;
+}
+
+const char* formatName(const PageFormat format)
+{
+  return format == PageFormat::COMPACT ? "compact" : "standard";
+}
+
+void benchFormat(const PageFormat format, const std::size_t record_size)
+{
+  const std::string record(record_size, 'r');
+  std::vector<Page> pages(kScanPages, fillPage(format, record));
+  std::uint32_t per_page = 0;
+  for (PageIterator it = pages[0].begin(); it != pages[0].end(); ++it) {
+    per_page++;
+  }
+
+  std::uint64_t bytes = 0;
+  std::uint64_t records = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int p = 0; p < kScanPages; p++) {
+    for (PageIterator it = pages[p].begin(); it != pages[p].end(); ++it) {
+      bytes += (*it).length();
+      records++;
+    }
+  }
+  const auto stop = std::chrono::steady_clock::now();
+  const double secs = std::chrono::duration<double>(stop - start).count();
+
+  std::cout << formatName(format) << "\trecord=" << record_size
+            << "B\trecords/page=" << per_page
+            << "\tscan=" << (records / secs / 1e6) << " Mrec/s"
+            << "\t(" << (bytes / secs / (1 << 20)) << " MiB/s)\n";
+}
+
+}
+
+int main()
+{
+  const std::size_t sizes[] = {4, 8, 16, 32, 64, 256};
+  for (std::size_t size : sizes) {
+    benchFormat(PageFormat::STANDARD, size);
+    benchFormat(PageFormat::COMPACT, size);
+  }
+  return 0;
+}
@@ -0,0 +1,145 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures how operations on a page table scale with the number of threads,
+ * for BufHashTbl behind a mutex, as a buffer pool shard uses it, against
+ * LockFreeBufHashTbl.  The lookup run only finds pages; in the mixed run one
+ * operation in ten inserts or removes a page of the thread's own.  Neither
+ * gains beyond the machine's cores.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bufHashTbl.h"
+#include "lock_free_hash_tbl.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const PageId kPages = 4096;
+const int kOpsPerThread = 500000;
+const unsigned kThreadCounts[] = {1, 2, 4, 8};
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Runs <op> on the table, under <mutex> unless it is null.
+ */
+template <typename Op>
+void run(std::mutex* mutex, const Op& op)
+{
+  if (mutex == NULL) {
+    op();
+  } else {
+    std::lock_guard<std::mutex> lock(*mutex);
+    op();
+  }
+}
+
+/**
+ * Returns operations per second of <threads> threads looking up random pages
+ * of the table, inserting and removing pages of their own every
+ * <update_every> operations if that is nonzero.
+ */
+double runTable(PageTable& table, std::mutex* mutex, const File* file,
+                const unsigned threads, const int update_every)
+{
+  std::vector<std::thread> workers;
+  const auto start = std::chrono::steady_clock::now();
+  for (unsigned t = 0; t < threads; t++) {
+    workers.push_back(std::thread([&, t]() {
+      std::mt19937 random(t);
+      std::uniform_int_distribution<PageId> pick(1, kPages);
+      // Pages above kPages are each thread's own, so updates never collide
+      const PageId own_page = kPages + 1 + t;
+      bool inserted = false;
+      for (int o = 0; o < kOpsPerThread; o++) {
+        if (update_every != 0 && o % update_every == 0) {
+          run(mutex, [&]() {
+            if (inserted) {
+              table.remove(file, own_page);
+            } else {
+              table.insert(file, own_page, own_page);
+            }
+          });
+          inserted = !inserted;
+          continue;
+        }
+        const PageId page_number = pick(random);
+        FrameId frame;
+        run(mutex, [&]() { table.find(file, page_number, frame); });
+      }
+    }));
+  }
+  for (unsigned t = 0; t < threads; t++) {
+    workers[t].join();
+  }
+  return threads * kOpsPerThread / secondsSince(start);
+}
+
+double runChained(const File* file, const unsigned threads,
+                  const int update_every)
+{
+  BufHashTbl table(kPages * 6 / 5 + 1);
+  std::mutex mutex;
+  for (PageId p = 1; p <= kPages; p++) {
+    table.insert(file, p, p);
+  }
+  return runTable(table, &mutex, file, threads, update_every);
+}
+
+double runLockFree(const File* file, const unsigned threads,
+                   const int update_every)
+{
+  LockFreeBufHashTbl table(kPages * 6 / 5 + 1);
+  for (PageId p = 1; p <= kPages; p++) {
+    table.insert(file, p, p);
+  }
+  return runTable(table, NULL, file, threads, update_every);
+}
+
+}
+
+int main()
+{
+  const std::string filename = "bench.page_table";
+  try {
+    File::remove(filename);
+  } catch (const FileNotFoundException&) {
+  }
+
+  {
+    // Only the address of the file is used, as part of each key
+    File file = File::create(filename);
+    for (int mixed = 0; mixed <= 1; mixed++) {
+      const int update_every = mixed ? 10 : 0;
+      for (unsigned c = 0; c < sizeof(kThreadCounts) / sizeof(unsigned); c++) {
+        const unsigned threads = kThreadCounts[c];
+        std::cout << (mixed ? "mixed  " : "lookups") << "\tthreads=" << threads
+                  << "\tmutex: " << runChained(&file, threads, update_every)
+                  << " ops/s\tlock-free: "
+                  << runLockFree(&file, threads, update_every) << " ops/s\n";
+      }
+    }
+  }
+  File::remove(filename);
+  return 0;
+}
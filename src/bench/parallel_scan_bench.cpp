@@ -0,0 +1,117 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures ParallelScan throughput with 1, 2, 4, 8 and 16 worker threads,
+ * once through a pool that already holds the whole file and once through a
+ * pool too small to hold it.  The per-record callback does a fixed amount of
+ * work (hashing the record), standing in for predicate evaluation.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "buffer.h"
+#include "parallel_scan.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const std::size_t kRecords = 120000;
+const int kRounds = 3;
+const unsigned kThreads[] = {1, 2, 4, 8, 16};
+
+/**
+ * Per-worker result, padded to its own cache line.
+ */
+struct alignas(64) WorkerResult {
+  std::uint64_t records;
+  std::uint64_t hash;
+};
+
+void benchThreads(File& file, const PageId pages, const std::uint32_t frames,
+                  const char* name)
+{
+  BufMgr pool(frames);
+  ParallelScan warmup(&pool, &file, 1);
+  warmup.forEachPage([](unsigned, const Page&) {});
+
+  double base = 0;
+  for (std::size_t t = 0; t < sizeof(kThreads) / sizeof(kThreads[0]); t++) {
+    ParallelScan scan(&pool, &file, kThreads[t]);
+    std::vector<WorkerResult> results(scan.num_threads());
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; round++) {
+      scan.forEachRecord([&results](unsigned worker, const RecordId&,
+                                    const std::string& record) {
+        std::uint64_t h = 14695981039346656037ULL;
+        for (int pass = 0; pass < 8; pass++) {
+          for (std::size_t i = 0; i < record.size(); i++) {
+            h = (h ^ static_cast<unsigned char>(record[i])) * 1099511628211ULL;
+          }
+        }
+        results[worker].records++;
+        results[worker].hash ^= h;
+      });
+    }
+    const double secs = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    std::uint64_t records = 0;
+    for (std::size_t w = 0; w < results.size(); w++) {
+      records += results[w].records;
+    }
+    if (t == 0) {
+      base = secs;
+    }
+    const double bytes = static_cast<double>(pages) * Page::SIZE * kRounds;
+    std::cout << name << "\tthreads=" << kThreads[t]
+              << "\tscan=" << (bytes / secs / (1 << 20)) << " MiB/s"
+              << "\tspeedup=" << (base / secs)
+              << "\t[" << records << " records]\n";
+  }
+}
+
+}
+
+int main()
+{
+  const std::string filename = "bench.pscan";
+  try {
+    File::remove(filename);
+  } catch (const FileNotFoundException&) {
+  }
+
+  std::vector<std::string> records;
+  char buf[64];
+  for (std::size_t r = 0; r < kRecords; r++) {
+    std::snprintf(buf, sizeof(buf), "record %zu payload abcdefghij", r);
+    records.push_back(buf);
+  }
+
+  {
+    File file = File::create(filename);
+    PageId pages;
+    {
+      BufMgr loader(64);
+      pages = loader.loadRecords(&file, records);
+      loader.flushFile(&file);
+    }
+    std::cout << "pages=" << pages << " hardware threads="
+              << std::thread::hardware_concurrency() << "\n";
+    benchThreads(file, pages, pages + 16, "warm pool ");
+    benchThreads(file, pages, 64, "small pool");
+  }
+  File::remove(filename);
+  return 0;
+}
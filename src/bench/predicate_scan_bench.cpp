@@ -0,0 +1,128 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Compares filtering the records of in-memory pages by copying each record
+ * out with PageIterator and testing the copy against filtering them in place
+ * with Page::filterRecords, for a byte match, an integer compare and a user
+ * function.  About one record in seven matches each predicate.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "page.h"
+#include "page_iterator.h"
+#include "record_predicate.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const std::int32_t kRecords = 100000;
+const int kRounds = 20;
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Packs records made of a 32-bit key, a tag naming one of seven groups and
+ * some padding into as many pages as they need.
+ */
+std::vector<Page> makePages()
+{
+  std::vector<std::string> records;
+  char tag[32];
+  for (std::int32_t r = 0; r < kRecords; r++) {
+    std::snprintf(tag, sizeof(tag), "customer-group-%d|", r % 7);
+    records.push_back(std::string(reinterpret_cast<const char*>(&r), sizeof(r)) +
+                      tag + std::string(20 + r % 40, '.'));
+  }
+  std::vector<Page> pages;
+  for (std::size_t next = 0; next < records.size();) {
+    pages.push_back(Page());
+    next += pages.back().insertRecords(records, next);
+  }
+  return pages;
+}
+
+void bench(const char* name, std::vector<Page>& pages,
+           const RecordPredicate& predicate,
+           const std::function<bool(const std::string&)>& condition)
+{
+  std::uint64_t copied_matches = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; round++) {
+    for (std::size_t p = 0; p < pages.size(); p++) {
+      for (PageIterator it = pages[p].begin(); it != pages[p].end(); ++it) {
+        if (condition(*it)) {
+          copied_matches++;
+        }
+      }
+    }
+  }
+  const double copied = secondsSince(start);
+
+  std::uint64_t in_place_matches = 0;
+  std::vector<RecordId> record_ids;
+  start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; round++) {
+    for (std::size_t p = 0; p < pages.size(); p++) {
+      record_ids.clear();
+      in_place_matches += pages[p].filterRecords(predicate, &record_ids);
+    }
+  }
+  const double in_place = secondsSince(start);
+
+  const double records = static_cast<double>(kRecords) * kRounds;
+  std::cout << name
+            << "\tcopy+test=" << (copied / records * 1e9) << " ns/record"
+            << "\tin place=" << (in_place / records * 1e9) << " ns/record"
+            << "\tspeedup=" << (copied / in_place)
+            << "\t[" << copied_matches / kRounds << "/"
+            << in_place_matches / kRounds << " matches]\n";
+}
+
+}
+
+int main()
+{
+  std::vector<Page> pages = makePages();
+
+  const std::string tag = "customer-group-3|";
+  bench("bytes at", pages, RecordPredicate::bytesAt(4, tag),
+        [&tag](const std::string& record) {
+          return record.compare(4, tag.size(), tag) == 0;
+        });
+
+  bench("int32 at", pages,
+        RecordPredicate::int32At(0, CompareOp::LESS, kRecords / 7),
+        [](const std::string& record) {
+          std::int32_t key;
+          std::memcpy(&key, record.data(), sizeof(key));
+          return key < kRecords / 7;
+        });
+
+  bench("custom  ", pages,
+        RecordPredicate::custom([](const RecordView& record) {
+          return record.data[record.length - 1] == '.' &&
+                 record.length % 7 == 0;
+        }),
+        [](const std::string& record) {
+          return record[record.size() - 1] == '.' && record.size() % 7 == 0;
+        });
+  return 0;
+}
@@ -0,0 +1,206 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Compares answering two approximate questions with FileSampler against a
+ * full FileIterator pass: the number of records in a file (estimated from a
+ * page sample) and the mean of a key (estimated from a record sample).
+ * Reports time, pages read and the estimate's error for several sample
+ * sizes, with record samples drawn under the default bound on records per
+ * page and under one derived from the shortest record.  Last, shows how many
+ * pages of a hot working set stay in the pool while every other page is read
+ * through it, with and without ReadHint::ONCE.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "file_iterator.h"
+#include "page_iterator.h"
+#include "sampler.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const std::int32_t kRecords = 120000;
+const std::uint32_t kFrames = 64;
+const PageId kHotPages = 32;
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+std::int32_t keyOf(const char* record)
+{
+  std::int32_t key;
+  std::memcpy(&key, record, sizeof(key));
+  return key;
+}
+
+void benchFullScan(File& file, double& records, double& mean_key)
+{
+  std::uint64_t count = 0;
+  double key_sum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (FileIterator it = file.begin(); it != file.end(); ++it) {
+    Page page = *it;
+    for (PageIterator rec = page.begin(); rec != page.end(); ++rec) {
+      key_sum += keyOf((*rec).data());
+      count++;
+    }
+  }
+  const double secs = secondsSince(start);
+  records = static_cast<double>(count);
+  mean_key = key_sum / count;
+  std::cout << "full scan\ttime=" << (secs * 1e3) << " ms"
+            << "\trecords=" << records << "\tmean key=" << mean_key << "\n";
+}
+
+void benchSample(File& file, const PageId used_pages, const std::size_t size,
+                 const double records, const double mean_key)
+{
+  BufMgr pool(kFrames);
+  FileSampler sampler(&pool, &file, size);
+
+  std::uint64_t sampled_records = 0;
+  auto start = std::chrono::steady_clock::now();
+  const std::size_t pages = sampler.samplePages(size, [&](const Page& page) {
+    std::vector<SlotId> slots;
+    sampled_records += page.getUsedSlots(slots);
+  });
+  const double page_secs = secondsSince(start);
+  const double estimated_records =
+      static_cast<double>(sampled_records) / pages * used_pages;
+  const std::uint64_t page_reads = pool.getBufStats().diskreads;
+
+  pool.clearBufStats();
+  double key_sum = 0;
+  start = std::chrono::steady_clock::now();
+  const std::size_t drawn = sampler.sampleRecords(
+      size, [&key_sum](const RecordId&, const RecordView& record) {
+        key_sum += keyOf(record.data);
+      });
+  const double record_secs = secondsSince(start);
+  const double estimated_mean = key_sum / drawn;
+  const std::uint64_t record_reads = pool.getBufStats().diskreads;
+
+  // A bound derived from the shortest record instead of the page format.
+  const std::size_t shortest = sizeof(std::int32_t) + 17;
+  FileSampler bounded(&pool, &file, size,
+                      Page::DATA_SIZE / (shortest + sizeof(CompactPageSlot)));
+  pool.clearBufStats();
+  double bounded_sum = 0;
+  start = std::chrono::steady_clock::now();
+  const std::size_t bounded_drawn = bounded.sampleRecords(
+      size, [&bounded_sum](const RecordId&, const RecordView& record) {
+        bounded_sum += keyOf(record.data);
+      });
+  const double bounded_secs = secondsSince(start);
+  const double bounded_mean = bounded_sum / bounded_drawn;
+  const std::uint64_t bounded_reads = pool.getBufStats().diskreads;
+
+  std::cout << "sample=" << size
+            << "\tpages: time=" << (page_secs * 1e3) << " ms"
+            << " reads=" << page_reads
+            << " count error="
+            << (std::fabs(estimated_records - records) / records * 100) << "%"
+            << "\trecords: time=" << (record_secs * 1e3) << " ms"
+            << " reads=" << record_reads
+            << " mean error="
+            << (std::fabs(estimated_mean - mean_key) / mean_key * 100) << "%"
+            << "\tbounded records: time=" << (bounded_secs * 1e3) << " ms"
+            << " reads=" << bounded_reads
+            << " mean error="
+            << (std::fabs(bounded_mean - mean_key) / mean_key * 100) << "%\n";
+}
+
+/**
+ * Reads a hot set of pages normally, draws a sample as big as the file
+ * through the same pool, and counts the hot pages still in the pool.
+ */
+void benchHotSet(File& file, const PageId used_pages, const ReadHint hint)
+{
+  BufMgr pool(kFrames);
+  for (PageId p = 1; p <= kHotPages; p++) {
+    Page* page;
+    pool.readPage(&file, p, page);
+    pool.unPinPage(&file, p, false);
+  }
+  if (hint == ReadHint::ONCE) {
+    FileSampler sampler(&pool, &file);
+    sampler.samplePages(used_pages, [](const Page&) {});
+  } else {
+    // What sampling costs the pool without the hint.
+    for (PageId p = kHotPages + 1; p <= used_pages; p++) {
+      Page* page;
+      pool.readPage(&file, p, page);
+      pool.unPinPage(&file, p, false);
+    }
+  }
+  PageId resident = 0;
+  for (PageId p = 1; p <= kHotPages; p++) {
+    if (pool.prefetchPage(&file, p)) {
+      resident++;
+    }
+  }
+  std::cout << (hint == ReadHint::ONCE ? "read once" : "normal   ")
+            << "\thot pages still in pool=" << resident << "/" << kHotPages
+            << "\n";
+}
+
+}
+
+int main()
+{
+  const std::string filename = "bench.sample";
+  try {
+    File::remove(filename);
+  } catch (const FileNotFoundException&) {
+  }
+
+  std::vector<std::string> records;
+  char buf[64];
+  for (std::int32_t r = 0; r < kRecords; r++) {
+    std::snprintf(buf, sizeof(buf), " sampled record %d", r);
+    records.push_back(
+        std::string(reinterpret_cast<const char*>(&r), sizeof(r)) + buf);
+  }
+
+  {
+    File file = File::create(filename);
+    PageId used_pages;
+    {
+      BufMgr loader(kFrames);
+      used_pages = loader.loadRecords(&file, records);
+      loader.flushFile(&file);
+    }
+    std::cout << "pages=" << used_pages << "\n";
+
+    double num_records;
+    double mean_key;
+    benchFullScan(file, num_records, mean_key);
+    const std::size_t sizes[] = {10, 50, 200};
+    for (int s = 0; s < 3; s++) {
+      benchSample(file, used_pages, sizes[s], num_records, mean_key);
+    }
+    benchHotSet(file, used_pages, ReadHint::NORMAL);
+    benchHotSet(file, used_pages, ReadHint::ONCE);
+  }
+  File::remove(filename);
+  return 0;
+}
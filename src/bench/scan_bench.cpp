@@ -0,0 +1,121 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Compares full scans of a file with FileIterator (straight from disk) and
+ * with ScanIterator (through a BufMgr), once with a pool too small to hold
+ * the file and once with a pool that already holds all of it.  Reports
+ * throughput and how many pages each scan read from the file.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "file_iterator.h"
+#include "page_iterator.h"
+#include "scan_iterator.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const std::size_t kRecords = 120000;
+const int kRounds = 5;
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const char* name, const double secs, const PageId pages,
+            const std::uint64_t records, const std::uint64_t disk_reads)
+{
+  const double bytes = static_cast<double>(pages) * Page::SIZE * kRounds;
+  std::cout << name
+            << "\tscan=" << (bytes / secs / (1 << 20)) << " MiB/s"
+            << "\t" << (secs / (pages * kRounds) * 1e6) << " us/page"
+            << "\tdisk reads/scan=" << disk_reads
+            << "\t[" << records << " records]\n";
+}
+
+void benchFileIterator(File& file, const PageId pages)
+{
+  std::uint64_t records = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; round++) {
+    for (FileIterator it = file.begin(); it != file.end(); ++it) {
+      Page page = *it;
+      for (PageIterator rec = page.begin(); rec != page.end(); ++rec) {
+        records++;
+      }
+    }
+  }
+  // Each page is read once for its contents and once more for its header.
+  report("file iterator   ", secondsSince(start), pages, records, 2 * pages);
+}
+
+void benchScanIterator(const char* name, File& file, const PageId pages,
+                       const std::uint32_t frames)
+{
+  BufMgr pool(frames);
+  // Warm-up scan: fills a pool large enough to hold the file.
+  for (ScanIterator it = pool.scanBegin(&file); it != pool.scanEnd(&file); ++it) {
+  }
+  pool.clearBufStats();
+  std::uint64_t records = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; round++) {
+    for (ScanIterator it = pool.scanBegin(&file); it != pool.scanEnd(&file); ++it) {
+      for (PageIterator rec = it->begin(); rec != it->end(); ++rec) {
+        records++;
+      }
+    }
+  }
+  report(name, secondsSince(start), pages, records,
+         pool.getBufStats().diskreads / kRounds);
+}
+
+}
+
+int main()
+{
+  const std::string filename = "bench.scan";
+  try {
+    File::remove(filename);
+  } catch (const FileNotFoundException&) {
+  }
+
+  std::vector<std::string> records;
+  char buf[64];
+  for (std::size_t r = 0; r < kRecords; r++) {
+    std::snprintf(buf, sizeof(buf), "record %zu payload abcdefghij", r);
+    records.push_back(buf);
+  }
+
+  {
+    File file = File::create(filename);
+    PageId pages;
+    {
+      BufMgr loader(64);
+      pages = loader.loadRecords(&file, records);
+      loader.flushFile(&file);
+    }
+    std::cout << "pages=" << pages << "\n";
+    benchFileIterator(file, pages);
+    benchScanIterator("scan, small pool", file, pages, 16);
+    benchScanIterator("scan, warm pool ", file, pages, pages + 16);
+  }
+  File::remove(filename);
+  return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures how page reads through one buffer pool scale with the number of
+ * threads, for a pool with a single shard against pools split into several.
+ * The miss run reads random pages of a file much larger than the pool, so
+ * nearly every read evicts a page; the hit run reads pages of a file the pool
+ * holds entirely.  Neither gains beyond the machine's cores.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "buffer.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const std::uint32_t kFrames = 64;
+const int kReadsPerThread = 20000;
+const unsigned kThreadCounts[] = {1, 2, 4, 8};
+const std::uint32_t kShardCounts[] = {1, 4, 16};
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Returns reads per second of <threads> threads reading random pages among
+ * the first <pages> used pages of the file.
+ */
+double readRandomPages(File& file, const PageId pages, const unsigned threads,
+                       const std::uint32_t shards)
+{
+  BufMgr pool(kFrames, Page::SIZE, shards);
+  std::vector<std::thread> readers;
+  const auto start = std::chrono::steady_clock::now();
+  for (unsigned t = 0; t < threads; t++) {
+    readers.push_back(std::thread([&, t]() {
+      std::mt19937 random(t);
+      std::uniform_int_distribution<PageId> pick(1, pages);
+      for (int r = 0; r < kReadsPerThread; r++) {
+        const PageId page_number = pick(random);
+        Page* page;
+        pool.readPage(&file, page_number, page);
+        pool.unPinPage(&file, page_number, false);
+      }
+    }));
+  }
+  for (unsigned t = 0; t < threads; t++) {
+    readers[t].join();
+  }
+  return threads * kReadsPerThread / secondsSince(start);
+}
+
+}
+
+int main()
+{
+  const std::string filename = "bench.shard";
+  try {
+    File::remove(filename);
+  } catch (const FileNotFoundException&) {
+  }
+
+  std::vector<std::string> records;
+  char buf[64];
+  for (int r = 0; r < 200000; r++) {
+    std::snprintf(buf, sizeof(buf), "sharded bench record %d", r);
+    records.push_back(buf);
+  }
+
+  {
+    File file = File::create(filename);
+    PageId pages;
+    {
+      BufMgr loader(kFrames);
+      pages = loader.loadRecords(&file, records);
+      loader.flushFile(&file);
+    }
+    std::cout << "pages=" << pages << "\tframes=" << kFrames << "\n";
+
+    // Fewer pages than frames, minus slack for frames pinned at once
+    const PageId hot_pages = kFrames / 2;
+    for (int miss = 1; miss >= 0; miss--) {
+      for (unsigned c = 0; c < sizeof(kThreadCounts) / sizeof(unsigned); c++) {
+        const unsigned threads = kThreadCounts[c];
+        std::cout << (miss ? "misses" : "hits  ") << "\tthreads=" << threads;
+        for (unsigned s = 0; s < sizeof(kShardCounts) / sizeof(std::uint32_t);
+             s++) {
+          const double rate = readRandomPages(
+              file, miss ? pages : hot_pages, threads, kShardCounts[s]);
+          std::cout << "\tshards=" << kShardCounts[s] << ": " << rate
+                    << " reads/s";
+        }
+        std::cout << "\n";
+      }
+    }
+  }
+  File::remove(filename);
+  return 0;
+}
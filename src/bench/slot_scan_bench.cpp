@@ -0,0 +1,122 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures the cost of walking a full page's slot directory at several
+ * densities of used slots, one next-slot search at a time and as a single
+ * dense list, with the vector and the portable implementations.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "page.h"
+#include "slot_scan.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const int kRounds = 20000;
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Builds the slot directory of a page packed with 1-byte records, keeping
+ * one slot in every <keep_every>.
+ */
+std::vector<char> makeDirectory(const PageFormat format, const SlotId num_slots,
+                                const int keep_every)
+{
+  const std::size_t slot_size = format == PageFormat::COMPACT
+      ? sizeof(CompactPageSlot) : sizeof(PageSlot);
+  std::vector<char> directory(num_slots * slot_size);
+  for (SlotId i = 0; i < num_slots; i++) {
+    if (i % keep_every != 0) {
+      continue;
+    }
+    if (format == PageFormat::COMPACT) {
+      CompactPageSlot slot = {static_cast<std::uint16_t>(Page::DATA_SIZE - i - 1), 1};
+      *reinterpret_cast<CompactPageSlot*>(&directory[i * slot_size]) = slot;
+    } else {
+      PageSlot slot = {true, static_cast<std::uint16_t>(Page::DATA_SIZE - i - 1), 1};
+      *reinterpret_cast<PageSlot*>(&directory[i * slot_size]) = slot;
+    }
+  }
+  return directory;
+}
+
+void bench(const PageFormat format, const int keep_every)
+{
+  const std::size_t slot_size = format == PageFormat::COMPACT
+      ? sizeof(CompactPageSlot) : sizeof(PageSlot);
+  const SlotId num_slots = Page::DATA_SIZE / (slot_size + 1);
+  const std::vector<char> directory = makeDirectory(format, num_slots, keep_every);
+  const char* dir = directory.data();
+  std::vector<SlotId> slots(num_slots);
+  std::uint64_t sink = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < kRounds; r++) {
+    for (SlotId s = SlotScan::findNextUsedPortable(dir, format, 0, num_slots);
+         s != Page::INVALID_SLOT;
+         s = SlotScan::findNextUsedPortable(dir, format, s, num_slots)) {
+      sink += s;
+    }
+  }
+  const double find_portable = secondsSince(start);
+
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < kRounds; r++) {
+    for (SlotId s = SlotScan::findNextUsed(dir, format, 0, num_slots);
+         s != Page::INVALID_SLOT;
+         s = SlotScan::findNextUsed(dir, format, s, num_slots)) {
+      sink += s;
+    }
+  }
+  const double find_vector = secondsSince(start);
+
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < kRounds; r++) {
+    sink += SlotScan::collectUsedPortable(dir, format, num_slots, slots.data());
+  }
+  const double collect_portable = secondsSince(start);
+
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < kRounds; r++) {
+    sink += SlotScan::collectUsed(dir, format, num_slots, slots.data());
+  }
+  const double collect_vector = secondsSince(start);
+
+  std::cout << (format == PageFormat::COMPACT ? "compact " : "standard")
+            << "\tslots=" << num_slots << "\tused=1/" << keep_every
+            << "\tnext portable=" << (find_portable / kRounds * 1e9) << " ns"
+            << "\tnext " << SlotScan::implementation() << "="
+            << (find_vector / kRounds * 1e9) << " ns"
+            << "\tlist portable=" << (collect_portable / kRounds * 1e9) << " ns"
+            << "\tlist " << SlotScan::implementation() << "="
+            << (collect_vector / kRounds * 1e9) << " ns"
+            << "\t[" << sink << "]\n";
+}
+
+}
+
+int main()
+{
+  const int densities[] = {1, 10, 100};
+  for (int d = 0; d < 3; d++) {
+    bench(PageFormat::STANDARD, densities[d]);
+    bench(PageFormat::COMPACT, densities[d]);
+  }
+  return 0;
+}
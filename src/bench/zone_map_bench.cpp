@@ -0,0 +1,113 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Compares BufMgr::filterFile with and without a zone map on a file whose
+ * records are loaded in key order, for key ranges matching from 0.1% to all
+ * of the records.  The pool is too small to hold the file, so a full scan
+ * reads every page from the file on every round.  Reports time per scan and
+ * pages read per scan.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "record_predicate.h"
+#include "zone_map.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const std::int32_t kRecords = 120000;
+const int kRounds = 5;
+const std::uint32_t kFrames = 64;
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+void bench(File& file, const ZoneMap& zones, const double fraction)
+{
+  BufMgr pool(kFrames);
+  const RecordPredicate predicate = RecordPredicate::int32At(
+      0, CompareOp::LESS, static_cast<std::int32_t>(kRecords * fraction));
+  std::vector<RecordId> matches;
+
+  pool.clearBufStats();
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; round++) {
+    matches.clear();
+    pool.filterFile(&file, predicate, matches);
+  }
+  const double full = secondsSince(start);
+  const std::uint64_t full_reads = pool.getBufStats().diskreads / kRounds;
+
+  pool.clearBufStats();
+  start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; round++) {
+    matches.clear();
+    pool.filterFile(&file, predicate, matches, &zones);
+  }
+  const double skipping = secondsSince(start);
+  const std::uint64_t skipping_reads = pool.getBufStats().diskreads / kRounds;
+
+  std::cout << "matching=" << (fraction * 100) << "%"
+            << "\tfull scan=" << (full / kRounds * 1e3) << " ms"
+            << " (" << full_reads << " pages read)"
+            << "\tzone map=" << (skipping / kRounds * 1e3) << " ms"
+            << " (" << skipping_reads << " pages read)"
+            << "\tspeedup=" << (full / skipping)
+            << "\t[" << matches.size() << " matches]\n";
+}
+
+}
+
+int main()
+{
+  const std::string filename = "bench.zone";
+  try {
+    File::remove(filename);
+  } catch (const FileNotFoundException&) {
+  }
+
+  std::vector<std::string> records;
+  char buf[64];
+  for (std::int32_t r = 0; r < kRecords; r++) {
+    std::snprintf(buf, sizeof(buf), " payload of record %d", r);
+    records.push_back(
+        std::string(reinterpret_cast<const char*>(&r), sizeof(r)) + buf);
+  }
+
+  {
+    File file = File::create(filename);
+    ZoneMap zones(filename, 0, ZoneKeyType::INT32);
+    {
+      BufMgr loader(kFrames);
+      loader.setWriteBackHook(&file,
+                              [&zones](const Page& page) {
+                                zones.summarize(page);
+                              });
+      std::cout << "pages=" << loader.loadRecords(&file, records) << "\n";
+      loader.flushFile(&file);
+    }
+    const double fractions[] = {0.001, 0.01, 0.1, 1.0};
+    for (int f = 0; f < 4; f++) {
+      bench(file, zones, fractions[f]);
+    }
+  }
+  File::remove(filename);
+  return 0;
+}
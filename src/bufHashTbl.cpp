@@ -5,26 +5,54 @@
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
 
+#include <algorithm>
 #include <memory>
+#include <new>
 #include <iostream>
 #include "buffer.h"
 #include "bufHashTbl.h"
+#include "exceptions/buffer_exceeded_exception.h"
 #include "exceptions/hash_already_present_exception.h"
 #include "exceptions/hash_not_found_exception.h"
 #include "exceptions/hash_table_exception.h"
 
 namespace badgerdb {
 
-int BufHashTbl::hash(const File* file, const PageId pageNo)
+namespace {
+
+/**
+ * Number of old buckets each operation moves while the table is rehashed.
+ * Enough to finish well before the table needs resizing again
+ */
+const int kMigrateStep = 4;
+
+/**
+ * Adds the entries of a chain to the statistics, each costing one more
+ * comparison to find than the one before it
+ */
+void addChain(PageTableStats& stats, const hashBucket* chain)
+{
+  std::size_t probe = 0;
+  for (; chain; chain = chain->next) {
+    probe++;
+    stats.totalProbes += probe;
+  }
+  if (probe > stats.longestProbe)
+    stats.longestProbe = probe;
+}
+
+}
+
+int BufHashTbl::hash(const File* file, const PageId pageNo, const int size)
 {
   int tmp, value;
   tmp = (long)file;  // cast of pointer to the file object to an integer
-  value = (tmp + pageNo) % HTSIZE;
+  value = (tmp + pageNo) % size;
   return value;
 }
 
-BufHashTbl::BufHashTbl(int htSize)
-	: HTSIZE(htSize)
+BufHashTbl::BufHashTbl(int htSize, NodePool<hashBucket>* nodes)
+	: HTSIZE(htSize), oldHt(NULL), oldSize(0), migrated(0), minSize(htSize), numEntries(0), nodes(nodes)
 {
   // allocate an array of pointers to hashBuckets
   ht = new hashBucket* [htSize];
@@ -34,81 +62,175 @@ BufHashTbl::BufHashTbl(int htSize)
 
 BufHashTbl::~BufHashTbl()
 {
+  // Finishing the rehash leaves every entry in ht
+  migrate(oldSize);
   for(int i = 0; i < HTSIZE; i++) {
     hashBucket* tmpBuf = ht[i];
     while (ht[i]) {
       tmpBuf = ht[i];
       ht[i] = ht[i]->next;
-      delete tmpBuf;
+      freeBucket(tmpBuf);
     }
   }
   delete [] ht;
 }
 
-void BufHashTbl::insert(const File* file, const PageId pageNo, const FrameId frameNo)
+hashBucket* BufHashTbl::newBucket()
 {
-  int index = hash(file, pageNo);
-
-  hashBucket* tmpBuc = ht[index];
-  while (tmpBuc) {
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
-  		throw HashAlreadyPresentException(tmpBuc->file->filename(), tmpBuc->pageNo, tmpBuc->frameNo);
-    tmpBuc = tmpBuc->next;
+  if (nodes) {
+    hashBucket* tmpBuc = nodes->allocate();
+    // The buffer pool keeps a node for every frame, so this means more pages
+    // than frames
+    if (!tmpBuc)
+      throw BufferExceededException();
+    return tmpBuc;
   }
-
-  tmpBuc = new hashBucket;
+  hashBucket* tmpBuc = new hashBucket;
   if (!tmpBuc)
   	throw HashTableException();
+  return tmpBuc;
+}
+
+void BufHashTbl::freeBucket(hashBucket* bucket)
+{
+  if (nodes)
+    nodes->deallocate(bucket);
+  else
+    delete bucket;
+}
+
+hashBucket** BufHashTbl::locate(const File* file, const PageId pageNo)
+{
+  hashBucket** link = &ht[hash(file, pageNo, HTSIZE)];
+  for (; *link; link = &(*link)->next) {
+    if ((*link)->file == file && (*link)->pageNo == pageNo)
+      return link;
+  }
+  // Buckets already moved are empty
+  if (oldHt) {
+    for (link = &oldHt[hash(file, pageNo, oldSize)]; *link; link = &(*link)->next) {
+      if ((*link)->file == file && (*link)->pageNo == pageNo)
+        return link;
+    }
+  }
+  return NULL;
+}
+
+void BufHashTbl::migrate(const int buckets)
+{
+  if (!oldHt)
+    return;
+  for (int moved = 0; moved < buckets && migrated < oldSize; moved++, migrated++) {
+    while (oldHt[migrated]) {
+      hashBucket* tmpBuc = oldHt[migrated];
+      oldHt[migrated] = tmpBuc->next;
+      const int index = hash(tmpBuc->file, tmpBuc->pageNo, HTSIZE);
+      tmpBuc->next = ht[index];
+      ht[index] = tmpBuc;
+    }
+  }
+  if (migrated == oldSize) {
+    delete [] oldHt;
+    oldHt = NULL;
+    oldSize = 0;
+    migrated = 0;
+  }
+}
+
+void BufHashTbl::checkLoad()
+{
+  int size;
+  if (numEntries > (std::size_t) HTSIZE)
+    size = 2 * HTSIZE + 1;
+  else if (HTSIZE > minSize && numEntries < (std::size_t) HTSIZE / 4)
+    size = std::max(minSize, HTSIZE / 2);
+  else
+    return;
+
+  // Without memory for the new buckets the table just stays as it is
+  hashBucket** newHt = new (std::nothrow) hashBucket* [size];
+  if (!newHt)
+    return;
+
+  // A rehash still in progress is finished first; the thresholds are far
+  // enough apart for this to be rare
+  migrate(oldSize);
+  oldHt = ht;
+  oldSize = HTSIZE;
+  migrated = 0;
+  ht = newHt;
+  HTSIZE = size;
+  for(int i=0; i < HTSIZE; i++)
+    ht[i] = NULL;
+}
+
+void BufHashTbl::insert(const File* file, const PageId pageNo, const FrameId frameNo)
+{
+  migrate(kMigrateStep);
+  hashBucket** link = locate(file, pageNo);
+  if (link)
+		throw HashAlreadyPresentException((*link)->file->filename(), (*link)->pageNo, (*link)->frameNo);
+
+  int index = hash(file, pageNo, HTSIZE);
+  hashBucket* tmpBuc = newBucket();
 
   tmpBuc->file = (File*) file;
   tmpBuc->pageNo = pageNo;
   tmpBuc->frameNo = frameNo;
   tmpBuc->next = ht[index];
   ht[index] = tmpBuc;
+  numEntries++;
+  checkLoad();
 }
 
 void BufHashTbl::lookup(const File* file, const PageId pageNo, FrameId &frameNo) 
 {
-  int index = hash(file, pageNo);
-  hashBucket* tmpBuc = ht[index];
-  while (tmpBuc) {
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
-    {
-      frameNo = tmpBuc->frameNo; // return frameNo by reference
-      return;
-    }
-    tmpBuc = tmpBuc->next;
-  }
+  if (!find(file, pageNo, frameNo))
+    throw HashNotFoundException(file->filename(), pageNo);
+}
 
-  throw HashNotFoundException(file->filename(), pageNo);
+bool BufHashTbl::find(const File* file, const PageId pageNo, FrameId &frameNo) 
+{
+  migrate(kMigrateStep);
+  hashBucket** link = locate(file, pageNo);
+  if (!link)
+    return false;
+  frameNo = (*link)->frameNo; // return frameNo by reference
+  return true;
 }
 
 void BufHashTbl::remove(const File* file, const PageId pageNo) {
 
-  int index = hash(file, pageNo);
-  hashBucket* tmpBuc = ht[index];
-  hashBucket* prevBuc = NULL;
-
-  while (tmpBuc)
-	{
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
-		{
-      if(prevBuc) 
-				prevBuc->next = tmpBuc->next;
-      else
-				ht[index] = tmpBuc->next;
-
-      delete tmpBuc;
-      return;
-    }
-		else
-		{
-      prevBuc = tmpBuc;
-      tmpBuc = tmpBuc->next;
-    }
-  }
+  migrate(kMigrateStep);
+  hashBucket** link = locate(file, pageNo);
+  if (!link)
+    throw HashNotFoundException(file->filename(), pageNo);
 
-  throw HashNotFoundException(file->filename(), pageNo);
+  hashBucket* tmpBuc = *link;
+  *link = tmpBuc->next;
+  freeBucket(tmpBuc);
+  numEntries--;
+  checkLoad();
 }
 
+PageTableStats BufHashTbl::getStats()
+{
+  PageTableStats stats;
+  stats.entries = numEntries;
+  stats.buckets = HTSIZE;
+  for (int i = 0; i < HTSIZE; i++)
+    addChain(stats, ht[i]);
+  if (oldHt) {
+    stats.pendingBuckets = oldSize - migrated;
+    for (int i = migrated; i < oldSize; i++)
+      addChain(stats, oldHt[i]);
+  }
+  return stats;
+}
+
+bool BufHashTbl::concurrentReads() const
+{
+  return false;
 }
+
+}
\ No newline at end of file
@@ -7,7 +7,9 @@
 
 #pragma once
 
+#include <cstddef>
 #include "file.h"
+#include "node_pool.h"
 
 namespace badgerdb {
 
@@ -37,12 +39,146 @@ struct hashBucket {
 };
 
 
+/**
+* @brief Size of a page table and length of its chains, for judging how well it is sized
+*/
+struct PageTableStats
+{
+	/**
+   * Number of pages in the table
+	 */
+  std::size_t entries;
+
+	/**
+   * Number of buckets
+	 */
+  std::size_t buckets;
+
+	/**
+   * Buckets of the table an incremental rehash is moving entries out of, not yet moved
+	 */
+  std::size_t pendingBuckets;
+
+	/**
+   * Entries compared by the longest lookup of a page in the table
+	 */
+  std::size_t longestProbe;
+
+	/**
+   * Entries compared by looking up every page in the table once
+	 */
+  std::size_t totalProbes;
+
+	/**
+   * Pages per bucket
+	 */
+  double loadFactor() const
+  {
+		return buckets == 0 ? 0 : (double) entries / buckets;
+  }
+
+	/**
+   * Entries compared by the average lookup of a page in the table
+	 */
+  double averageProbe() const
+  {
+		return entries == 0 ? 0 : (double) totalProbes / entries;
+  }
+
+	/**
+   * Clear all values
+	 */
+  void clear()
+  {
+		entries = buckets = pendingBuckets = longestProbe = totalProbes = 0;
+  }
+
+	/**
+   * Constructor of PageTableStats class
+	 */
+  PageTableStats()
+  {
+		clear();
+  }
+};
+
+
+/**
+* @brief Interface of the tables the buffer pool keeps track of its pages in, mapping (file, page) to frame
+*/
+class PageTable
+{
+ public:
+	/**
+   * Destructor of PageTable class
+	 */
+  virtual ~PageTable() {}
+
+	/**
+   * Insert entry into the table mapping (file, pageNo) to frameNo.
+	 *
+	 * @param file   	File object
+	 * @param pageNo 	Page number in the file
+	 * @param frameNo Frame number assigned to that page of the file
+   * @throws  HashAlreadyPresentException	if the corresponding page already exists in the table
+	 */
+  virtual void insert(const File* file, const PageId pageNo, const FrameId frameNo) = 0;
+
+	/**
+   * Check if (file, pageNo) is currently in the buffer pool (ie. in the table).
+	 *
+	 * @param file  	File object
+	 * @param pageNo	Page number in the file
+	 * @param frameNo Frame number reference
+   * @throws HashNotFoundException if the page entry is not found in the table
+	 */
+  virtual void lookup(const File* file, const PageId pageNo, FrameId &frameNo) = 0;
+
+	/**
+   * Same as lookup(), but reports a missing entry through the return value instead of an exception.
+	 *
+	 * @param file  	File object
+	 * @param pageNo	Page number in the file
+	 * @param frameNo Frame number reference, set only if the entry is found
+	 * @return				True if the page entry is in the table
+	 */
+  virtual bool find(const File* file, const PageId pageNo, FrameId &frameNo) = 0;
+
+	/**
+   * Delete entry (file,pageNo) from the table.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+   * @throws HashNotFoundException if the page entry is not found in the table
+	 */
+  virtual void remove(const File* file, const PageId pageNo) = 0;
+
+	/**
+   * Returns true if find() may be called while other threads change the table.
+	 */
+  virtual bool concurrentReads() const = 0;
+
+	/**
+   * Returns the table's size and the length of its chains, found by walking every bucket. Must not run while
+   * other threads change the table.
+	 */
+  virtual PageTableStats getStats() = 0;
+};
+
 /**
 * @brief Hash table class to keep track of pages in the buffer pool
 *
+* The table doubles once it holds more pages than buckets, and halves once it holds fewer than a quarter as many,
+* but never below the size it was made with. Entries are moved to the new buckets a few old buckets at a time by
+* every operation, so no single operation pays for the whole rehash; until they are all moved, pages are looked for
+* in both. If memory for larger buckets cannot be had, the table keeps its size.
+*
+* Entries can be taken from a NodePool instead of the heap, as the buffer pool does so that its tables never
+* allocate once it has started.
+*
 * @warning This class is not threadsafe.
 */
-class BufHashTbl
+class BufHashTbl : public PageTable
 {
  private:
 	/**
@@ -55,19 +191,86 @@ class BufHashTbl
   hashBucket**  ht;
 
 	/**
-	 * returns hash value between 0 and HTSIZE-1 computed using file and pageNo
+	 * Table being rehashed into ht, or NULL if no rehash is in progress
+	 */
+  hashBucket**  oldHt;
+
+	/**
+	 * Size of oldHt
+	 */
+  int oldSize;
+
+	/**
+	 * Buckets of oldHt below this one have been moved into ht
+	 */
+  int migrated;
+
+	/**
+	 * Size the table was made with, below which it does not shrink
+	 */
+  const int minSize;
+
+	/**
+	 * Number of pages in the table
+	 */
+  std::size_t numEntries;
+
+	/**
+	 * Pool the entries are taken from, or NULL to take them from the heap
+	 */
+  NodePool<hashBucket>* nodes;
+
+	/**
+	 * Returns a new, unlinked entry
+	 *
+   * @throws  BufferExceededException if the table's node pool is empty
+   * @throws  HashTableException if no entry could be allocated from the heap
+	 */
+  hashBucket* newBucket();
+
+	/**
+	 * Frees an entry made by newBucket()
+	 */
+  void freeBucket(hashBucket* bucket);
+
+	/**
+	 * returns hash value between 0 and size-1 computed using file and pageNo
 	 *
 	 * @param file   	File object
 	 * @param pageNo  Page number in the file
+	 * @param size  	Number of buckets
 	 * @return  			Hash value.
 	 */
-  int	 hash(const File* file, const PageId pageNo);
+  int	 hash(const File* file, const PageId pageNo, const int size);
+
+	/**
+	 * Returns the link pointing at the entry for (file, pageNo), in ht or oldHt, or NULL if there is none
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 */
+  hashBucket** locate(const File* file, const PageId pageNo);
+
+	/**
+	 * Moves the entries of the next few buckets of oldHt into ht, ending the rehash once oldHt is empty
+	 *
+	 * @param buckets	Number of old buckets to move
+	 */
+  void migrate(const int buckets);
+
+	/**
+	 * Starts a rehash if the table is too full or too empty for its size
+	 */
+  void checkLoad();
 
  public:
 	/**
    * Constructor of BufHashTbl class
+	 *
+	 * @param htSize	Number of buckets, and the fewest the table shrinks back to
+	 * @param nodes		Pool to take entries from, which must outlive the table, or NULL to use the heap
 	 */
-	BufHashTbl(const int htSize);  // constructor
+	BufHashTbl(const int htSize, NodePool<hashBucket>* nodes = NULL);  // constructor
 
 	/**
    * Destructor of BufHashTbl class
@@ -81,6 +284,7 @@ class BufHashTbl
 	 * @param pageNo 	Page number in the file
 	 * @param frameNo Frame number assigned to that page of the file
    * @throws  HashAlreadyPresentException	if the corresponding page already exists in the hash table
+   * @throws  BufferExceededException if the table's node pool has no entry left
    * @throws  HashTableException (optional) if could not create a new bucket as running of memory
 	 */
   void insert(const File* file, const PageId pageNo, const FrameId frameNo);
@@ -96,6 +300,17 @@ class BufHashTbl
 	 */
   void lookup(const File* file, const PageId pageNo, FrameId &frameNo);
 
+	/**
+   * Same as lookup(), but reports a missing entry through the return value
+   * instead of an exception, for callers that expect misses.
+	 *
+	 * @param file  	File object
+	 * @param pageNo	Page number in the file
+	 * @param frameNo Frame number reference, set only if the entry is found
+	 * @return				True if the page entry is in the hash table
+	 */
+  bool find(const File* file, const PageId pageNo, FrameId &frameNo);
+
 	/**
    * Delete entry (file,pageNo) from hash table.
 	 *
@@ -104,6 +319,13 @@ class BufHashTbl
    * @throws HashNotFoundException if the page entry is not found in the hash table 
 	 */
   void remove(const File* file, const PageId pageNo);  
+
+	/**
+   * Always false: readers must hold the same lock as writers.
+	 */
+  bool concurrentReads() const;
+
+  PageTableStats getStats();
 };
 
 }
@@ -17,41 +17,164 @@
  * other page operations
  */
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <new>
 #include <iostream>
 #include "buffer.h"
+#include "epoch.h"
+#include "event_loop.h"
+#include "lock_free_hash_tbl.h"
+#include "record_predicate.h"
+#include "scan_iterator.h"
+#include "zone_map.h"
+#include "exceptions/invalid_page_exception.h"
 #include "exceptions/buffer_exceeded_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
 #include "exceptions/bad_buffer_exception.h"
 #include "exceptions/hash_not_found_exception.h"
+#include "exceptions/insufficient_space_exception.h"
+#include "exceptions/invalid_page_size_exception.h"
 
 namespace badgerdb { 
 
+namespace {
+
+/*
+ * Number of entries in each thread's frame cache
+ */
+const std::size_t kFrameCacheSize = 64;
+
+/*
+ * Frame cache entry: the frame a page was pinned in, and the frame's
+ * generation at the time. pool is 0 in entries never filled
+ */
+struct CachedFrame {
+  std::uint64_t pool;
+  const File* file;
+  PageId pageNo;
+  FrameId frameNo;
+  std::uint64_t generation;
+};
+
+// Shared by all pools; entries name the pool they belong to
+thread_local CachedFrame frameCacheEntries[kFrameCacheSize];
+
+std::atomic<std::uint64_t> nextPoolId(1);
+
+/*
+ * Frame number no frame has
+ */
+const FrameId kNoFrame = ~FrameId(0);
+
+/*
+ * Holds the mutex of every shard while in scope. Shards are locked in order;
+ * only stealFrame takes a second shard mutex, and it never waits for one
+ */
+class AllShardsLock
+{
+ public:
+  AllShardsLock(BufShard* shards, const std::uint32_t numShards)
+    : shards(shards), numShards(numShards)
+  {
+    for (std::uint32_t s = 0; s < numShards; s++)
+      shards[s].mutex.lock();
+  }
+
+  ~AllShardsLock()
+  {
+    for (std::uint32_t s = numShards; s > 0; s--)
+      shards[s - 1].mutex.unlock();
+  }
+
+ private:
+  BufShard* const shards;
+  const std::uint32_t numShards;
+
+  AllShardsLock(const AllShardsLock&);
+  AllShardsLock& operator=(const AllShardsLock&);
+};
+
+/*
+ * Number of buckets of the page table of a shard with the given number of
+ * frames
+ */
+int tableSizeFor(const std::size_t frames)
+{
+  return ((((int) (frames * 1.2))*2)/2)+1;
+}
+
+CachedFrame& cacheEntry(const File* file, const PageId pageNo)
+{
+  return frameCacheEntries[((std::uintptr_t) file + pageNo) % kFrameCacheSize];
+}
+
+/*
+ * Orders a shard's clock words by word index, for searches by frame number
+ * divided by 64
+ */
+bool wordBefore(const ClockWord& clockWord, const std::uint32_t word)
+{
+  return clockWord.word < word;
+}
+
+}
+
+const std::uint32_t FrameSegment::FRAMES;
+const std::uint32_t BufMgr::MAX_FRAMES;
+
 /*
  * Function Name: BufMgr
- * Input: uint32
+ * Input: uint32, page size, number of shards, page table type and whether
+ * to use huge pages
  * Output: BufMgr Object
  * Purpose: Constructor for BufMgr class
- * Creates an array of BufDesc, an array of pages, a BufHashTable
- * and initializes a clockHand.
+ * Creates the frames, each a BufDesc and a page of the given size, with
+ * their data in one huge page arena if asked, and splits the frames into
+ * shards, each with a page table of the given type, a free list and a
+ * clock.
  */
-BufMgr::BufMgr(std::uint32_t bufs)
-	: numBufs(bufs) {
-	bufDescTable = new BufDesc[bufs];
+BufMgr::BufMgr(std::uint32_t bufs, std::size_t pageSize, std::uint32_t shards, PageTableType tableType,
+               bool hugePages)
+	: numBufs(std::min(bufs, MAX_FRAMES)), pageSize(pageSize), frameLimit(0), frameArena(NULL),
+	  tableType(tableType), poolId(nextPoolId++), frameCache(false),
+	  policy(ReplacementPolicy::CLOCK) {
+  if (!Page::isValidSize(pageSize)) {
+    throw InvalidPageSizeException(pageSize, 0, "buffer pool");
+  }
+  bufs = numBufs;
+  segments = new FrameSegment*[MAX_FRAMES / FrameSegment::FRAMES]();
 
-  for (FrameId i = 0; i < bufs; i++) 
-  {
-  	bufDescTable[i].frameNo = i;
-  	bufDescTable[i].valid = false;
+  // std::string allocates a byte past the data for its terminator
+  if (hugePages) {
+    frameArena = new FrameArena(bufs, pageSize - sizeof(PageHeader) + 1, true);
   }
 
-  bufPool = new Page[bufs];
+  // Every shard needs a frame of its own
+  numShards = std::max<std::uint32_t>(1, std::min(shards, bufs));
+  this->shards = new BufShard[numShards];
+  for (std::uint32_t s = 0; s < numShards; s++) {
+    BufShard& shard = this->shards[s];
+    const std::uint32_t count = (std::uint64_t) bufs * (s + 1) / numShards - (std::uint64_t) bufs * s / numShards;
+    shard.clockWord = 0;
+    shard.clockBit = 0;
+    for (std::uint32_t i = 0; i < count; i++) {
+      attachFrame(shard, newFrame());
+    }
+    // Free frames are taken from the back, lowest first
+    shard.freeFrames.assign(shard.frames.rbegin(), shard.frames.rend());
 
-	int htsize = ((((int) (bufs * 1.2))*2)/2)+1;
-  hashTable = new BufHashTbl (htsize);  // allocate the buffer hash table
+    // allocate the shard's hash table, with an entry for every frame
+    shard.nodes.reserve(count);
+    shard.tableSize = tableSizeFor(count);
+    shard.hashTable = newPageTable(shard, shard.tableSize);
 
-  clockHand = bufs - 1;
+    shard.onceFrame = kNoFrame;
+    shard.excessFrames = 0;
+    shard.cachedAccesses = 0;
+  }
 }
 
 /*
@@ -59,181 +182,920 @@ BufMgr::BufMgr(std::uint32_t bufs)
  * Input: None
  * Output: None
  * Purpose: Destructor for BufMgr
- * Flushes out all dirty pages from the bufPool
- * then deallocates the buffer pool and the BufDesc Table
+ * Flushes out all dirty pages from the frames
+ * then deallocates the pages, the frame blocks and the shards
  */
 BufMgr::~BufMgr() {
-  //Goes through bufDescTable and flushes out all pages with a dirty bit
-  for (FrameId i = 0; i < numBufs; i++)
-  {
-    if(bufDescTable[i].dirty == true){
-      flushFile(bufDescTable[i].file);
+  //Goes through the shards' frames and flushes out all pages with a dirty bit
+  for (std::uint32_t s = 0; s < numShards; s++) {
+    for (std::size_t f = 0; f < shards[s].frames.size(); f++) {
+      if (descOf(shards[s].frames[f]).dirty == true) {
+        flushFile(descOf(shards[s].frames[f]).file);
+      }
+    }
+  }
+  //Deallocate the pages, released frames having none, and the shards' hashTables
+  for (std::uint32_t s = 0; s < numShards; s++) {
+    for (std::size_t f = 0; f < shards[s].frames.size(); f++) {
+      delete pageOf(shards[s].frames[f]);
     }
+    delete shards[s].table();
+  }
+  for (FrameId i = 0; i < frameLimit; i += FrameSegment::FRAMES) {
+    delete segments[i / FrameSegment::FRAMES];
   }
-  //Deallocate bufDescTable, bufPool and hashTable
-  delete [] bufDescTable;
-  delete [] bufPool;
-  delete hashTable;
+  delete [] segments;
+  delete frameArena;
+  delete [] shards;
 }
 
 /*
- * Function Name: advanceClock
+ * Function Name: newFrame
  * Input: None
- * Output: None
- * Purpose: Advance clock to next frame in the buffer pool
- * Uses modular math to logically make it like a clockHand
+ * Output: Number of the new frame
+ * Purpose: Make a frame holding an empty page, allocating a block of frames
+ * when the released frame numbers run out
+ */
+FrameId BufMgr::newFrame()
+{
+  FrameId frame;
+  {
+    std::lock_guard<std::mutex> lock(releasedMutex);
+    if (!releasedFrames.empty()) {
+      frame = releasedFrames.back();
+      releasedFrames.pop_back();
+    } else {
+      frame = frameLimit++;
+      if (frame % FrameSegment::FRAMES == 0) {
+        segments[frame / FrameSegment::FRAMES] = new FrameSegment(frame);
+      }
+    }
+  }
+  // Size every frame up front so reading a page never reallocates it. Once
+  // the arena's slots are used up, pages come from the heap
+  Page* page = new Page(Page::DEFAULT_FORMAT, pageSize, frameArena);
+  segments[frame / FrameSegment::FRAMES]->pages[frame % FrameSegment::FRAMES] = page;
+  return frame;
+}
+
+/*
+ * Function Name: newPageTable
+ * Input: Number of buckets
+ * Output: Empty page table
+ * Purpose: Make a page table of the kind the pool was made with
  */
-void BufMgr::advanceClock()
+PageTable* BufMgr::newPageTable(BufShard& shard, const int size)
 {
-    clockHand = (clockHand+1) % numBufs;
+  if (tableType == PageTableType::LOCK_FREE)
+    return new LockFreeBufHashTbl (size);
+  return new BufHashTbl (size, &shard.nodes);
+}
+
+/*
+ * Function Name: shardOf
+ * Input: File pointer and constant PageID
+ * Output: Reference to a shard
+ * Purpose: Pick the shard a page belongs to by hashing file and page number
+ */
+BufShard& BufMgr::shardOf(const File* file, const PageId pageNo)
+{
+  if (numShards == 1) {
+    return shards[0];
+  }
+  // Fibonacci hashing spreads consecutive page numbers over the shards
+  const std::uint64_t key = (std::uint64_t) (std::uintptr_t) file ^ pageNo;
+  const std::uint64_t mixed = key * 0x9E3779B97F4A7C15ull;
+  return shards[(mixed >> 32) % numShards];
 }
 
 /*
  * Function Name: allocBuf
- * Input: FrameId reference
+ * Input: Shard reference and FrameId reference
  * Output: None
- * Purpose: Allocates a freem frame using the clock algorithm
+ * Purpose: Allocates a free frame to the shard, stealing one from another
+ * shard if all of its own are pinned
  */
-void BufMgr::allocBuf(FrameId & frame)
+void BufMgr::allocBuf(BufShard& shard, FrameId & frame)
 {
- bool frameFound = false;
- std::uint32_t numPinned = 0;
+  // A shard left with frames to give up by resize() releases the ones it
+  // can evict now
+  while (shard.excessFrames > 0 && shard.frames.size() > 1 && evictFrame(shard, frame)) {
+    Page* page = releaseFrame(shard, frame);
+    shard.excessFrames--;
+    Epoch::synchronize();
+    delete page;
+  }
+  if (!evictFrame(shard, frame) && !stealFrame(shard, frame)) {
+    // Throws a BufferExceededException if all pages are pinned
+    throw BufferExceededException();
+  }
+}
 
- // Will continue through the buffPool until an appropriate frame is found
- while(frameFound == false) {
- // Advance the clock to next frame
- advanceClock();
+/*
+ * Function Name: evictFrame
+ * Input: Shard reference and FrameId reference
+ * Output: False if all frames of the shard are pinned
+ * Purpose: Takes a free frame of the shard or picks one with the clock
+ * algorithm
+ */
+bool BufMgr::evictFrame(BufShard& shard, FrameId & frame)
+{
+ if (!shard.freeFrames.empty()) {
+   frame = shard.freeFrames.back();
+   shard.freeFrames.pop_back();
+   return true;
+ }
 
- // Throws a BufferExceededException if all pages are pinned
- if(numPinned >= numBufs) {
-   throw BufferExceededException();
+ // Every frame of the shard holds a valid page from here on
+ if (!sweepClock(shard, frame)) {
+   return false;
  }
+ BufDesc& desc = descOf(frame);
 
- // check if valid is set
- if(bufDescTable[clockHand].valid == true) {
-  // if valid check refbit and see if was recently referenced.
-  if(bufDescTable[clockHand].refbit == true) {
-  // Reset refbit
-  bufDescTable[clockHand].refbit = false;
-  continue;
-  }
+ // Check if dirty bit is set
+ if(desc.dirty) {
+  // write the page back to its file (File stamps the page checksum), while
+  // the hash table still has it, so scans that do not take the shard mutex
+  // see the page in the pool until its write-back hook has run
+  writeBack(frame);
+ }
 
-  // corresponds to 2nd if statement if refbit is not set
-  else {
-  // check if page is pinned. reloop if it is
-   if(bufDescTable[clockHand].pinCnt > 0) {
-    numPinned++;
-    continue;
-   }
+ // Page is not pinned, remove entry from hash table
+ shard.table()->remove(desc.file, desc.pageNo);
+
+ // Call clear() to Set page
+ desc.Clear();
+ return true;
+}
 
-   // if page is not pinned
-   else {
-   // Allocated buffer frame has a valid page,
-   // Remove entry from hash table
-    hashTable->remove(bufDescTable[clockHand].file, bufDescTable[clockHand].pageNo);
+/*
+ * Function Name: sweepClock
+ * Input: Shard reference and FrameId reference
+ * Output: False if all frames of the shard are pinned
+ * Purpose: Run the shard's clock until it comes to an unpinned frame whose
+ * refbit is clear, and claim that frame
+ * The hand moves over the shard's words of refbits and pinned bits, taking
+ * the first frame from the hand on that is neither referenced nor pinned,
+ * and clearing the refbits of the frames it passes over on the way
+ */
+bool BufMgr::sweepClock(BufShard& shard, FrameId & frame)
+{
+  // A round passes every word once and stops at most once at every frame, so
+  // two rounds clear all refbits and come back to any frame left unpinned
+  const std::size_t steps = 2 * (shard.clockWords.size() + shard.frames.size());
+  for (std::size_t step = 0; step < steps; step++) {
+    const ClockWord& word = shard.clockWords[shard.clockWord];
+    FrameSegment& segment = segmentOfWord(word.word);
+    std::atomic<std::uint64_t>& refs = segment.refBits[word.word % FrameSegment::WORDS];
+    // The shard's frames from the hand to the end of the word
+    const std::uint64_t ahead = word.owned & (~std::uint64_t(0) << shard.clockBit);
+    const std::uint64_t unpinned = ahead & ~segment.pinnedBits[word.word % FrameSegment::WORDS].load();
+    const std::uint64_t victims = unpinned & ~refs.load();
+    // Frames passed over lose their refbits, pinned or not
+    std::uint64_t passed = ahead;
+    if (victims != 0) {
+      const std::uint32_t bit = __builtin_ctzll(victims);
+      passed &= (std::uint64_t(1) << bit) - 1;
+      shard.clockBit = bit + 1;
+      frame = word.word * 64 + bit;
+    }
+    if (refs.load() & passed) {
+      refs.fetch_and(~passed);
+    }
+    if (victims == 0 || shard.clockBit == 64) {
+      shard.clockWord = (shard.clockWord + 1) % shard.clockWords.size();
+      shard.clockBit = 0;
+    }
+    // A pinned bit may lag behind a pin just taken through a frame cache
+    if (victims != 0 && descOf(frame).claimUnpinned()) {
+      return true;
+    }
+  }
+
+  // Frame caches kept setting the refbits of the frames the clock cleared
+  for (std::size_t f = 0; f < shard.frames.size(); f++) {
+    if (descOf(shard.frames[f]).claimUnpinned()) {
+      frame = shard.frames[f];
+      return true;
+    }
+  }
+  // Gives up if all pages are pinned
+  return false;
+}
 
+/*
+ * Function Name: stealFrame
+ * Input: Shard reference and FrameId reference
+ * Output: False if no other shard can spare a frame
+ * Purpose: Move a frame from another shard to one whose frames are all
+ * pinned
+ */
+bool BufMgr::stealFrame(BufShard& thief, FrameId & frame)
+{
+  const std::uint32_t first = &thief - shards;
+  // Room for the frame is made before it is taken, so running out of memory
+  // cannot strand it between shards
+  try {
+    thief.frames.reserve(thief.frames.size() + 1);
+    thief.freeFrames.reserve(thief.frames.size() + 1);
+    thief.clockWords.reserve(thief.clockWords.size() + 1);
+  } catch (const std::bad_alloc&) {
+    return false;
+  }
+  for (std::uint32_t i = 1; i < numShards; i++) {
+    BufShard& victim = shards[(first + i) % numShards];
+    // Waiting here while holding the thief's mutex could deadlock
+    std::unique_lock<std::recursive_mutex> lock(victim.mutex, std::try_to_lock);
+    if (!lock.owns_lock() || victim.frames.size() <= 1 || !evictFrame(victim, frame)) {
+      continue;
+    }
+    detachFrame(victim, frame);
+    attachFrame(thief, frame);
+    // The victim's entries fit in one node fewer, now that it has one frame
+    // fewer holding a page
+    victim.nodes.give(thief.nodes);
+    return true;
+  }
+  return false;
+}
 
-    // Check if dirty bit is set
-    if(bufDescTable[clockHand].dirty) {
-    // call writePage to flush file
-    bufDescTable[clockHand].file->writePage(bufPool[clockHand]);
+/*
+ * Function Name: attachFrame
+ * Input: Shard reference and constant FrameId
+ * Output: None
+ * Purpose: Add a frame to the shard's frames and to the word of its clock
+ * holding the frame's bits, keeping the clock hand on the frames it was at
+ */
+void BufMgr::attachFrame(BufShard& shard, const FrameId frame)
+{
+  shard.frames.push_back(frame);
+  const std::uint32_t word = frame / 64;
+  const std::uint64_t bit = std::uint64_t(1) << (frame % 64);
+  std::vector<ClockWord>::iterator at = std::lower_bound(shard.clockWords.begin(), shard.clockWords.end(), word,
+                                                         wordBefore);
+  if (at != shard.clockWords.end() && at->word == word) {
+    at->owned |= bit;
+    return;
+  }
+  const std::uint32_t index = at - shard.clockWords.begin();
+  const ClockWord entry = {word, bit};
+  shard.clockWords.insert(at, entry);
+  if (shard.clockWords.size() > 1 && index <= shard.clockWord) {
+    shard.clockWord++;
+  }
+}
 
-    // Call clear() to Set page
-    bufDescTable[clockHand].Clear();
+/*
+ * Function Name: detachFrame
+ * Input: Shard reference and constant FrameId
+ * Output: None
+ * Purpose: Take a cleared frame out of the shard's frames and clock, keeping
+ * its clock hand in range
+ */
+void BufMgr::detachFrame(BufShard& shard, const FrameId frame)
+{
+  std::vector<FrameId>::iterator at = std::find(shard.frames.begin(), shard.frames.end(), frame);
+  *at = shard.frames.back();
+  shard.frames.pop_back();
 
-    // Frame found so exit while loop
-    frameFound = true;
+  std::vector<ClockWord>::iterator word = std::lower_bound(shard.clockWords.begin(), shard.clockWords.end(),
+                                                           frame / 64, wordBefore);
+  word->owned &= ~(std::uint64_t(1) << (frame % 64));
+  if (word->owned == 0) {
+    const std::uint32_t index = word - shard.clockWords.begin();
+    shard.clockWords.erase(word);
+    if (index < shard.clockWord) {
+      shard.clockWord--;
+    } else if (index == shard.clockWord) {
+      shard.clockBit = 0;
     }
+    if (shard.clockWord >= shard.clockWords.size()) {
+      shard.clockWord = 0;
+    }
+  }
+  if (shard.onceFrame == frame) {
+    shard.onceFrame = kNoFrame;
+  }
+}
 
+/*
+ * Function Name: releaseFrame
+ * Input: Shard reference and constant FrameId
+ * Output: Page of the frame, for the caller to free
+ * Purpose: Take a cleared frame out of the pool, leaving its number to be
+ * reused when the pool grows
+ */
+Page* BufMgr::releaseFrame(BufShard& shard, const FrameId frame)
+{
+  detachFrame(shard, frame);
+  {
+    std::lock_guard<std::mutex> lock(releasedMutex);
+    releasedFrames.push_back(frame);
+  }
+  return segments[frame / FrameSegment::FRAMES]->pages[frame % FrameSegment::FRAMES].exchange(NULL);
+}
 
-    else {
-    // Call clear();
-    bufDescTable[clockHand].Clear();
-    frameFound = true;
+/*
+ * Function Name: growTable
+ * Input: Shard reference
+ * Output: None
+ * Purpose: Move the shard's pages to a page table sized for its frames
+ */
+void BufMgr::growTable(BufShard& shard)
+{
+  const int size = tableSizeFor(shard.frames.size());
+  PageTable* table = newPageTable(shard, size);
+  // Frames whose page is being read in are valid and in the table already
+  for (std::size_t f = 0; f < shard.frames.size(); f++) {
+    BufDesc& desc = descOf(shard.frames[f]);
+    if (desc.valid) {
+      table->insert(desc.file, desc.pageNo, desc.frameNo);
     }
+  }
+  PageTable* old = shard.hashTable.exchange(table);
+  shard.tableSize = size;
+  // Lookups without the shard mutex may still be in the old table
+  Epoch::synchronize();
+  delete old;
+}
+
+/*
+ * Function Name: resize
+ * Input: New number of frames
+ * Output: None
+ * Purpose: Grow or shrink the buffer pool while it is in use
+ * Every shard is locked, in order, for the whole change. Growing hands new
+ * frames to the shards in turn; shrinking takes an even share from each
+ * shard, as far as its frames allow, and leaves what its pinned pages keep
+ * it from giving up to be released later
+ */
+void BufMgr::resize(std::uint32_t frames)
+{
+  frames = std::min(std::max(frames, numShards), MAX_FRAMES);
+  AllShardsLock lock(shards, numShards);
+
+  // Frames still owed from an earlier shrink are counted afresh
+  std::uint32_t current = 0;
+  for (std::uint32_t s = 0; s < numShards; s++) {
+    current += shards[s].frames.size();
+    shards[s].excessFrames = 0;
+  }
 
-    // Page is valid, set frame
-    frame = bufDescTable[clockHand].frameNo;
+  if (frames > current) {
+    std::vector<std::size_t> added(numShards, 0);
+    for (std::uint32_t i = 0; i < frames - current; i++) {
+      BufShard& shard = shards[i % numShards];
+      const FrameId frame = newFrame();
+      attachFrame(shard, frame);
+      shard.freeFrames.push_back(frame);
+      added[i % numShards]++;
+    }
+    for (std::uint32_t s = 0; s < numShards; s++) {
+      shards[s].freeFrames.reserve(shards[s].frames.size());
+      shards[s].nodes.reserve(added[s]);
+    }
+    // Chained tables rehash themselves a few buckets at a time as they fill
+    for (std::uint32_t s = 0; s < numShards && tableType == PageTableType::LOCK_FREE; s++) {
+      if (shards[s].frames.size() * 1.2 > shards[s].tableSize) {
+        growTable(shards[s]);
+      }
+    }
+  } else if (frames < current) {
+    // Deal out the frames to give up, leaving every shard one
+    std::vector<std::uint32_t> quota(numShards, 0);
+    std::uint32_t left = current - frames;
+    while (left > 0) {
+      for (std::uint32_t s = 0; s < numShards && left > 0; s++) {
+        if (quota[s] + 1 < shards[s].frames.size()) {
+          quota[s]++;
+          left--;
+        }
+      }
+    }
+    std::vector<Page*> released;
+    for (std::uint32_t s = 0; s < numShards; s++) {
+      BufShard& shard = shards[s];
+      FrameId frame;
+      while (quota[s] > 0 && evictFrame(shard, frame)) {
+        released.push_back(releaseFrame(shard, frame));
+        quota[s]--;
+      }
+      shard.excessFrames = quota[s];
+    }
+    // Lookups without the shard mutex may still be looking at the pages
+    Epoch::synchronize();
+    for (std::size_t p = 0; p < released.size(); p++) {
+      delete released[p];
     }
-   }
   }
+  numBufs = frames;
+}
 
- // corresponds to first if statement
- // Valid not set
-  else {
-   bufDescTable[clockHand].Clear();
-   //frame = clockHand; //could be correct?
-   frame = bufDescTable[clockHand].frameNo;
-   frameFound = true;
-   }
- }
+/*
+ * Function Name: reuseOnceFrame
+ * Input: Shard reference and FrameId reference
+ * Output: True if the frame of the last page read once was taken
+ * Purpose: Keep reads with ReadHint::ONCE from cycling through the whole shard
+ */
+bool BufMgr::reuseOnceFrame(BufShard& shard, FrameId & frame)
+{
+  if (shard.onceFrame == kNoFrame) {
+    return false;
+  }
+  BufDesc& desc = descOf(shard.onceFrame);
+  // Freed frames are on the free list; pinned ones, or ones read normally
+  // since, are left to the clock
+  if (!desc.valid || desc.refbit() || !desc.claimUnpinned()) {
+    return false;
+  }
+  // Written back before it leaves the hash table, as in evictFrame()
+  if (desc.dirty) {
+    writeBack(shard.onceFrame);
+  }
+  shard.table()->remove(desc.file, desc.pageNo);
+  desc.Clear();
+  frame = shard.onceFrame;
+  return true;
+}
+
+/*
+ * Function Name: writeBack
+ * Input: constant FrameId
+ * Output: None
+ * Purpose: Write the page in the frame to its file, count the write and run
+ * the file's write-back hook
+ */
+void BufMgr::writeBack(const FrameId frameNo)
+{
+  File* file = descOf(frameNo).file;
+  file->writePage(*pageOf(frameNo));
+  shardOf(file, descOf(frameNo).pageNo).stats.diskwrites++;
+
+  WriteBackHook hook;
+  {
+    std::lock_guard<std::mutex> lock(hookMutex);
+    std::map<const File*, WriteBackHook>::iterator it = writeBackHooks.find(file);
+    if (it != writeBackHooks.end()) {
+      hook = it->second;
+    }
+  }
+  if (hook) {
+    hook(*pageOf(frameNo));
+  }
 }
 
 /*
  * Function Name: readPage
- * Input: File pointer, constant PageID and reference to a Page
+ * Input: File pointer, constant PageID, reference to a Page, read hint and
+ * latch mode
  * Output: None
  * Purpose: Read a page from disk into the buffer pool
- * or set appropriate ref bit and increment pinCnt
+ * or set appropriate ref bit and increment pinCnt, then latch the page
  */
-void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
+void BufMgr::readPage(File* file, const PageId pageNo, Page*& page, const ReadHint hint, const LatchMode mode)
 {
-  // First check whether the page is already in the buffer pool
   FrameId tmp;
-  try{
+  if (!pinCached(file, pageNo, hint, tmp)) {
+    pinPage(file, pageNo, hint, tmp);
+    cacheFrame(file, pageNo, hint, tmp);
+  }
+  // The pin keeps the frame from being reassigned, so the latch can be waited
+  // for without the shard mutex (its holder needs the mutex to unpin)
+  descOf(tmp).latch.lock(mode);
+  page = pageOf(tmp);
+}
+
+/*
+ * Function Name: pinCached
+ * Input: File pointer, constant PageID, read hint and FrameId reference
+ * Output: True if the page was pinned
+ * Purpose: Pin a page through the calling thread's frame cache, skipping the
+ * shard mutex and hash table
+ */
+bool BufMgr::pinCached(File* file, const PageId pageNo, const ReadHint hint, FrameId & frame)
+{
+  if (!frameCache || hint != ReadHint::NORMAL) {
+    return false;
+  }
+  const CachedFrame& entry = cacheEntry(file, pageNo);
+  if (entry.pool != poolId || entry.file != file || entry.pageNo != pageNo) {
+    return false;
+  }
+  BufDesc& desc = descOf(entry.frameNo);
+  if (desc.generation != entry.generation) {
+    return false;
+  }
+  // A frame being cleared has a pin count of -1 and is left to pinPage
+  int pins = desc.pinCnt;
+  do {
+    if (pins < 0) {
+      return false;
+    }
+  } while (!desc.pinCnt.compare_exchange_weak(pins, pins + 1));
+  if (pins == 0) {
+    desc.pinnedWord->fetch_or(desc.bit);
+  }
+  // The frame may have been cleared between the check and the pin
+  if (desc.generation != entry.generation) {
+    desc.unpin();
+    return false;
+  }
+  if (references(hint)) {
+    desc.setRefbit(true);
+  }
+  shardOf(file, pageNo).cachedAccesses++;
+  frame = entry.frameNo;
+  return true;
+}
+
+/*
+ * Function Name: cacheFrame
+ * Input: File pointer, constant PageID, read hint and constant FrameId
+ * Output: None
+ * Purpose: Remember the frame of a page the calling thread has pinned
+ */
+void BufMgr::cacheFrame(File* file, const PageId pageNo, const ReadHint hint, const FrameId frame)
+{
+  if (!frameCache || hint != ReadHint::NORMAL) {
+    return;
+  }
+  // The pin keeps the generation from changing
+  const CachedFrame entry = {poolId, file, pageNo, frame, descOf(frame).generation};
+  cacheEntry(file, pageNo) = entry;
+}
+
+/*
+ * Function Name: unPinCached
+ * Input: File pointer, constant PageID, constant bool and latch mode
+ * Output: False if the frame cache has no entry for the page
+ * Purpose: Unpin a page found through the calling thread's frame cache
+ */
+bool BufMgr::unPinCached(File* file, const PageId pageNo, const bool dirty, const LatchMode mode)
+{
+  if (!frameCache) {
+    return false;
+  }
+  const CachedFrame& entry = cacheEntry(file, pageNo);
+  if (entry.pool != poolId || entry.file != file || entry.pageNo != pageNo) {
+    return false;
+  }
+  BufDesc& desc = descOf(entry.frameNo);
+  // While the caller's pin holds, only it can make the pin count drop to 0
+  if (desc.generation != entry.generation || desc.pinCnt <= 0) {
+    return false;
+  }
+  desc.latch.unlock(mode);
+  if (dirty) {
+    desc.dirty = true;
+  }
+  desc.unpin();
+  return true;
+}
+
+/*
+ * Function Name: tryReadPage
+ * Input: File pointer, constant PageID, reference to a Page and read hint
+ * Output: True if the page was in the buffer pool
+ * Purpose: Pin a page that is already in the buffer pool, without going to disk
+ */
+bool BufMgr::tryReadPage(File* file, const PageId pageNo, Page*& page, const ReadHint hint)
+{
+  if (file->page_size() != pageSize) {
+    throw InvalidPageSizeException(file->page_size(), pageSize, file->filename());
+  }
+  BufShard& shard = shardOf(file, pageNo);
+  std::lock_guard<std::recursive_mutex> lock(shard.mutex);
+  FrameId tmp;
+  if (!shard.table()->find(file, pageNo, tmp) || descOf(tmp).ioInProgress) {
+   return false;
+  }
+  shard.stats.accesses++;
+  if (references(hint)) {
+    descOf(tmp).setRefbit(true);
+  }
+  descOf(tmp).pin();
+  page = pageOf(tmp);
+  return true;
+}
+
+/*
+ * Function Name: readPageAsync
+ * Input: File pointer, constant PageID, event loop, callback and read hint
+ * Output: True if the page was in the buffer pool
+ * Purpose: Hand a page to the callback at once if it is buffered, otherwise
+ * read it on one of the loop's I/O threads and post the callback to the loop
+ */
+bool BufMgr::readPageAsync(File* file, const PageId pageNo, EventLoop& loop, const ReadCallback& done,
+                           const ReadHint hint)
+{
+  Page* page;
+  if (tryReadPage(file, pageNo, page, hint)) {
+    done(page, std::exception_ptr());
+    return true;
+  }
+  loop.submitIo([this, file, pageNo, &loop, done, hint]() {
+    Page* page = NULL;
+    std::exception_ptr error;
+    try {
+      // The page may have been read in meanwhile, which readPage handles
+      readPage(file, pageNo, page, hint);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    loop.post([done, page, error]() { done(page, error); });
+  });
+  return false;
+}
+
+/*
+ * Function Name: pinPage
+ * Input: File pointer, constant PageID, read hint and FrameId reference
+ * Output: None
+ * Purpose: Read a page from disk into the buffer pool if it is not there,
+ * set appropriate ref bit and increment pinCnt
+ * The disk is read without the shard mutex. The frame is published with its
+ * read in progress first, so threads missing on the same page meanwhile wait
+ * for this read instead of starting their own
+ */
+void BufMgr::pinPage(File* file, const PageId pageNo, const ReadHint hint, FrameId & tmp)
+{
+  if (file->page_size() != pageSize) {
+    throw InvalidPageSizeException(file->page_size(), pageSize, file->filename());
+  }
+  BufShard& shard = shardOf(file, pageNo);
+  std::unique_lock<std::recursive_mutex> lock(shard.mutex);
+
+  shard.stats.accesses++;
+
+  // First check whether the page is already in the buffer pool. Misses are
+  // expected here (every scan has them), so avoid the throwing lookup
+  while (shard.table()->find(file, pageNo, tmp)) {
    // Case 2: page is in the buffer pool
-   hashTable->lookup(file, pageNo, tmp);
-   // Set the appropriate refbit
-   bufDescTable[tmp].refbit = true;
-   // Increment pin count for the page
-   bufDescTable[tmp].pinCnt++;
-   // return pointer to the frame containing the page via page param
-   page = &bufPool[tmp];
+   BufDesc& desc = descOf(tmp);
+   // Set the appropriate refbit, unless the page is only read once or the
+   // pool recycles its frames
+   if (references(hint)) {
+     desc.setRefbit(true);
+   }
+   // Increment pin count for the page; this also keeps the frame while waiting
+   desc.pin();
+   if (!desc.ioInProgress) {
+     return;
+   }
+   shard.ioDone.wait(lock, [&desc]() { return !desc.ioInProgress; });
+   if (desc.valid) {
+     return;
+   }
+   // The read failed and the frame left the hash table; read the page anew
+   releaseFailedFrame(shard, tmp);
+  }
+
+  // Case 1: If page is not in the buffer pool
+  //Allocate buffer frame; pages read once recycle the frame of the last one
+  if (hint != ReadHint::ONCE || !reuseOnceFrame(shard, tmp)) {
+    allocBuf(shard, tmp);
+  }
+  BufDesc& desc = descOf(tmp);
+
+  //Insert page into hashtable and invoke Set() on the frame, pinning it
+  shard.table()->insert(file,pageNo,tmp);
+  desc.Set(file,pageNo);
+  desc.ioInProgress = true;
+  // A page read once, or into a pool that recycles its frames, is passed
+  // over by the clock only while pinned
+  if (!references(hint)) {
+    desc.setRefbit(false);
+  }
+  // and the frame of a page read once is the first choice for the next
+  if (hint == ReadHint::ONCE) {
+    shard.onceFrame = tmp;
+  }
+
+  //Read page straight into the frame (compressed pages are decompressed into it)
+  lock.unlock();
+  try {
+    file->readPage(pageNo, *pageOf(tmp));
+  } catch (...) {
+    // Such as a free page: the frame is given up once its waiters let go
+    lock.lock();
+    shard.table()->remove(file, pageNo);
+    desc.file = NULL;
+    desc.valid = false;
+    desc.ioInProgress = false;
+    releaseFailedFrame(shard, tmp);
+    shard.ioDone.notify_all();
+    throw;
+  }
+  lock.lock();
+  shard.stats.diskreads++;
+  desc.ioInProgress = false;
+  shard.ioDone.notify_all();
+}
+
+/*
+ * Function Name: releaseFailedFrame
+ * Input: Shard reference and constant FrameId
+ * Output: None
+ * Purpose: Drop a pin on a frame whose page could not be read, returning the
+ * frame to the shard's free list once nobody is left waiting on it
+ */
+void BufMgr::releaseFailedFrame(BufShard& shard, const FrameId frameNo)
+{
+  BufDesc& desc = descOf(frameNo);
+  if (--desc.pinCnt == 0) {
+    desc.Clear();
+    shard.freeFrames.push_back(frameNo);
+  }
+}
+
+/*
+ * Function Name: prefetchPage
+ * Input: File pointer and constant PageID
+ * Output: True if the page is in the buffer pool
+ * Purpose: Warm the CPU caches with a buffered page that is about to be used,
+ *          without pinning it or touching its refbit
+ */
+bool BufMgr::prefetchPage(File* file, const PageId pageNo)
+{
+  BufShard& shard = shardOf(file, pageNo);
+  const bool concurrent = tableType == PageTableType::LOCK_FREE;
+  std::unique_lock<std::recursive_mutex> lock(shard.mutex, std::defer_lock);
+  if (!concurrent)
+    lock.lock();
+  // Keeps resize() from freeing the table or page looked at. Taken after the
+  // lock, since resize() waits for it while holding the lock
+  Epoch::Guard guard(concurrent);
+  FrameId tmp;
+  if (!shard.table()->find(file, pageNo, tmp)) {
+   return false;
+  }
+  // Reading the page's header races with a read into its frame unless the
+  // mutex is held, and a prefetch is not worth waiting for it
+  if (concurrent && !lock.try_lock()) {
+    return true;
+  }
+  // Without the lock the frame may have been refilled since the lookup. A
+  // page still being read in is on its way to the caches already, and a
+  // released frame has no page left
+  BufDesc& desc = descOf(tmp);
+  Page* page = pageOf(tmp);
+  if (page != NULL && desc.file == file && desc.pageNo == pageNo && !desc.ioInProgress) {
+    page->prefetch();
   }
+  return true;
+}
+
+/*
+ * Function Name: prefetchPages
+ * Input: File pointer, first page number and number of pages
+ * Output: None
+ * Purpose: Start the operating system reading a run of pages that is about
+ *          to be scanned, unless the run is already buffered
+ */
+void BufMgr::prefetchPages(File* file, const PageId firstPageNo, const PageId numPages)
+{
+  BufShard& shard = shardOf(file, firstPageNo);
+  const bool concurrent = tableType == PageTableType::LOCK_FREE;
+  std::unique_lock<std::recursive_mutex> lock(shard.mutex, std::defer_lock);
+  if (!concurrent)
+    lock.lock();
+  Epoch::Guard guard(concurrent);
+  FrameId tmp;
+  if (!shard.table()->find(file, firstPageNo, tmp)) {
+   file->prefetchPages(firstPageNo, numPages);
+  }
+}
+
+/*
+ * Function Name: scanBegin
+ * Input: File pointer
+ * Output: ScanIterator at the first page of the file
+ * Purpose: Start a scan of the file that reads its pages through the buffer pool
+ */
+ScanIterator BufMgr::scanBegin(File* file)
+{
+  return ScanIterator(this, file);
+}
+
+/*
+ * Function Name: scanEnd
+ * Input: File pointer
+ * Output: ScanIterator past the last page of the file
+ * Purpose: End marker for scans started with scanBegin
+ */
+ScanIterator BufMgr::scanEnd(File* file)
+{
+  return ScanIterator(this, file, Page::INVALID_NUMBER);
+}
 
-  catch(HashNotFoundException e){
-      // Case 1: If page is not in the buffer pool
-      //Allocate buffer frame
-      allocBuf(tmp);
+/*
+ * Function Name: filterFile
+ * Input: File pointer, predicate and vector of record IDs
+ * Output: Number of matching records
+ * Purpose: Scan the file through the buffer pool, collecting the IDs of records that satisfy the predicate
+ */
+std::size_t BufMgr::filterFile(File* file, const RecordPredicate& predicate, std::vector<RecordId>& recordIds,
+                              const ZoneMap* zoneMap)
+{
+  std::size_t count = 0;
+  if (zoneMap == NULL) {
+    for (ScanIterator it = scanBegin(file); it != scanEnd(file); ++it) {
+      count += it->filterRecords(predicate, &recordIds);
+    }
+    return count;
+  }
 
-      //Read page 
-      bufPool[tmp] = file->readPage(pageNo);
+  // Skipped pages break up the used page chain, so walk page numbers instead
+  const PageId numPages = file->readHeader().num_pages;
+  for (PageId pageNo = 1; pageNo < numPages; pageNo++) {
+    if (!mayMatch(file, pageNo, predicate, *zoneMap)) {
+      continue;
+    }
+    Page* page;
+    try {
+      readPage(file, pageNo, page);
+    } catch (const InvalidPageException&) {
+      continue;  // Free page
+    }
+    count += page->filterRecords(predicate, &recordIds);
+    unPinPage(file, pageNo, false);
+  }
+  return count;
+}
 
-      //Insert page into hashtable
-      hashTable->insert(file,pageNo,tmp);
+/*
+ * Function Name: mayMatch
+ * Input: File pointer, constant PageId, predicate and zone map
+ * Output: False if the page cannot hold a matching record
+ * Purpose: Decide whether a filtered scan can skip a page without reading it
+ */
+bool BufMgr::mayMatch(File* file, const PageId pageNo, const RecordPredicate& predicate, const ZoneMap& zoneMap)
+{
+  BufShard& shard = shardOf(file, pageNo);
+  const bool concurrent = tableType == PageTableType::LOCK_FREE;
+  std::unique_lock<std::recursive_mutex> lock(shard.mutex, std::defer_lock);
+  if (!concurrent)
+    lock.lock();
+  Epoch::Guard guard(concurrent);
+  // A page in the pool may have changed since its summary was taken; pages
+  // leave the hash table only once written back and summarized
+  FrameId frameNo;
+  if (shard.table()->find(file, pageNo, frameNo)) {
+    return true;
+  }
+  return zoneMap.mayMatch(pageNo, predicate);
+}
 
-      // invoke Set() on the frame to set it up properly
-      bufDescTable[tmp].Set(file,pageNo);
-      // Return a pointer to the frame containing the page via page param
-      page = &bufPool[tmp];
+/*
+ * Function Name: setWriteBackHook
+ * Input: File pointer and hook
+ * Output: None
+ * Purpose: Register the function run on the file's pages as they are written back
+ */
+void BufMgr::setWriteBackHook(const File* file, const WriteBackHook& hook)
+{
+  std::lock_guard<std::mutex> lock(hookMutex);
+  if (hook) {
+    writeBackHooks[file] = hook;
+  } else {
+    writeBackHooks.erase(file);
   }
 }
 
 /*
  * Function Name: unPinPage
- * Input: File pointer, constant PageID and constant bool
+ * Input: File pointer, constant PageID, constant bool and latch mode
  i* Output: None
- * Purpose: Decrement pinCnt of of the input and set the dirty bit
+ * Purpose: Release the page's latch, decrement pinCnt of of the input and
+ * set the dirty bit
  */
-void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty)
+void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty, const LatchMode mode)
 {
+  if (unPinCached(file, pageNo, dirty, mode)) {
+    return;
+  }
+  BufShard& shard = shardOf(file, pageNo);
+  std::lock_guard<std::recursive_mutex> lock(shard.mutex);
   FrameId tmp;
 
   try{
    //Lookup file and page number
-   hashTable->lookup(file, pageNo, tmp);
+   shard.table()->lookup(file, pageNo, tmp);
 
    // Throw exception if pinCnt is already 0
-   if(bufDescTable[tmp].pinCnt == 0){
+   if(descOf(tmp).pinCnt == 0){
      throw PageNotPinnedException("PinCnt already 0",pageNo,tmp);
    }
 
+   // Release the latch before the pin, which keeps the frame assigned
+   descOf(tmp).latch.unlock(mode);
+
    // Decrement pin count
-   bufDescTable[tmp].pinCnt--;
+   descOf(tmp).unpin();
 
    // This check is for the test cases
    if(dirty == true){
-    bufDescTable[tmp].dirty = true;
+    descOf(tmp).dirty = true;
    }
   }
 
@@ -241,44 +1103,77 @@ void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty)
   catch(HashNotFoundException e){}
 }
 
+/*
+ * Function Name: upgradeLatch
+ * Input: File pointer and constant PageID
+ * Output: None
+ * Purpose: Turn the caller's upgradable latch on a pinned page into an
+ * exclusive one
+ */
+void BufMgr::upgradeLatch(File* file, const PageId pageNo)
+{
+  FrameId tmp;
+  {
+    BufShard& shard = shardOf(file, pageNo);
+    std::lock_guard<std::recursive_mutex> lock(shard.mutex);
+    if (!shard.table()->find(file, pageNo, tmp)) {
+      throw PageNotPinnedException(file->filename(), pageNo);
+    }
+    if (descOf(tmp).pinCnt == 0) {
+      throw PageNotPinnedException(file->filename(), pageNo, tmp);
+    }
+  }
+  // Readers being waited for need the shard mutex to unpin
+  descOf(tmp).latch.upgrade();
+}
+
 /*
  * Function Name: flushFile
  * Input: File pointer
  * Output: None
  * Purpose:Flushes all pages belonging to the file, remove the pages from the
- * hashTable and clear the corresponding bufDescs
+ * shards' hashTables and clear the corresponding bufDescs
  */
 void BufMgr::flushFile(const File* file)
 {
-  // Scan bufPool
-  for(unsigned int i = 0; i < numBufs; i++){
-  // checks if page corresponds to file and is valid
-  if(bufDescTable[i].file == file && bufDescTable[i].valid == true){
-   // Throws exception if page already pinned
-   if(bufDescTable[i].pinCnt > 0) {
-       throw PagePinnedException("Page is pinned", bufDescTable[i].pageNo, bufDescTable[i].frameNo);
+  // Scan every shard's frames
+  for (std::uint32_t s = 0; s < numShards; s++) {
+  BufShard& shard = shards[s];
+  std::lock_guard<std::recursive_mutex> lock(shard.mutex);
+  for(std::size_t f = 0; f < shard.frames.size(); f++){
+  BufDesc& desc = descOf(shard.frames[f]);
+  // Only frames assigned to this file are of interest
+  if(desc.file != file){
+    continue;
+  }
+
+  // A frame assigned to the file must hold a valid page
+  if(desc.valid == false){
+      throw BadBufferException(desc.frameNo, desc.dirty, desc.valid, desc.refbit());
+  }
+
+   // Throws exception if page already pinned; otherwise keeps frame caches off it
+   if(!desc.claimUnpinned()) {
+       throw PagePinnedException("Page is pinned", desc.pageNo, desc.frameNo);
    }
 
    // Check if dirty bit is true
-   if (bufDescTable[i].dirty == true){
-    //Flush page to disk
-    bufDescTable[i].file->writePage(bufPool[bufDescTable[i].frameNo]);
+   if (desc.dirty == true){
+    //Flush page to disk; File stamps the page checksum on the way out
+    writeBack(desc.frameNo);
 
     //Reset dirty bit
-    bufDescTable[i].dirty = false;
+    desc.dirty = false;
    }
 
     //Remove page from hashtable
-    hashTable->remove(file,bufDescTable[i].pageNo);
-
-    //Invoke clear() to clear page frame
-    bufDescTable[i].Clear();
+    shard.table()->remove(file,desc.pageNo);
 
+    //Invoke clear() to clear page frame and give it back to the shard
+    desc.Clear();
+    shard.freeFrames.push_back(desc.frameNo);
   }
-  else{
-      throw BadBufferException(bufDescTable[i].frameNo, bufDescTable[i].dirty, bufDescTable[i].valid, bufDescTable[i].refbit);
   }
- }
 }
 
 /*
@@ -294,20 +1189,65 @@ void BufMgr::flushFile(const File* file)
 // InvalidRecordException thrown during main
 void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page) 
 {
+  if (file->page_size() != pageSize) {
+    throw InvalidPageSizeException(file->page_size(), pageSize, file->filename());
+  }
+
   FrameId frameNo;
   // Allocate an empty page in the specified file which returns a newly allocated page
   Page currentPage = file->allocatePage();
+  // The page number picks the shard
+  BufShard& shard = shardOf(file, currentPage.page_number());
+  std::lock_guard<std::recursive_mutex> lock(shard.mutex);
+  shard.stats.accesses++;
+  shard.stats.diskreads++;
   // Obtain a buffer pool frame
-  allocBuf(frameNo);
-  bufPool[frameNo] = currentPage;
+  allocBuf(shard, frameNo);
+  *pageOf(frameNo) = currentPage;
   // Entry is inserted into the hash table
-  hashTable->insert(file, currentPage.page_number(), frameNo);
+  shard.table()->insert(file, currentPage.page_number(), frameNo);
   //Call Set() on the frame
-  bufDescTable[frameNo].Set(file, currentPage.page_number());
+  descOf(frameNo).Set(file, currentPage.page_number());
+  if (!references(ReadHint::NORMAL)) {
+    descOf(frameNo).setRefbit(false);
+  }
   // return both page number of newly allocated page to the caller via the pageNo param
   // and a pointer to the buffer frame allocated for the page via page param
   pageNo = currentPage.page_number();
-  page = &bufPool[frameNo];
+  page = pageOf(frameNo);
+}
+
+/*
+ * Function Name: loadRecords
+ * Input: File pointer, batch of records and optional vector for record ids
+ * Output: Number of pages allocated
+ * Purpose: Bulk loads records into newly allocated pages, packing each page
+ *          with Page::insertRecords before moving on to the next one
+ */
+std::uint32_t BufMgr::loadRecords(File* file, const std::vector<std::string>& records,
+                                  std::vector<RecordId>* recordIds)
+{
+  std::uint32_t numPages = 0;
+  std::size_t next = 0;
+  while (next < records.size()) {
+    PageId pageNo;
+    Page* page;
+    allocPage(file, pageNo, page);
+    numPages++;
+
+    const std::size_t inserted = page->insertRecords(records, next, recordIds);
+    if (inserted == 0) {
+      // Record is too large for an empty page; give the page back to the file
+      std::size_t available = page->getFreeSpace();
+      unPinPage(file, pageNo, false);
+      disposePage(file, pageNo);
+      throw InsufficientSpaceException(pageNo, records[next].length(), available);
+    }
+    next += inserted;
+
+    unPinPage(file, pageNo, true);
+  }
+  return numPages;
 }
 
 /*
@@ -316,19 +1256,26 @@ void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page)
  * Output: None
  * Purpose: Deletes a page from file.
  * If the page is in the buffer, clear page from buffer and remove
- * from hashTable
+ * from its shard's hashTable
  */
 void BufMgr::disposePage(File* file, const PageId PageNo)
 {
+  BufShard& shard = shardOf(file, PageNo);
+  std::unique_lock<std::recursive_mutex> lock(shard.mutex);
     FrameId tmp;
+    // A page being read in is disposed of once the read is over
+    while (shard.table()->find(file, PageNo, tmp) && descOf(tmp).ioInProgress) {
+        shard.ioDone.wait(lock);
+    }
     // This method deletes a particular page from file.
     try {
-        hashTable->lookup(file, PageNo, tmp);
+        shard.table()->lookup(file, PageNo, tmp);
         // Make sure that if the page to be deleted is allocated to a frame in the buffer
         // pool, that frame is freed and correspondingly entry from hash table is also
         // removed
-        bufDescTable[tmp].Clear();
-        hashTable->remove(file, PageNo);
+        descOf(tmp).Clear();
+        shard.freeFrames.push_back(tmp);
+        shard.table()->remove(file, PageNo);
     } catch(HashNotFoundException e) {}
 
     // After checks, delete page from the file
@@ -339,18 +1286,22 @@ void BufMgr::disposePage(File* file, const PageId PageNo)
  * Function Name: printSelf
  * Input: void
  * Output: void
- * Purpose: Prints out the total number of valid frames in bufDescTable
- * Iterates through bufDescTable and counts the number of frames whose valid
+ * Purpose: Prints out the total number of valid frames in the pool
+ * Iterates through the frames and counts the number of frames whose valid
  * bit is set to true. Then it prints that counted value.
  */
 void BufMgr::printSelf(void) 
 {
+  AllShardsLock lock(shards, numShards);
   BufDesc* tmpbuf;
 	int validFrames = 0;
   
-  for (std::uint32_t i = 0; i < numBufs; i++)
+  for (FrameId i = 0; i < frameLimit; i++)
 	{
-  	tmpbuf = &(bufDescTable[i]);
+    // Released frames are no longer part of the pool
+    if (pageOf(i) == NULL)
+      continue;
+  	tmpbuf = &(descOf(i));
 		std::cout << "FrameNo:" << i << " ";
 		tmpbuf->Print();
 
@@ -361,4 +1312,83 @@ void BufMgr::printSelf(void)
 	std::cout << "Total Number of Valid Frames:" << validFrames << "\n";
 }
 
+/*
+ * Function Name: getBufStats
+ * Input: None
+ * Output: Statistics of the whole pool
+ * Purpose: Sum up the usage statistics of every shard
+ */
+BufStats BufMgr::getBufStats()
+{
+  BufStats total;
+  for (std::uint32_t s = 0; s < numShards; s++) {
+    const BufStats shardStats = getShardStats(s);
+    total.accesses += shardStats.accesses;
+    total.diskreads += shardStats.diskreads;
+    total.diskwrites += shardStats.diskwrites;
+  }
+  return total;
+}
+
+/*
+ * Function Name: getPageTableStats
+ * Input: None
+ * Output: Statistics of every shard's page table
+ * Purpose: Report how full the page tables are and how long their chains
+ */
+PageTableStats BufMgr::getPageTableStats()
+{
+  PageTableStats total;
+  for (std::uint32_t s = 0; s < numShards; s++) {
+    std::lock_guard<std::recursive_mutex> lock(shards[s].mutex);
+    const PageTableStats tableStats = shards[s].table()->getStats();
+    total.entries += tableStats.entries;
+    total.buckets += tableStats.buckets;
+    total.pendingBuckets += tableStats.pendingBuckets;
+    total.totalProbes += tableStats.totalProbes;
+    total.longestProbe = std::max(total.longestProbe, tableStats.longestProbe);
+  }
+  return total;
+}
+
+/*
+ * Function Name: getFrameBacking
+ * Input: None
+ * Output: Kind of memory backing the frames
+ * Purpose: Report whether the frames got huge pages
+ */
+ArenaBacking BufMgr::getFrameBacking() const
+{
+  return frameArena == NULL ? ArenaBacking::HEAP : frameArena->backing();
+}
+
+/*
+ * Function Name: getShardStats
+ * Input: Index of a shard
+ * Output: Statistics of the shard
+ * Purpose: Report the usage statistics of one shard
+ */
+BufStats BufMgr::getShardStats(const std::uint32_t shard)
+{
+  std::lock_guard<std::recursive_mutex> lock(shards[shard].mutex);
+  BufStats stats = shards[shard].stats;
+  stats.accesses += shards[shard].cachedAccesses;
+  return stats;
+}
+
+/*
+ * Function Name: clearBufStats
+ * Input: None
+ * Output: None
+ * Purpose: Clear the usage statistics of every shard
+ */
+void BufMgr::clearBufStats()
+{
+  for (std::uint32_t s = 0; s < numShards; s++) {
+    std::lock_guard<std::recursive_mutex> lock(shards[s].mutex);
+    shards[s].stats.clear();
+    shards[s].cachedAccesses = 0;
+  }
+}
+
 }
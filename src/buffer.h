@@ -7,8 +7,18 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <vector>
 #include "file.h"
 #include "bufHashTbl.h"
+#include "frame_arena.h"
+#include "latch.h"
 
 namespace badgerdb {
 
@@ -17,12 +27,83 @@ namespace badgerdb {
 */
 class BufMgr;
 
+/**
+* forward declaration of ScanIterator class
+*/
+class ScanIterator;
+
+/**
+* forward declaration of EventLoop class
+*/
+class EventLoop;
+
+/**
+* forward declaration of RecordPredicate class
+*/
+class RecordPredicate;
+
+/**
+* forward declaration of ZoneMap class
+*/
+class ZoneMap;
+
+/**
+* @brief How a page being read is expected to be used, which decides how readily the clock replaces it
+*/
+enum class ReadHint {
+	/**
+	 * The page may be read again soon; its refbit is set so the clock passes over it once
+	 */
+	NORMAL,
+
+	/**
+	 * The page is read once, as by a sample or a large scan. Its refbit is left clear, and the next page read once
+	 * reuses its frame if it is unpinned by then, so a long run of such reads cycles through one frame instead of
+	 * pushing the pages other readers use out of the pool
+	 */
+	ONCE
+};
+
+/**
+* @brief Kind of table each shard of a buffer pool keeps its pages in
+*/
+enum class PageTableType {
+	/**
+	 * BufHashTbl, read and changed under the shard's mutex
+	 */
+	CHAINED,
+
+	/**
+	 * LockFreeBufHashTbl. Changes still take the shard's mutex, but checks for whether a page is buffered, such as
+	 * prefetchPage() and the zone map checks of filterFile(), do not wait for it
+	 */
+	LOCK_FREE
+};
+
+/**
+* @brief How a buffer pool picks the pages to replace
+*/
+enum class ReplacementPolicy {
+	/**
+	 * The clock, with pages read normally passed over once for every time they are used (see ReadHint)
+	 */
+	CLOCK,
+
+	/**
+	 * The clock without refbits: neither reading nor allocating a page sets its refbit, so the clock replaces the
+	 * unpinned pages of all frames about in the order they came in, and a pool of N frames keeps the last N pages
+	 * read. For pools holding files that are rarely re-read, such as logs and tables that are only scanned
+	 */
+	RECYCLE
+};
+
 /**
 * @brief Class for maintaining information about buffer pool frames
 */
 class BufDesc {
 
 	friend class BufMgr;
+	friend struct FrameSegment;
 
  private:
 	/**
@@ -41,14 +122,16 @@ class BufDesc {
   FrameId	frameNo;
 
 	/**
-   * Number of times this page has been pinned
+   * Number of times this page has been pinned, or -1 while the frame holds no page or is being cleared. Pins are
+   * taken under the shard's mutex except through the frame caches (see BufMgr::setFrameCache()), which only pin a
+   * nonnegative count
 	 */
-  int pinCnt;
+  std::atomic<int> pinCnt;
 
 	/**
    * True if page is dirty;  false otherwise
 	 */
-  bool dirty;
+  std::atomic<bool> dirty;
 
 	/**
    * True if page is valid
@@ -56,23 +139,110 @@ class BufDesc {
   bool valid;
 
 	/**
-   * Has this buffer frame been reference recently
+   * Word of the frame's block holding its refbit (see FrameSegment::refBits)
+	 */
+  std::atomic<std::uint64_t>* refWord;
+
+	/**
+   * Word of the frame's block holding its pinned bit (see FrameSegment::pinnedBits)
+	 */
+  std::atomic<std::uint64_t>* pinnedWord;
+
+	/**
+   * The frame's bit in refWord and pinnedWord
+	 */
+  std::uint64_t bit;
+
+	/**
+   * Number of times the frame has been cleared. A frame cache entry stamped with the current value still names the
+   * page in the frame
+	 */
+  std::atomic<std::uint64_t> generation;
+
+	/**
+   * Latch held by threads that pinned the page for shared, upgradable or exclusive access. Only taken while the
+   * page is pinned, so it is free whenever the frame is cleared or reassigned
 	 */
-  bool refbit;
+  RWLatch latch;
+
+	/**
+   * True while the page is being read into the frame by the thread that missed on it. The frame is in the hash
+   * table and pinned by that thread; others that find it pin it too and wait on their shard's ioDone. Changed only
+   * under the shard's mutex, but read without it by lookups on a lock-free table
+	 */
+  std::atomic<bool> ioInProgress;
 
 	/**
    * Initialize buffer frame for a new user
 	 */
   void Clear()
 	{
-    pinCnt = 0;
+    // Invalidates frame cache entries before the frame can be pinned again
+    generation++;
+    ioInProgress = false;
 		file = NULL;
 		pageNo = Page::INVALID_NUMBER;
     dirty = false;
-    refbit = false;
+    setRefbit(false);
 		valid = false;
+    // Not pinnable until Set() assigns the frame a page
+    pinCnt = -1;
+    pinnedWord->fetch_or(bit);
   };
 
+	/**
+	 * Returns true if the page in the frame was used since the clock last passed over it
+	 */
+  bool refbit() const
+	{
+    return (refWord->load() & bit) != 0;
+  }
+
+	/**
+	 * Sets or clears the frame's refbit. Setting a bit already set only reads the word, which the refbits of 63
+	 * other frames share
+	 *
+	 * @param ref	New value of the refbit
+	 */
+  void setRefbit(const bool ref)
+	{
+    if (ref == refbit())
+      return;
+    if (ref)
+      refWord->fetch_or(bit);
+    else
+      refWord->fetch_and(~bit);
+  }
+
+	/**
+	 * Adds a pin to a frame holding a page, marking the frame pinned if it was not
+	 */
+  void pin()
+	{
+    if (pinCnt++ == 0)
+      pinnedWord->fetch_or(bit);
+  }
+
+	/**
+	 * Drops a pin, marking the frame evictable once the last pin is gone
+	 */
+  void unpin()
+	{
+    if (--pinCnt == 0)
+      pinnedWord->fetch_and(~bit);
+  }
+
+	/**
+	 * Marks an unpinned frame as being cleared, so that frame caches stop pinning it
+	 *
+	 * @return	False if the frame is pinned
+	 */
+  bool claimUnpinned()
+	{
+    int unpinned = 0;
+    return pinCnt.compare_exchange_strong(unpinned, -1);
+  }
+
 	/**
 	 * Set values of member variables corresponding to assignment of frame to a page in the file. Called when a frame 
 	 * in buffer pool is allocated to any page in the file through readPage() or allocPage()
@@ -84,10 +254,11 @@ class BufDesc {
 	{ 
 		file = filePtr;
     pageNo = pageNum;
+    // Cleared frames are marked pinned already
     pinCnt = 1;
     dirty = false;
     valid = true;
-    refbit = true;
+    setRefbit(true);
   }
 
   void Print()
@@ -103,7 +274,7 @@ class BufDesc {
 		std::cout << "valid:" << valid << " ";
 		std::cout << "pinCnt:" << pinCnt << " ";
 		std::cout << "dirty:" << dirty << " ";
-		std::cout << "refbit:" << refbit << "\n";
+		std::cout << "refbit:" << refbit() << "\n";
   }
 
 	/**
@@ -111,7 +282,10 @@ class BufDesc {
 	 */
   BufDesc()
 	{
-  	Clear();
+    generation = 0;
+    // The block the frame is part of gives it its bits, then clears it
+    refWord = pinnedWord = NULL;
+    bit = 0;
   }
 };
 
@@ -154,60 +328,507 @@ struct BufStats
 };
 
 
+/**
+* @brief Frames of a shard whose refbits and pinned bits share a word (see FrameSegment)
+*/
+struct ClockWord
+{
+	/**
+   * Index of the word: frame number divided by 64
+	 */
+  std::uint32_t word;
+
+	/**
+   * Bit b is set if frame word * 64 + b belongs to the shard
+	 */
+  std::uint64_t owned;
+};
+
+
+/**
+* @brief Share of a buffer pool's frames, managed apart from the rest of the pool
+*
+* Every page is looked up in, read into and evicted from the shard its file and page number hash to, so threads
+* using pages of different shards do not wait for each other.
+*/
+struct BufShard
+{
+	/**
+   * Serializes the operations on the shard. Recursive because some operations are built out of others. Not held
+   * while a page is read from disk
+	 */
+  std::recursive_mutex mutex;
+
+	/**
+   * Signaled whenever a read of a page into one of the shard's frames ends, successfully or not
+	 */
+  std::condition_variable_any ioDone;
+
+	/**
+   * Entries of a chained hashTable, at least one per frame of the shard, so that reading a page into a frame never
+   * allocates memory. A shard stealing a frame takes a node with it
+	 */
+  NodePool<hashBucket> nodes;
+
+	/**
+   * Table mapping (File, page) to frame, for the pages held by this shard. A chained table resizes itself as pages
+   * come and go; a lock-free one is replaced by a larger one as the shard gains frames (see BufMgr::resize()), so
+   * lookups made without the mutex load it inside an Epoch::Guard
+	 */
+  std::atomic<PageTable*> hashTable;
+
+	/**
+   * Number of buckets hashTable was made with
+	 */
+  int tableSize;
+
+	/**
+   * Frames owned by the shard. Frames move between shards only when one steals from another, and are added and
+   * taken away by BufMgr::resize()
+	 */
+  std::vector<FrameId> frames;
+
+	/**
+   * The owned frames grouped by word of the pool's refbits and pinned bits, in frame number order; the shard's
+   * clock sweeps them a word at a time
+	 */
+  std::vector<ClockWord> clockWords;
+
+	/**
+   * Current position of the clock hand: the entry of clockWords it is at, and the bit of that word it sweeps next
+	 */
+  std::uint32_t clockWord;
+  std::uint32_t clockBit;
+
+	/**
+   * Owned frames holding no page, taken before the clock is run. Exactly the owned frames that are not valid.
+   * Always has room for every frame of the shard, so giving a frame back never allocates memory
+	 */
+  std::vector<FrameId> freeFrames;
+
+	/**
+   * Usage statistics of the shard
+	 */
+  BufStats stats;
+
+	/**
+   * Accesses to the shard's pages made through frame caches, without the mutex; reported as part of stats
+	 */
+  std::atomic<int> cachedAccesses;
+
+	/**
+   * Frame of the shard last filled by a read with ReadHint::ONCE, or an invalid frame number if none
+	 */
+  FrameId onceFrame;
+
+	/**
+   * Frames the shard still has to give up because the pool was shrunk while they were pinned. They are released
+   * as they are evicted, when the shard next needs a frame
+	 */
+  std::uint32_t excessFrames;
+
+	/**
+   * Returns the shard's current page table
+	 */
+  PageTable* table() const
+  {
+		return hashTable.load();
+  }
+};
+
+
+/**
+* @brief Block of buffer pool frames, allocated as the pool grows
+*
+* Blocks are only freed with the pool, so a frame's BufDesc can be looked at without the shard's mutex even after
+* the frame has been released. A released frame's page is freed, and its slot in pages is null.
+*
+* The state the clock looks at is kept apart from the descriptors, one bit per frame, so that a sweep reads the
+* state of 64 frames from one word instead of a descriptor per frame.
+*/
+struct FrameSegment
+{
+	/**
+   * Number of frames in a block
+	 */
+  static const std::uint32_t FRAMES = 512;
+
+	/**
+   * Number of words of each bitmap in a block
+	 */
+  static const std::uint32_t WORDS = FRAMES / 64;
+
+	/**
+   * Refbits of the frames: bit b of word w is set if the page in frame w * 64 + b of the block was used since the
+   * clock last passed over it
+	 */
+  std::atomic<std::uint64_t> refBits[WORDS];
+
+	/**
+   * Pinned bits of the frames, set while a frame is pinned or holds no page. Updated after the pin count, so a
+   * bit can briefly lag behind it; the clock claims a frame through its pin count before evicting it
+	 */
+  std::atomic<std::uint64_t> pinnedBits[WORDS];
+
+	/**
+   * Descriptors of the frames
+	 */
+  BufDesc descs[FRAMES];
+
+	/**
+   * Pages of the frames, or null for released frames
+	 */
+  std::atomic<Page*> pages[FRAMES];
+
+	/**
+   * Constructor of FrameSegment class
+   *
+   * @param first	Frame number of the first frame of the block
+	 */
+  explicit FrameSegment(const FrameId first)
+	{
+    for (std::uint32_t w = 0; w < WORDS; w++) {
+      refBits[w] = 0;
+      pinnedBits[w] = 0;
+    }
+    for (std::uint32_t i = 0; i < FRAMES; i++) {
+      descs[i].frameNo = first + i;
+      descs[i].refWord = &refBits[i / 64];
+      descs[i].pinnedWord = &pinnedBits[i / 64];
+      descs[i].bit = std::uint64_t(1) << (i % 64);
+      descs[i].Clear();
+      pages[i] = NULL;
+    }
+  }
+};
+
+
 /**
 * @brief The central class which manages the buffer pool including frame allocation and deallocation to pages in the file 
+*
+* The frames are split into shards (see BufShard), each with its own mutex, hash table, clock, free list and
+* statistics, so one pool can be shared by several threads.
 */
 class BufMgr 
 {
+ public:
+	/**
+   * Function run on a page of a file right after the pool writes it back to the file
+	 */
+  typedef std::function<void(const Page&)> WriteBackHook;
+
+	/**
+   * Function told the outcome of readPageAsync(): the pinned page, or a null page and the exception reading it
+   * threw
+	 */
+  typedef std::function<void(Page* page, std::exception_ptr error)> ReadCallback;
+
  private:
 	/**
-   * Current position of clockhand in our buffer pool
+   * Number of frames the buffer pool is sized to. Shards that could not give up pinned frames when the pool was
+   * shrunk hold more until they release them (see BufShard::excessFrames)
 	 */
-  FrameId clockHand;
+  std::atomic<std::uint32_t> numBufs;
 
 	/**
-   * Number of frames in the buffer pool
+   * Size in bytes of every frame in the buffer pool. Only files with this page size can be read through this pool
 	 */
-  std::uint32_t numBufs;
-	
+  std::size_t pageSize;
+
+	/**
+   * Blocks of frames, indexed by frame number divided by FrameSegment::FRAMES. Entries past the last block in use
+   * are null
+	 */
+  FrameSegment **segments;
+
+	/**
+   * Number of frame numbers handed out so far
+	 */
+  FrameId frameLimit;
+
+	/**
+   * Frame numbers given up by shrinking the pool, reused first when it grows
+	 */
+  std::vector<FrameId> releasedFrames;
+
+	/**
+   * Guards frameLimit and releasedFrames
+	 */
+  std::mutex releasedMutex;
+
+	/**
+   * Arena holding the data of every frame, or NULL if each frame allocates its own
+	 */
+  FrameArena *frameArena;
+
+	/**
+   * Kind of table the shards keep their pages in
+	 */
+  PageTableType tableType;
+
+	/**
+   * Shards the frames are split into
+	 */
+  BufShard *shards;
+
+	/**
+   * Number of shards
+	 */
+  std::uint32_t numShards;
+
 	/**
-   * Hash table mapping (File, page) to frame
+   * Guards writeBackHooks
 	 */
-  BufHashTbl *hashTable;
+  std::mutex hookMutex;
 
 	/**
-   * Array of BufDesc objects to hold information corresponding to every frame allocation from 'bufPool' (the buffer pool)
+   * Write-back hooks of the files that have one
 	 */
-  BufDesc *bufDescTable;
+  std::map<const File*, WriteBackHook> writeBackHooks;
 
 	/**
-   * Maintains Buffer pool usage statistics 
+   * Number telling this pool apart from every other in frame cache entries
 	 */
-  BufStats bufStats;
+  const std::uint64_t poolId;
 
 	/**
-   * Advance clock to next frame in the buffer pool
+   * Whether readPage() and unPinPage() go through the calling thread's frame cache
 	 */
-  void advanceClock();
+  std::atomic<bool> frameCache;
 
 	/**
-	 * Allocate a free frame.  
+   * Replacement policy, set with setReplacementPolicy()
+	 */
+  std::atomic<ReplacementPolicy> policy;
+
+	/**
+	 * Returns whether a use of a page with the given hint sets its refbit under the pool's replacement policy
+	 *
+	 * @param hint  	Hint the page is used with
+	 */
+  bool references(const ReadHint hint) const
+  {
+		return hint == ReadHint::NORMAL && policy != ReplacementPolicy::RECYCLE;
+  }
+
+	/**
+	 * Pins a page through the calling thread's frame cache, without the shard's mutex or hash table. Fails if the
+	 * cache is off, has no entry for the page, or the frame has been cleared or is being cleared since the entry was
+	 * made.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @param hint  	How the page is expected to be used; only ReadHint::NORMAL reads use the cache
+	 * @param frame   	Frame reference, frame ID of the pinned page returned via this variable
+	 * @return 			True if the page was pinned
+	 */
+  bool pinCached(File* file, const PageId pageNo, const ReadHint hint, FrameId & frame);
+
+	/**
+	 * Records a page the calling thread has pinned in its frame cache, if the cache is on.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @param hint  	How the page was read
+	 * @param frame   	Frame the page is pinned in
+	 */
+  void cacheFrame(File* file, const PageId pageNo, const ReadHint hint, const FrameId frame);
+
+	/**
+	 * Unpins a page the calling thread has pinned, found through its frame cache instead of the hash table.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @param dirty		True if the page needs to be marked dirty
+	 * @param mode		Access the page was latched for
+	 * @return 			False if the cache is off or has no entry for the page
+	 */
+  bool unPinCached(File* file, const PageId pageNo, const bool dirty, const LatchMode mode);
+
+	/**
+   * Returns the descriptor of a frame
+	 */
+  BufDesc& descOf(const FrameId frame)
+  {
+		return segments[frame / FrameSegment::FRAMES]->descs[frame % FrameSegment::FRAMES];
+  }
+
+	/**
+   * Returns the page of a frame, or NULL if the frame has been released
+	 */
+  Page* pageOf(const FrameId frame)
+  {
+		return segments[frame / FrameSegment::FRAMES]->pages[frame % FrameSegment::FRAMES].load();
+  }
+
+	/**
+   * Returns the block holding the given word of refbits and pinned bits
+	 */
+  FrameSegment& segmentOfWord(const std::uint32_t word)
+  {
+		return *segments[word / FrameSegment::WORDS];
+  }
+
+	/**
+	 * Makes a frame with an empty page, reusing a released frame number if there is one. The frame belongs to no
+	 * shard yet.
+	 *
+	 * @return 			Number of the new frame
+	 */
+  FrameId newFrame();
+
+	/**
+	 * Adds a frame to the shard's frames and clock. The shard's mutex must be held.
+	 *
+	 * @param shard   	Shard taking the frame
+	 * @param frame   	Frame to add
+	 */
+  void attachFrame(BufShard& shard, const FrameId frame);
+
+	/**
+	 * Takes a frame out of the shard's frames and clock. The frame must be cleared and off the free list, and the
+	 * shard's mutex held.
+	 *
+	 * @param shard   	Shard owning the frame
+	 * @param frame   	Frame to take out
+	 */
+  void detachFrame(BufShard& shard, const FrameId frame);
+
+	/**
+	 * Takes a cleared frame out of the shard for good. Its page is returned rather than freed, since lookups without
+	 * the shard's mutex may still be looking at it; the caller frees it after Epoch::synchronize().
 	 *
+	 * @param shard   	Shard owning the frame, whose mutex is held
+	 * @param frame   	Frame to release
+	 * @return 			Page of the frame
+	 */
+  Page* releaseFrame(BufShard& shard, const FrameId frame);
+
+	/**
+	 * Replaces the shard's page table with one sized for its current frames. The shard's mutex must be held.
+	 *
+	 * @param shard   	Shard whose table is replaced
+	 */
+  void growTable(BufShard& shard);
+
+	/**
+	 * Makes an empty page table of the pool's kind for the shard.
+	 *
+	 * @param shard   	Shard the table is for, whose nodes a chained table uses
+	 * @param size   	Number of buckets
+	 */
+  PageTable* newPageTable(BufShard& shard, const int size);
+
+	/**
+   * Returns the shard holding the given page, if it is in the pool
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @return 			Shard the page hashes to
+	 */
+  BufShard& shardOf(const File* file, const PageId pageNo);
+
+	/**
+	 * Finds an unpinned frame of the shard with its clock and claims it (see BufDesc::claimUnpinned()). The clock
+	 * reads a word of refbits and pinned bits for every 64 frames it passes, clearing the refbits of the frames it
+	 * passes over, and goes to the descriptor only of the frame it picks. The shard's mutex must be held and its
+	 * free list empty.
+	 *
+	 * @param shard   	Shard whose clock is run
+	 * @param frame   	Frame reference, frame ID of the claimed frame returned via this variable
+	 * @return 			False if every frame of the shard is pinned
+	 */
+  bool sweepClock(BufShard& shard, FrameId & frame);
+
+	/**
+	 * Allocate a free frame to the shard, from its free list, with its clock or, if all its frames are pinned, by
+	 * stealing one from another shard. The shard's mutex must be held.
+	 *
+	 * @param shard   	Shard needing a frame
 	 * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
 	 * @throws BufferExceededException If no such buffer is found which can be allocated
 	 */
-  void allocBuf(FrameId & frame);
+  void allocBuf(BufShard& shard, FrameId & frame);
+
+	/**
+	 * Takes a frame owned by the shard from its free list or, running its clock, from an unpinned page, which is
+	 * written back if dirty. The shard's mutex must be held.
+	 *
+	 * @param shard   	Shard to take the frame from
+	 * @param frame   	Frame reference, frame ID of the cleared frame returned via this variable
+	 * @return 			False if every frame of the shard is pinned
+	 */
+  bool evictFrame(BufShard& shard, FrameId & frame);
+
+	/**
+	 * Moves a frame from another shard to the given one. Other shards are only tried if their mutex is free, so
+	 * two shards stealing from each other cannot deadlock.
+	 *
+	 * @param thief   	Shard taking the frame, whose mutex is held
+	 * @param frame   	Frame reference, frame ID of the cleared frame returned via this variable
+	 * @return 			False if no other shard could give up a frame
+	 */
+  bool stealFrame(BufShard& thief, FrameId & frame);
+
+	/**
+	 * Takes back the frame of the shard's last page read with ReadHint::ONCE for another such read, if that page is
+	 * unpinned and has not been read normally since.
+	 *
+	 * @param shard   	Shard the page being read belongs to
+	 * @param frame   	Frame reference, frame ID of the frame taken returned via this variable
+	 * @return 			True if the frame was taken; otherwise a frame has to come from allocBuf()
+	 */
+  bool reuseOnceFrame(BufShard& shard, FrameId & frame);
+
+	/**
+	 * Drops a pin on a frame whose page could not be read, returning the frame to the shard's free list once no
+	 * thread waiting on the read still pins it. The shard's mutex must be held.
+	 *
+	 * @param shard   	Shard owning the frame
+	 * @param frameNo 	Frame the read failed into
+	 */
+  void releaseFailedFrame(BufShard& shard, const FrameId frameNo);
+
+	/**
+	 * Pins the given page, reading it into a frame first if it is not in the buffer pool. The first half of
+	 * readPage(). The disk is read without the shard mutex: the frame is published with its read in progress
+	 * first, and threads missing on the same page meanwhile wait for that read instead of starting their own.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @param hint  	How the page is expected to be used
+	 * @param frame   	Frame reference, frame ID of the frame holding the page returned via this variable
+	 * @throws InvalidPageSizeException If the file's page size differs from this pool's frame size
+	 */
+  void pinPage(File* file, const PageId PageNo, const ReadHint hint, FrameId & frame);
+
+	/**
+	 * Writes the page in a frame back to its file and runs the file's write-back hook, if any.
+	 *
+	 * @param frameNo	Number of the frame holding the page
+	 */
+  void writeBack(const FrameId frameNo);
 
  public:
 	/**
-   * Actual buffer pool from which frames are allocated
+   * Largest number of frames a buffer pool can have
 	 */
-  Page* bufPool;
+  static const std::uint32_t MAX_FRAMES = FrameSegment::FRAMES * 16384;
 
 	/**
    * Constructor of BufMgr class
+	 *
+	 * @param bufs			Number of frames in the buffer pool, at most MAX_FRAMES
+	 * @param pageSize	Size in bytes of every frame. Files with a different page size need a pool of their own
+	 * @param shards		Number of shards to split the frames into, at most bufs. More shards let more threads find and
+	 *                read pages at once, but a shard whose frames are all pinned has to steal from the others
+	 * @param tableType	Kind of table the shards keep their pages in
+	 * @param hugePages	Whether to keep the frames' data in one arena backed by huge pages, where the system has them,
+	 *                so that fewer TLB entries cover the pool. See getFrameBacking() for what was got
+	 * @throws InvalidPageSizeException If pageSize is not a supported page size
 	 */
-  BufMgr(std::uint32_t bufs);
+  BufMgr(std::uint32_t bufs, std::size_t pageSize = Page::SIZE, std::uint32_t shards = 1,
+         PageTableType tableType = PageTableType::CHAINED, bool hugePages = false);
 	
 	/**
    * Destructor of BufMgr class
@@ -219,11 +840,124 @@ class BufMgr
 	 * If the requested page is already present in the buffer pool pointer to that frame is returned
 	 * otherwise a new frame is allocated from the buffer pool for reading the page.
 	 *
+	 * The page can also be latched for reading or writing (see LatchMode). The latch is waited for after the page
+	 * is pinned and without holding up the rest of the pool, and is released by unPinPage() given the same mode.
+	 * A thread must not latch a page again while it holds its latch.
+	 *
 	 * @param file   	File object
 	 * @param PageNo  Page number in the file to be read
 	 * @param page  	Reference to page pointer. Used to fetch the Page object in which requested page from file is read in.
+	 * @param hint  	How the page is expected to be used
+	 * @param mode  	Access the page is latched for
+	 * @throws InvalidPageSizeException If the file's page size differs from this pool's frame size
 	 */
-  void readPage(File* file, const PageId PageNo, Page*& page);
+  void readPage(File* file, const PageId PageNo, Page*& page, const ReadHint hint = ReadHint::NORMAL,
+                const LatchMode mode = LatchMode::NONE);
+
+	/**
+	 * Same as readPage() without a latch, but only if the page is already in the buffer pool and not still being
+	 * read in by another thread; nothing is read from disk and nothing is waited for.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @param page  	Reference to page pointer, set only if the page is in the buffer pool
+	 * @param hint  	How the page is expected to be used
+	 * @return 			True if the page was in the buffer pool and is now pinned
+	 * @throws InvalidPageSizeException If the file's page size differs from this pool's frame size
+	 */
+  bool tryReadPage(File* file, const PageId PageNo, Page*& page, const ReadHint hint = ReadHint::NORMAL);
+
+	/**
+	 * Reads a page without blocking the calling thread on the disk. If the page is in the buffer pool, it is
+	 * pinned and done is called before this returns. Otherwise the page is read by one of the loop's I/O threads
+	 * and done is posted to the loop once it is pinned or the read has failed. Either way the page must be
+	 * unpinned with unPinPage() once done with.
+	 *
+	 * @param file   	File object, which must stay open until done has run
+	 * @param PageNo  Page number in the file to be read
+	 * @param loop  	Event loop whose I/O threads read missing pages and whose thread runs done for them
+	 * @param done  	Function told the page or the read's error
+	 * @param hint  	How the page is expected to be used
+	 * @return 			True if the page was in the buffer pool and done has already run
+	 */
+  bool readPageAsync(File* file, const PageId PageNo, EventLoop& loop, const ReadCallback& done,
+                     const ReadHint hint = ReadHint::NORMAL);
+
+	/**
+	 * If the given page is already in the buffer pool, asks the CPU to start loading it into its caches.
+	 * The page is not pinned, its refbit is left alone and nothing is read from disk. With a lock-free page table
+	 * the lookup does not wait for the shard's mutex, and the page is left alone if the mutex is held.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file
+	 * @return 			True if the page is in the buffer pool
+	 */
+  bool prefetchPage(File* file, const PageId PageNo);
+
+	/**
+	 * Asks the operating system to read ahead a run of pages of the file, unless the first of them is already
+	 * in the buffer pool. Safe to call while other threads use the pool.
+	 *
+	 * @param file   	File object
+	 * @param firstPageNo	Number of first page of the run
+	 * @param numPages	Number of pages in the run
+	 */
+  void prefetchPages(File* file, const PageId firstPageNo, const PageId numPages);
+
+	/**
+	 * Returns an iterator at the first used page of the file. Pages are pinned through this buffer pool as the
+	 * iterator reaches them and unpinned as it moves on, and upcoming pages are prefetched.
+	 *
+	 * @param file   	File object
+	 * @return 			Iterator at the first page of the file
+	 */
+  ScanIterator scanBegin(File* file);
+
+	/**
+	 * Returns an iterator representing the page after the last page of the file. It should not be dereferenced.
+	 *
+	 * @param file   	File object
+	 * @return 			Iterator past the last page of the file
+	 */
+  ScanIterator scanEnd(File* file);
+
+	/**
+	 * Tests every record of the file against a predicate in place, in the frames holding its pages, and appends
+	 * the IDs of the matching records to recordIds. Pages are pinned only while their records are tested, and
+	 * are read as by a scan started with scanBegin().
+	 *
+	 * Given a zone map of the file, pages are instead visited in page number order, and pages the zone map
+	 * rules out (see mayMatch()) are skipped without being read.
+	 *
+	 * @param file   	File object
+	 * @param predicate	Condition records must satisfy
+	 * @param recordIds	Vector the IDs of matching records are appended to
+	 * @param zoneMap	If not NULL, zone map of the file kept up to date by this pool's write-back hook
+	 * @return 			Number of matching records
+	 */
+  std::size_t filterFile(File* file, const RecordPredicate& predicate, std::vector<RecordId>& recordIds,
+                         const ZoneMap* zoneMap = NULL);
+
+	/**
+	 * Returns false only if no record on the page can match the predicate: the page is not in the buffer pool,
+	 * so it is as last written back, and its summary in the zone map rules out a match.
+	 *
+	 * @param file   	File object
+	 * @param pageNo	Page number in the file
+	 * @param predicate	Condition records must satisfy
+	 * @param zoneMap	Zone map of the file kept up to date by this pool's write-back hook
+	 * @return 			Whether the page has to be read
+	 */
+  bool mayMatch(File* file, const PageId pageNo, const RecordPredicate& predicate, const ZoneMap& zoneMap);
+
+	/**
+	 * Sets the function run on every page of the file right after this pool writes it back, such as one passing
+	 * the page to ZoneMap::summarize(). Replaces any previous hook of the file; an empty function removes it.
+	 *
+	 * @param file   	File object
+	 * @param hook		Function to run on each page written back
+	 */
+  void setWriteBackHook(const File* file, const WriteBackHook& hook);
 
 	/**
 	 * Unpin a page from memory since it is no longer required for it to remain in memory.
@@ -231,9 +965,20 @@ class BufMgr
 	 * @param file   	File object
 	 * @param PageNo  Page number
 	 * @param dirty		True if the page to be unpinned needs to be marked dirty	
+	 * @param mode		Access the page was latched for by readPage(), or LatchMode::EXCLUSIVE after upgradeLatch()
    * @throws  PageNotPinnedException If the page is not already pinned
 	 */
-  void unPinPage(File* file, const PageId PageNo, const bool dirty);
+  void unPinPage(File* file, const PageId PageNo, const bool dirty, const LatchMode mode = LatchMode::NONE);
+
+	/**
+	 * Turns the caller's upgradable latch on a pinned page into an exclusive one, waiting for other readers of
+	 * the page to unpin it. The page is then unpinned with LatchMode::EXCLUSIVE.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number
+   * @throws  PageNotPinnedException If the page is not pinned
+	 */
+  void upgradeLatch(File* file, const PageId PageNo);
 
 	/**
 	 * Allocates a new, empty page in the file and returns the Page object.
@@ -242,9 +987,24 @@ class BufMgr
 	 * @param file   	File object
 	 * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
 	 * @param page  	Reference to page pointer. The newly allocated in-memory Page object is returned via this reference.
+	 * @throws InvalidPageSizeException If the file's page size differs from this pool's frame size
 	 */
   void allocPage(File* file, PageId &PageNo, Page*& page); 
 
+	/**
+	 * Loads a batch of records into freshly allocated pages of the file. Each page is filled with Page::insertRecords
+	 * before the next one is allocated, so a full page never raises an exception. Every page is unpinned (dirty)
+	 * before this function returns.
+	 *
+	 * @param file   	File object
+	 * @param records	Batch of records to load, in insertion order
+	 * @param recordIds	If not NULL, the ID of every loaded record is appended to this vector
+	 * @return 			Number of pages allocated for the batch
+	 * @throws InsufficientSpaceException If a record does not fit even on an empty page
+	 */
+  std::uint32_t loadRecords(File* file, const std::vector<std::string>& records,
+                            std::vector<RecordId>* recordIds = NULL);
+
 	/**
 	 * Writes out all dirty pages of the file to disk.
 	 * All the frames assigned to the file need to be unpinned from buffer pool before this function can be successfully called.
@@ -266,25 +1026,107 @@ class BufMgr
   void disposePage(File* file, const PageId PageNo);
 
 	/**
+	 * Changes the number of frames in the buffer pool while it is in use. Growing adds empty frames to the shards'
+	 * free lists; chained page tables grow by themselves as the frames fill, and lock-free ones are replaced by
+	 * larger ones where needed, one shard at a time. Shrinking takes
+	 * frames away from the shards, free frames first and then unpinned pages picked by the clock, which are written
+	 * back if dirty; pinned pages stay where they are, and a shard short of unpinned pages gives up the rest as they
+	 * are unpinned and evicted. Pages stay buffered across the change unless evicted to shrink the pool.
+	 *
+	 * Frames added after the pool was made are allocated from the heap, even if the pool was made with huge pages.
+	 *
+	 * @param frames		New number of frames, at least the number of shards and at most MAX_FRAMES
+	 */
+  void resize(std::uint32_t frames);
+
+	/**
    * Print member variable values. 
 	 */
   void  printSelf();
 
 	/**
-   * Get buffer pool usage statistics
+   * Get buffer pool usage statistics, summed over all shards
+	 */
+  BufStats getBufStats();
+
+	/**
+   * Get the size and chain lengths of the shards' page tables, summed over all shards
+	 */
+  PageTableStats getPageTableStats();
+
+	/**
+   * Get usage statistics of one shard
+	 *
+	 * @param shard		Index of the shard, below getNumShards()
+	 */
+  BufStats getShardStats(const std::uint32_t shard);
+
+	/**
+   * Turns the frame caches on or off. With them on, every thread remembers the frames of the pages it last pinned
+   * in a small cache of its own, and pins and unpins those pages again without the shard's mutex or hash table. An
+   * entry stops being used once its frame is evicted, flushed or disposed of. Worth it for threads that keep
+   * re-pinning a few hot pages, such as the root and inner pages of an index; pages read with ReadHint::ONCE are
+   * never cached. Off by default.
+	 *
+	 * @param enable	Whether to use the frame caches
+	 */
+  void setFrameCache(const bool enable)
+  {
+		frameCache = enable;
+  }
+
+	/**
+   * Sets how the pool picks the pages to replace. Pages already in the pool keep their refbits. CLOCK by default.
+	 *
+	 * @param policy	Replacement policy
 	 */
-  BufStats & getBufStats()
+  void setReplacementPolicy(const ReplacementPolicy policy)
   {
-		return bufStats;
+		this->policy = policy;
   }
 
 	/**
-   * Clear buffer pool usage statistics
+   * Get the pool's replacement policy
 	 */
-  void clearBufStats() 
+  ReplacementPolicy getReplacementPolicy() const
   {
-		bufStats.clear();
+		return policy;
   }
+
+	/**
+   * Get the kind of memory the frames' data is kept in: ArenaBacking::HEAP unless the pool was asked for huge
+   * pages, and otherwise the best the system could give
+	 */
+  ArenaBacking getFrameBacking() const;
+
+	/**
+   * Get the number of frames the buffer pool is sized to
+	 */
+  std::uint32_t getNumBufs() const
+  {
+		return numBufs;
+  }
+
+	/**
+   * Get the number of shards the frames are split into
+	 */
+  std::uint32_t getNumShards() const
+  {
+		return numShards;
+  }
+
+	/**
+   * Get the size in bytes of every frame in the buffer pool
+	 */
+  std::size_t getPageSize() const
+  {
+		return pageSize;
+  }
+
+	/**
+   * Clear buffer pool usage statistics of every shard
+	 */
+  void clearBufStats();
 };
 
 }
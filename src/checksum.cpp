@@ -0,0 +1,173 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "checksum.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define BADGERDB_CRC32C_X86 1
+#elif defined(__aarch64__) && defined(__linux__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#define BADGERDB_CRC32C_ARM 1
+#endif
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * CRC32C polynomial in reversed bit order.
+ */
+const std::uint32_t kPolynomial = 0x82F63B78;
+
+/**
+ * Lookup tables for the slicing-by-8 portable implementation.  Table 0 is the
+ * classic byte-at-a-time table; table k advances a byte through k more zero
+ * bytes.
+ */
+struct Crc32cTables {
+  std::uint32_t table[8][256];
+
+  Crc32cTables() {
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      std::uint32_t crc = i;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc & 1) ? (crc >> 1) ^ kPolynomial : crc >> 1;
+      }
+      table[0][i] = crc;
+    }
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      for (int k = 1; k < 8; ++k) {
+        table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+      }
+    }
+  }
+};
+
+const Crc32cTables kTables;
+
+std::uint32_t updatePortable(std::uint32_t crc, const unsigned char* p,
+                             std::size_t length) {
+  const std::uint32_t (*t)[256] = kTables.table;
+  while (length >= 8) {
+    std::uint32_t low, high;
+    std::memcpy(&low, p, 4);
+    std::memcpy(&high, p + 4, 4);
+    // The tables assume little-endian loads, which holds on every platform
+    // BadgerDB is built for.
+    low ^= crc;
+    crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^
+        t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+        t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^
+        t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+    p += 8;
+    length -= 8;
+  }
+  while (length-- > 0) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+  }
+  return crc;
+}
+
+#if defined(BADGERDB_CRC32C_X86)
+
+__attribute__((target("sse4.2")))
+std::uint32_t updateHardware(std::uint32_t crc, const unsigned char* p,
+                             std::size_t length) {
+#if defined(__x86_64__)
+  std::uint64_t crc64 = crc;
+  while (length >= 8) {
+    std::uint64_t word;
+    std::memcpy(&word, p, 8);
+    crc64 = _mm_crc32_u64(crc64, word);
+    p += 8;
+    length -= 8;
+  }
+  crc = static_cast<std::uint32_t>(crc64);
+#endif
+  while (length >= 4) {
+    std::uint32_t word;
+    std::memcpy(&word, p, 4);
+    crc = _mm_crc32_u32(crc, word);
+    p += 4;
+    length -= 4;
+  }
+  while (length-- > 0) {
+    crc = _mm_crc32_u8(crc, *p++);
+  }
+  return crc;
+}
+
+bool detectHardware() {
+  return __builtin_cpu_supports("sse4.2");
+}
+
+#elif defined(BADGERDB_CRC32C_ARM)
+
+__attribute__((target("+crc")))
+std::uint32_t updateHardware(std::uint32_t crc, const unsigned char* p,
+                             std::size_t length) {
+  while (length >= 8) {
+    std::uint64_t word;
+    std::memcpy(&word, p, 8);
+    crc = __crc32cd(crc, word);
+    p += 8;
+    length -= 8;
+  }
+  while (length-- > 0) {
+    crc = __crc32cb(crc, *p++);
+  }
+  return crc;
+}
+
+bool detectHardware() {
+  return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+
+#else
+
+std::uint32_t updateHardware(std::uint32_t crc, const unsigned char* p,
+                             std::size_t length) {
+  return updatePortable(crc, p, length);
+}
+
+bool detectHardware() {
+  return false;
+}
+
+#endif
+
+typedef std::uint32_t (*UpdateFunction)(std::uint32_t, const unsigned char*,
+                                        std::size_t);
+
+UpdateFunction chooseUpdate() {
+  return detectHardware() ? updateHardware : updatePortable;
+}
+
+}
+
+std::uint32_t Crc32c::extend(const std::uint32_t crc, const void* data,
+                             const std::size_t length) {
+  static const UpdateFunction update = chooseUpdate();
+  return ~update(~crc, static_cast<const unsigned char*>(data), length);
+}
+
+std::uint32_t Crc32c::extendPortable(const std::uint32_t crc, const void* data,
+                                     const std::size_t length) {
+  return ~updatePortable(~crc, static_cast<const unsigned char*>(data), length);
+}
+
+bool Crc32c::isHardwareAccelerated() {
+  static const bool hardware = detectHardware();
+  return hardware;
+}
+
+}
@@ -0,0 +1,57 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace badgerdb {
+
+/**
+ * @brief Computes CRC32C (Castagnoli) checksums.
+ *
+ * Uses the SSE4.2 crc32 instruction on x86 or the ARMv8 CRC extension on
+ * AArch64 when the CPU supports it, and a table-driven implementation
+ * otherwise.  All implementations produce identical results.
+ */
+class Crc32c {
+ public:
+  /**
+   * Extends a CRC32C checksum with more data.  Pass 0 as <crc> to start a new
+   * checksum; pass a previous result to continue it, so that checksumming a
+   * buffer in pieces gives the same result as checksumming it in one call.
+   *
+   * @param crc     Checksum of the data seen so far, or 0.
+   * @param data    Bytes to add to the checksum.
+   * @param length  Number of bytes at <data>.
+   * @return  Checksum of the data seen so far followed by <data>.
+   */
+  static std::uint32_t extend(const std::uint32_t crc, const void* data,
+                              const std::size_t length);
+
+  /**
+   * Same as extend(), but never uses CRC instructions.
+   *
+   * @param crc     Checksum of the data seen so far, or 0.
+   * @param data    Bytes to add to the checksum.
+   * @param length  Number of bytes at <data>.
+   * @return  Checksum of the data seen so far followed by <data>.
+   */
+  static std::uint32_t extendPortable(const std::uint32_t crc,
+                                      const void* data,
+                                      const std::size_t length);
+
+  /**
+   * Returns true if extend() uses CRC instructions on this CPU.
+   *
+   * @return  Whether checksums are hardware accelerated.
+   */
+  static bool isHardwareAccelerated();
+};
+
+}
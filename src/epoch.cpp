@@ -0,0 +1,184 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "epoch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Number of pointers a thread retires between attempts to free them.
+ */
+const std::size_t kReclaimBatch = 64;
+
+struct Retired {
+  void* pointer;
+  Epoch::Deleter deleter;
+
+  /**
+   * Global epoch when the pointer was retired.
+   */
+  std::uint64_t epoch;
+};
+
+/**
+ * State of a thread taking part in reclamation.  Records are never freed;
+ * one left behind by an exited thread is reused, with any pointers it still
+ * holds, by the next new thread.
+ */
+struct ThreadRecord {
+  /**
+   * Global epoch when the thread last entered a Guard, or 0 outside Guards.
+   */
+  std::atomic<std::uint64_t> active_epoch;
+
+  /**
+   * Whether a live thread owns the record.
+   */
+  std::atomic<bool> in_use;
+
+  /**
+   * Next record in the list of all records; set before the record is
+   * published and never changed.
+   */
+  ThreadRecord* next;
+
+  /**
+   * Number of Guards the owner is in.  Only touched by the owner.
+   */
+  unsigned depth;
+
+  /**
+   * Pointers the owner retired that are not freed yet.  Only touched by the
+   * owner.
+   */
+  std::vector<Retired> retired;
+};
+
+std::atomic<std::uint64_t> global_epoch(1);
+std::atomic<ThreadRecord*> all_records(nullptr);
+
+ThreadRecord* acquireRecord() {
+  for (ThreadRecord* record = all_records.load(); record != nullptr;
+       record = record->next) {
+    bool free = false;
+    if (!record->in_use.load() &&
+        record->in_use.compare_exchange_strong(free, true)) {
+      return record;
+    }
+  }
+  ThreadRecord* record = new ThreadRecord();
+  record->active_epoch.store(0);
+  record->in_use.store(true);
+  record->depth = 0;
+  record->next = all_records.load();
+  while (!all_records.compare_exchange_weak(record->next, record)) {
+  }
+  return record;
+}
+
+std::size_t reclaimRecord(ThreadRecord* record) {
+  // Readers that enter from now on cannot see anything retired so far.
+  const std::uint64_t epoch = global_epoch.fetch_add(1) + 1;
+  std::uint64_t oldest = epoch;
+  for (ThreadRecord* other = all_records.load(); other != nullptr;
+       other = other->next) {
+    const std::uint64_t active = other->active_epoch.load();
+    if (active != 0 && active < oldest) {
+      oldest = active;
+    }
+  }
+  std::vector<Retired>& retired = record->retired;
+  std::vector<Retired>::iterator waiting = std::partition(
+      retired.begin(), retired.end(),
+      [oldest](const Retired& r) { return r.epoch >= oldest; });
+  for (std::vector<Retired>::iterator it = waiting; it != retired.end(); ++it) {
+    it->deleter(it->pointer);
+  }
+  retired.erase(waiting, retired.end());
+  return retired.size();
+}
+
+/**
+ * Owns the calling thread's record and gives it up when the thread exits.
+ */
+class RecordHolder {
+ public:
+  RecordHolder() : record(acquireRecord()) {}
+  ~RecordHolder() {
+    reclaimRecord(record);
+    record->in_use.store(false);
+  }
+
+  ThreadRecord* const record;
+};
+
+ThreadRecord* localRecord() {
+  static thread_local RecordHolder holder;
+  return holder.record;
+}
+
+}
+
+Epoch::Guard::Guard(const bool enter) : entered_(enter) {
+  if (!entered_) {
+    return;
+  }
+  ThreadRecord* record = localRecord();
+  if (record->depth++ == 0) {
+    // Sequentially consistent so that the store is seen by reclaimRecord()
+    // before this thread reads anything it guards
+    record->active_epoch.store(global_epoch.load(std::memory_order_relaxed));
+  }
+}
+
+Epoch::Guard::~Guard() {
+  if (!entered_) {
+    return;
+  }
+  ThreadRecord* record = localRecord();
+  if (--record->depth == 0) {
+    record->active_epoch.store(0, std::memory_order_release);
+  }
+}
+
+void Epoch::retire(void* pointer, const Deleter deleter) {
+  ThreadRecord* record = localRecord();
+  const Retired retired = {pointer, deleter, global_epoch.load()};
+  record->retired.push_back(retired);
+  if (record->retired.size() % kReclaimBatch == 0) {
+    reclaimRecord(record);
+  }
+}
+
+std::size_t Epoch::reclaim() {
+  return reclaimRecord(localRecord());
+}
+
+void Epoch::synchronize() {
+  // Readers that enter from now on cannot see anything unlinked so far.
+  const std::uint64_t epoch = global_epoch.fetch_add(1) + 1;
+  for (ThreadRecord* other = all_records.load(); other != nullptr;
+       other = other->next) {
+    for (;;) {
+      const std::uint64_t active = other->active_epoch.load();
+      if (active == 0 || active >= epoch) {
+        break;
+      }
+      std::this_thread::yield();
+    }
+  }
+}
+
+}
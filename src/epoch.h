@@ -0,0 +1,79 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace badgerdb {
+
+/**
+ * @brief Epoch-based reclamation of memory shared by lock-free structures.
+ *
+ * A thread reading a lock-free structure does so inside a Guard.  Memory
+ * unlinked from the structure is passed to retire() instead of being freed,
+ * and freed only once every thread that was inside a Guard when it was
+ * retired has left it, so no reader can still be looking at it.
+ *
+ * Threads are registered on first use and their retired memory is freed in
+ * batches.  A thread that stays inside a Guard holds back reclamation for
+ * everyone, so Guards should be short.
+ */
+class Epoch {
+ public:
+  /**
+   * Marks the calling thread as reading lock-free structures for the
+   * lifetime of the object.  Guards may be nested.
+   */
+  class Guard {
+   public:
+    /**
+     * @param enter  If false, the Guard does nothing, for readers that only
+     *               sometimes go without a lock.
+     */
+    explicit Guard(const bool enter = true);
+    ~Guard();
+
+   private:
+    bool entered_;
+
+    Guard(const Guard&);
+    Guard& operator=(const Guard&);
+  };
+
+  /**
+   * Function freeing retired memory.
+   */
+  typedef void (*Deleter)(void*);
+
+  /**
+   * Hands over memory no longer reachable from any shared structure, to be
+   * freed once no thread can be reading it.  Must be called inside a Guard.
+   *
+   * @param pointer Memory to free.
+   * @param deleter Function that frees it.
+   */
+  static void retire(void* pointer, const Deleter deleter);
+
+  /**
+   * Frees what the calling thread has retired that no reader can still
+   * see.  Runs on its own every so often from retire().
+   *
+   * @return  Number of retired pointers of the calling thread still waiting.
+   */
+  static std::size_t reclaim();
+
+  /**
+   * Waits until every thread that was inside a Guard when this was called
+   * has left it, so that memory unlinked before the call can be freed at
+   * once.  For the rare callers that cannot leave freeing to a later time.
+   * Must not be called inside a Guard.
+   */
+  static void synchronize();
+};
+
+}
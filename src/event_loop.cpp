@@ -0,0 +1,88 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "event_loop.h"
+
+#include <algorithm>
+
+namespace badgerdb {
+
+EventLoop::EventLoop(const unsigned io_threads)
+    : io_outstanding_(0), stopping_(false) {
+  for (unsigned t = 0; t < std::max(1u, io_threads); t++) {
+    io_threads_.push_back(std::thread(&EventLoop::runIoJobs, this));
+  }
+}
+
+EventLoop::~EventLoop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  io_wakeup_.notify_all();
+  for (std::size_t t = 0; t < io_threads_.size(); t++) {
+    io_threads_[t].join();
+  }
+}
+
+void EventLoop::post(const Task& task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(task);
+  }
+  loop_wakeup_.notify_one();
+}
+
+void EventLoop::submitIo(const Task& job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    io_jobs_.push_back(job);
+    io_outstanding_++;
+  }
+  io_wakeup_.notify_one();
+}
+
+std::size_t EventLoop::run() {
+  std::size_t ran = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    loop_wakeup_.wait(lock, [this]() {
+      return !tasks_.empty() || io_outstanding_ == 0;
+    });
+    if (tasks_.empty()) {
+      return ran;
+    }
+    Task task = tasks_.front();
+    tasks_.pop_front();
+    lock.unlock();
+    task();
+    ran++;
+    lock.lock();
+  }
+}
+
+void EventLoop::runIoJobs() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    io_wakeup_.wait(lock, [this]() {
+      return !io_jobs_.empty() || stopping_;
+    });
+    if (io_jobs_.empty()) {
+      return;
+    }
+    Task job = io_jobs_.front();
+    io_jobs_.pop_front();
+    lock.unlock();
+    job();
+    lock.lock();
+    // After the job, so that run() sees anything it posted
+    io_outstanding_--;
+    loop_wakeup_.notify_one();
+  }
+}
+
+}
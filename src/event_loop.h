@@ -0,0 +1,97 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace badgerdb {
+
+/**
+ * @brief Single-threaded event loop with a pool of threads for blocking I/O.
+ *
+ * Tasks given to post() run one at a time on the thread calling run().  Jobs
+ * given to submitIo() run on the loop's I/O threads, so the loop's thread
+ * never waits for the disk; a job hands its result back by posting a task.
+ * BufMgr::readPageAsync() is built this way.
+ *
+ * post() and submitIo() may be called from any thread, including from tasks
+ * and jobs.  run() must only be called from one thread at a time.
+ */
+class EventLoop {
+ public:
+  typedef std::function<void()> Task;
+
+  /**
+   * @param io_threads  Number of threads running I/O jobs, at least 1.
+   */
+  explicit EventLoop(const unsigned io_threads = 1);
+
+  /**
+   * Finishes the I/O jobs already submitted, then stops the I/O threads.
+   * Tasks still queued are dropped without running.
+   */
+  ~EventLoop();
+
+  /**
+   * Queues <task> to run on the loop's thread.
+   */
+  void post(const Task& task);
+
+  /**
+   * Queues <job> to run on an I/O thread.  run() does not return while the
+   * job is queued or running, so tasks it posts are run by the same run().
+   * The job must not throw; errors are to be posted like results.
+   */
+  void submitIo(const Task& job);
+
+  /**
+   * Runs queued tasks on the calling thread until none is left and no I/O job
+   * is outstanding.  Exceptions thrown by a task propagate out of run(); the
+   * remaining tasks stay queued.
+   *
+   * @return  Number of tasks run.
+   */
+  std::size_t run();
+
+ private:
+  void runIoJobs();
+
+  std::mutex mutex_;
+
+  /**
+   * Signaled when a task is posted or an I/O job finishes.
+   */
+  std::condition_variable loop_wakeup_;
+
+  /**
+   * Signaled when an I/O job is submitted or the loop is stopping.
+   */
+  std::condition_variable io_wakeup_;
+
+  std::deque<Task> tasks_;
+  std::deque<Task> io_jobs_;
+
+  /**
+   * Number of I/O jobs submitted and not finished.
+   */
+  std::size_t io_outstanding_;
+
+  bool stopping_;
+  std::vector<std::thread> io_threads_;
+
+  EventLoop(const EventLoop&);
+  EventLoop& operator=(const EventLoop&);
+};
+
+}
@@ -0,0 +1,31 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "checksum_mismatch_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+ChecksumMismatchException::ChecksumMismatchException(
+    const PageId page_num, const std::string& file,
+    const std::uint32_t stored, const std::uint32_t computed)
+    : BadgerDbException(""),
+      page_number_(page_num),
+      filename_(file),
+      stored_(stored),
+      computed_(computed) {
+  std::stringstream ss;
+  ss << "Checksum mismatch on page " << page_number_
+     << " of file '" << filename_ << "'."
+     << " Stored: " << std::hex << stored_
+     << " Computed: " << computed_;
+  message_.assign(ss.str());
+}
+
+}
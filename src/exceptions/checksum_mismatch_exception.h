@@ -0,0 +1,74 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a page read from disk does not match
+ *        the checksum stamped on it when it was written, i.e. the page is torn
+ *        or corrupted.
+ */
+class ChecksumMismatchException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a checksum mismatch exception for the given page and filename.
+   *
+   * @param page_num  Number of the corrupted page.
+   * @param file      Name of file the page was read from.
+   * @param stored    Checksum stored in the page header.
+   * @param computed  Checksum computed over the bytes read.
+   */
+  ChecksumMismatchException(const PageId page_num, const std::string& file,
+                            const std::uint32_t stored,
+                            const std::uint32_t computed);
+
+  /**
+   * Destroys the exception.  Does nothing special; just included to make the
+   * compiler happy.
+   */
+  virtual ~ChecksumMismatchException() throw() {}
+
+  /**
+   * Returns the number of the page that caused this exception.
+   */
+  virtual PageId page_number() const { return page_number_; }
+
+  /**
+   * Returns name of the file that caused this exception.
+   */
+  virtual const std::string& filename() const { return filename_; }
+
+ protected:
+  /**
+   * Number of the page which caused this exception.
+   */
+  const PageId page_number_;
+
+  /**
+   * Name of file which caused this exception.
+   */
+  const std::string filename_;
+
+  /**
+   * Checksum stored in the page header.
+   */
+  const std::uint32_t stored_;
+
+  /**
+   * Checksum computed over the bytes read.
+   */
+  const std::uint32_t computed_;
+};
+
+}
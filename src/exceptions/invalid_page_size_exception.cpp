@@ -0,0 +1,31 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "invalid_page_size_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+InvalidPageSizeException::InvalidPageSizeException(
+    const std::size_t requested_size, const std::size_t expected_size,
+    const std::string& file)
+    : BadgerDbException(""),
+      page_size_(requested_size),
+      expected_size_(expected_size),
+      filename_(file) {
+  std::stringstream ss;
+  ss << "Invalid page size " << page_size_ << " for file '" << filename_
+     << "'.";
+  if (expected_size_ != 0) {
+    ss << " Expected " << expected_size_ << " bytes.";
+  }
+  message_.assign(ss.str());
+}
+
+}
@@ -0,0 +1,70 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a page size is not supported, or
+ *        when a page is used with a file or buffer pool of a different page
+ *        size.
+ */
+class InvalidPageSizeException : public BadgerDbException {
+ public:
+  /**
+   * Constructs an invalid page size exception for the given page size and
+   * filename.
+   *
+   * @param requested_size  Page size in bytes that was requested.
+   * @param expected_size   Page size in bytes the file or pool uses, or 0 if
+   *                        the requested size is not supported at all.
+   * @param file            Name of file that request was made to.
+   */
+  InvalidPageSizeException(const std::size_t requested_size,
+                           const std::size_t expected_size,
+                           const std::string& file);
+
+  /**
+   * Destroys the exception.  Does nothing special; just included to make the
+   * compiler happy.
+   */
+  virtual ~InvalidPageSizeException() throw() {}
+
+  /**
+   * Returns the requested page size that caused this exception.
+   */
+  virtual std::size_t page_size() const { return page_size_; }
+
+  /**
+   * Returns name of the file that caused this exception.
+   */
+  virtual const std::string& filename() const { return filename_; }
+
+ protected:
+  /**
+   * Requested page size which caused this exception.
+   */
+  const std::size_t page_size_;
+
+  /**
+   * Page size the file or buffer pool uses.
+   */
+  const std::size_t expected_size_;
+
+  /**
+   * Name of file which caused this exception.
+   */
+  const std::string filename_;
+};
+
+}
@@ -13,10 +13,17 @@
 namespace badgerdb {
 
 PageNotPinnedException::PageNotPinnedException(const std::string& nameIn, PageId pageNoIn, FrameId frameNoIn)
-    : BadgerDbException(""), name(nameIn), pageNo(pageNoIn), frameNo(frameNoIn) {
+    : BadgerDbException(""), name(nameIn), pageNo(pageNoIn), frameNo(frameNoIn), buffered(true) {
   std::stringstream ss;
   ss << "This page is not already pinned. file:  " << name << "page: " << pageNo << "frame: " << frameNo;
   message_.assign(ss.str());
 }
 
+PageNotPinnedException::PageNotPinnedException(const std::string& nameIn, PageId pageNoIn)
+    : BadgerDbException(""), name(nameIn), pageNo(pageNoIn), frameNo(0), buffered(false) {
+  std::stringstream ss;
+  ss << "This page is not in the buffer pool. file:  " << name << "page: " << pageNo;
+  message_.assign(ss.str());
+}
+
 }
@@ -24,6 +24,11 @@ class PageNotPinnedException : public BadgerDbException {
    */
   explicit PageNotPinnedException(const std::string& nameIn, PageId pageNoIn, FrameId frameNoIn);
 
+  /**
+   * Constructs a page not pinned exception for a page of the given file that is not in the buffer pool.
+   */
+  explicit PageNotPinnedException(const std::string& nameIn, PageId pageNoIn);
+
  protected:
   /**
    * Name of file that caused this exception.
@@ -36,9 +41,14 @@ class PageNotPinnedException : public BadgerDbException {
   const PageId pageNo;
 
   /**
-   * Frame number in buffer pool
+   * Frame number in buffer pool, if the page is buffered
    */
   const FrameId frameNo;
+
+  /**
+   * Whether the page is in the buffer pool, and so has a frame number
+   */
+  const bool buffered;
 };
 
 }
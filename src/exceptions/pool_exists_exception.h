@@ -0,0 +1,41 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a pool is added to a buffer pool
+ *        registry under a name already in use.
+ */
+class PoolExistsException : public BadgerDbException {
+ public:
+  /**
+   * Constructs the exception for the given pool name.
+   *
+   * @param name  Name already in use.
+   */
+  explicit PoolExistsException(const std::string& name);
+
+  /**
+   * Returns the name of the pool that caused this exception.
+   */
+  virtual const std::string& poolName() const { return pool_name_; }
+
+ protected:
+  /**
+   * Name of the pool that caused this exception.
+   */
+  const std::string pool_name_;
+};
+
+}
@@ -11,23 +11,114 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <cerrno>
+#include <cstddef>
 #include <cstdio>
 #include <cassert>
+#include <fcntl.h>
+#include <unistd.h>
 
+#include "checksum.h"
+#include "lz.h"
+#include "exceptions/checksum_mismatch_exception.h"
+#include "exceptions/corrupt_page_exception.h"
 #include "exceptions/file_exists_exception.h"
 #include "exceptions/file_not_found_exception.h"
 #include "exceptions/file_open_exception.h"
 #include "exceptions/invalid_page_exception.h"
+#include "exceptions/invalid_page_size_exception.h"
 #include "file_iterator.h"
 #include "page.h"
 
 namespace badgerdb {
 
-File::StreamMap File::open_streams_;
+File::OpenFileMap File::open_files_;
 File::CountMap File::open_counts_;
+std::mutex File::registry_mutex_;
+std::atomic<bool> File::checksums_enabled_(true);
 
-File File::create(const std::string& filename) {
-  return File(filename, true /* create_new */);
+namespace {
+
+/**
+ * Slots of compressed pages are reserved in multiples of this many bytes, so
+ * a page whose compressed size grows a little can still be rewritten in
+ * place.
+ */
+const std::uint32_t kSlotAlignment = 512;
+
+/**
+ * Reads <length> bytes at <offset> of a file, retrying short reads.  Returns
+ * false if the file ends (or cannot be read) before all bytes are read.
+ */
+bool readFully(const int fd, void* data, std::size_t length, off_t offset) {
+  char* next = static_cast<char*>(data);
+  while (length > 0) {
+    const ssize_t done = ::pread(fd, next, length, offset);
+    if (done < 0 && errno == EINTR) {
+      continue;
+    }
+    if (done <= 0) {
+      return false;
+    }
+    next += done;
+    length -= done;
+    offset += done;
+  }
+  return true;
+}
+
+/**
+ * Writes <length> bytes at <offset> of a file, retrying short writes.  Like
+ * the streams this replaced, gives up silently on an error.
+ */
+void writeFully(const int fd, const void* data, std::size_t length,
+                off_t offset) {
+  const char* next = static_cast<const char*>(data);
+  while (length > 0) {
+    const ssize_t done = ::pwrite(fd, next, length, offset);
+    if (done < 0 && errno == EINTR) {
+      continue;
+    }
+    if (done <= 0) {
+      return;
+    }
+    next += done;
+    length -= done;
+    offset += done;
+  }
+}
+
+/**
+ * Adds the records and free space of a used page, as described by its
+ * header, to the statistics in a file header.
+ */
+void addPageStats(FileHeader& header, const PageHeader& page) {
+  header.num_records += page.num_slots - page.num_free_slots;
+  header.free_bytes +=
+      page.free_space_upper_bound - page.free_space_lower_bound;
+  header.free_slots += page.num_free_slots;
+}
+
+/**
+ * Takes the records and free space of a used page back out of the
+ * statistics in a file header.
+ */
+void removePageStats(FileHeader& header, const PageHeader& page) {
+  header.num_records -= page.num_slots - page.num_free_slots;
+  header.free_bytes -=
+      page.free_space_upper_bound - page.free_space_lower_bound;
+  header.free_slots -= page.num_free_slots;
+}
+
+}
+
+File File::create(const std::string& filename, const PageFormat format,
+                  const std::size_t page_size,
+                  const PageCompression compression) {
+  if (!Page::isValidSize(page_size)) {
+    throw InvalidPageSizeException(page_size, 0, filename);
+  }
+  return File(filename, true /* create_new */, format, page_size, compression);
 }
 
 File File::open(const std::string& filename) {
@@ -42,12 +133,21 @@ void File::remove(const std::string& filename) {
     throw FileOpenException(filename);
   }
   std::remove(filename.c_str());
+  const std::string map_filename = pageMapFilename(filename);
+  if (exists(map_filename)) {
+    std::remove(map_filename.c_str());
+  }
+  const std::string zone_map_filename = zoneMapFilename(filename);
+  if (exists(zone_map_filename)) {
+    std::remove(zone_map_filename.c_str());
+  }
 }
 
 bool File::isOpen(const std::string& filename) {
   if (!exists(filename)) {
     return false;
   }
+  std::lock_guard<std::mutex> lock(registry_mutex_);
   return open_counts_.find(filename) != open_counts_.end();
 }
 
@@ -64,7 +164,11 @@ bool File::exists(const std::string& filename) {
 
 File::File(const File& other)
   : filename_(other.filename_),
-    stream_(open_streams_[filename_]) {
+    handle_(other.handle_),
+    map_handle_(other.map_handle_),
+    page_size_(other.page_size_),
+    compression_(other.compression_) {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
   ++open_counts_[filename_];
 }
 
@@ -74,6 +178,9 @@ File& File::operator=(const File& rhs) {
   close();	//close my file and associate me with the new one
   filename_ = rhs.filename_;
   openIfNeeded(false /* create_new */);
+  map_handle_ = rhs.map_handle_;
+  page_size_ = rhs.page_size_;
+  compression_ = rhs.compression_;
   return *this;
 }
 
@@ -82,9 +189,12 @@ File::~File() {
 }
 
 Page File::allocatePage() {
+  std::lock_guard<std::recursive_mutex> lock(handle_->structure_mutex);
   FileHeader header = readHeader();
-  Page new_page;
-  Page existing_page;
+  Page new_page(header.page_format, page_size_);
+  // Used page whose link is changed to point to the new page, if any.  Only
+  // headers of used pages are read, as the pages may be written meanwhile.
+  PageId previous_page_number = Page::INVALID_NUMBER;
   if (header.num_free_pages > 0) {
     new_page = readPage(header.first_free_page, true /* allow_free */);
     new_page.set_page_number(header.first_free_page);
@@ -95,23 +205,17 @@ Page File::allocatePage() {
         header.first_used_page > new_page.page_number()) {
       // Either have no pages used or the head of the used list is a page later
       // than the one we just allocated, so add the new page to the head.
-      if (header.first_used_page > new_page.page_number()) {
-        new_page.set_next_page_number(header.first_used_page);
-      }
+      new_page.set_next_page_number(header.first_used_page);
       header.first_used_page = new_page.page_number();
     } else {
       // New page is reused from somewhere after the beginning, so we need to
       // find where in the used list to insert it.
-      PageId next_page_number = Page::INVALID_NUMBER;
-      for (FileIterator iter = begin(); iter != end(); ++iter) {
-        next_page_number = (*iter).next_page_number();
-        if (next_page_number > new_page.page_number() ||
-            next_page_number == Page::INVALID_NUMBER) {
-          existing_page = *iter;
-          break;
-        }
+      PageId next_page_number = header.first_used_page;
+      while (next_page_number != Page::INVALID_NUMBER &&
+             next_page_number < new_page.page_number()) {
+        previous_page_number = next_page_number;
+        next_page_number = readPageHeader(next_page_number).next_page_number;
       }
-      existing_page.set_next_page_number(new_page.page_number());
       new_page.set_next_page_number(next_page_number);
     }
 
@@ -123,23 +227,21 @@ Page File::allocatePage() {
       header.first_used_page = new_page.page_number();
     } else {
       // If we have pages allocated, we need to add the new page to the tail
-      // of the linked list.
-      for (FileIterator iter = begin(); iter != end(); ++iter) {
-        if ((*iter).next_page_number() == Page::INVALID_NUMBER) {
-          existing_page = *iter;
-          break;
-        }
-      }
-      assert(existing_page.isUsed());
-      existing_page.set_next_page_number(new_page.page_number());
+      // of the linked list.  With no free pages, every page is on the list,
+      // which is in page number order, so the tail is the last page.
+      previous_page_number = header.num_pages - 1;
+      assert(readPageHeader(previous_page_number).next_page_number ==
+             Page::INVALID_NUMBER);
     }
     ++header.num_pages;
   }
   writePage(new_page.page_number(), new_page);
-  if (existing_page.page_number() != Page::INVALID_NUMBER) {
-    // If we updated an existing page by inserting the new page into the
-    // used list, we need to write it out.
-    writePage(existing_page.page_number(), existing_page);
+  addPageStats(header, new_page.header_);
+  if (previous_page_number != Page::INVALID_NUMBER) {
+    // If we inserted the new page into the used list after an existing page,
+    // we need to write out its link (only: the page itself may be written by
+    // someone else at the same time).
+    writeNextPageNumber(previous_page_number, new_page.page_number());
   }
   writeHeader(header);
 
@@ -147,66 +249,164 @@ Page File::allocatePage() {
 }
 
 Page File::readPage(const PageId page_number) const {
-  FileHeader header = readHeader();
-  if (page_number >= header.num_pages) {
+  Page page(Page::DEFAULT_FORMAT, page_size_);
+  readPage(page_number, page);
+  return page;
+}
+
+void File::readPage(const PageId page_number, Page& page) const {
+  if (page.page_size() != page_size_) {
+    throw InvalidPageSizeException(page.page_size(), page_size_, filename_);
+  }
+  // Pages past the end of the file fail to read (or, in a compressed file,
+  // read as free pages), so the file header need not be consulted here.
+  if (page_number == Page::INVALID_NUMBER) {
     throw InvalidPageException(page_number, filename_);
   }
-  return readPage(page_number, false /* allow_free */);
+  readPage(page_number, false /* allow_free */, page);
+}
+
+void File::prefetchPages(const PageId first_page,
+                         const PageId num_pages) const {
+#if defined(POSIX_FADV_WILLNEED)
+  const int fd = handle_->fd;
+  if (compression_ == PageCompression::NONE) {
+    ::posix_fadvise(fd, pagePosition(first_page),
+                    static_cast<off_t>(num_pages) * page_size_,
+                    POSIX_FADV_WILLNEED);
+  } else {
+    for (PageId p = first_page; p < first_page + num_pages; ++p) {
+      const PageMapEntry entry = readPageMapEntry(p);
+      if (entry.offset != 0) {
+        ::posix_fadvise(fd, entry.offset, sizeof(PageHeader) + entry.length,
+                        POSIX_FADV_WILLNEED);
+      }
+    }
+  }
+#endif
 }
 
 Page File::readPage(const PageId page_number, const bool allow_free) const {
-  Page page;
-  stream_->seekg(pagePosition(page_number), std::ios::beg);
-  stream_->read(reinterpret_cast<char*>(&page.header_), sizeof(page.header_));
-  stream_->read(reinterpret_cast<char*>(&page.data_[0]), Page::DATA_SIZE);
+  Page page(Page::DEFAULT_FORMAT, page_size_);
+  readPage(page_number, allow_free, page);
+  return page;
+}
+
+void File::readPage(const PageId page_number, const bool allow_free,
+                    Page& page) const {
+  if (compression_ == PageCompression::NONE) {
+    const off_t position = pagePosition(page_number);
+    if (!readFully(handle_->fd, &page.header_, sizeof(page.header_),
+                   position) ||
+        !readFully(handle_->fd, &page.data_[0], page.data_.size(),
+                   position + sizeof(page.header_))) {
+      // Page lies past the end of the file.
+      throw InvalidPageException(page_number, filename_);
+    }
+  } else {
+    readCompressedPage(page_number, page);
+  }
+  if (checksums_enabled_ && (page.header_.flags & Page::CHECKSUM_FLAG)) {
+    const std::uint32_t computed = pageChecksum(page.header_, page);
+    if (computed != page.header_.checksum) {
+      throw ChecksumMismatchException(page_number, filename_,
+                                      page.header_.checksum, computed);
+    }
+  }
   if (!allow_free && !page.isUsed()) {
     throw InvalidPageException(page_number, filename_);
   }
+}
 
-  return page;
+void File::readCompressedPage(const PageId page_number, Page& page) const {
+  const PageMapEntry entry = readPageMapEntry(page_number);
+  if (entry.offset == 0) {
+    page.initialize();
+    return;
+  }
+  const off_t data_offset = entry.offset + sizeof(page.header_);
+  readFully(handle_->fd, &page.header_, sizeof(page.header_), entry.offset);
+  if (entry.length == page.data_.size()) {
+    // Page did not compress, so it was stored as-is.
+    readFully(handle_->fd, &page.data_[0], entry.length, data_offset);
+    return;
+  }
+  std::string compressed(entry.length, '\0');
+  if (!readFully(handle_->fd, &compressed[0], entry.length, data_offset) ||
+      !LzCodec::decompress(compressed.data(), entry.length, &page.data_[0],
+                           page.data_.size())) {
+    throw CorruptPageException(page_number, filename_);
+  }
 }
 
 void File::writePage(const Page& new_page) {
-  PageHeader header = readPageHeader(new_page.page_number());
-  if (header.current_page_number == Page::INVALID_NUMBER) {
+  if (new_page.page_size() != page_size_) {
+    throw InvalidPageSizeException(new_page.page_size(), page_size_, filename_);
+  }
+  // Slots of a compressed file are allocated from shared state, so its pages
+  // are written under the structure lock.
+  std::unique_lock<std::recursive_mutex> lock(handle_->structure_mutex,
+                                              std::defer_lock);
+  if (compression_ != PageCompression::NONE) {
+    lock.lock();
+  }
+  const PageHeader on_disk = readPageHeader(new_page.page_number());
+  if (on_disk.current_page_number == Page::INVALID_NUMBER) {
     // Page has been deleted since it was read.
     throw InvalidPageException(new_page.page_number(), filename_);
   }
   // Page on disk may have had its next page pointer updated since it was read;
   // we don't modify that, but we do keep all the other modifications to the
   // page header.
-  const PageId next_page_number = header.next_page_number;
-  header = new_page.header_;
-  header.next_page_number = next_page_number;
-  writePage(new_page.page_number(), header, new_page);
+  PageHeader header = new_page.header_;
+  header.next_page_number = on_disk.next_page_number;
+  addPageWrite();
+  writePage(new_page.page_number(), header, new_page,
+            false /* write_next_page_number */);
+
+  // Move the file statistics from the old version of the page to the new one,
+  // touching the file header only if they changed.
+  if (on_disk.num_slots != header.num_slots ||
+      on_disk.num_free_slots != header.num_free_slots ||
+      on_disk.free_space_lower_bound != header.free_space_lower_bound ||
+      on_disk.free_space_upper_bound != header.free_space_upper_bound) {
+    std::lock_guard<std::recursive_mutex> stats_lock(handle_->structure_mutex);
+    FileHeader file_header = readHeader();
+    removePageStats(file_header, on_disk);
+    addPageStats(file_header, header);
+    writeHeader(file_header);
+  }
 }
 
 void File::deletePage(const PageId page_number) {
+  std::lock_guard<std::recursive_mutex> lock(handle_->structure_mutex);
   FileHeader header = readHeader();
   Page existing_page = readPage(page_number);
-  Page previous_page;
   // If this page is the head of the used list, update the header to point to
   // the next page in line.
   if (page_number == header.first_used_page) {
     header.first_used_page = existing_page.next_page_number();
   } else {
     // Walk the used list so we can update the page that points to this one.
-    for (FileIterator iter = begin(); iter != end(); ++iter) {
-      previous_page = *iter;
-      if (previous_page.next_page_number() == existing_page.page_number()) {
-        previous_page.set_next_page_number(existing_page.next_page_number());
+    // Only headers are read, as the pages may be written meanwhile.
+    PageId previous_page_number = header.first_used_page;
+    while (previous_page_number != Page::INVALID_NUMBER) {
+      const PageId next_page_number =
+          readPageHeader(previous_page_number).next_page_number;
+      if (next_page_number == page_number) {
+        writeNextPageNumber(previous_page_number,
+                            existing_page.next_page_number());
         break;
       }
+      previous_page_number = next_page_number;
     }
   }
   // Clear the page and add it to the head of the free list.
+  removePageStats(header, existing_page.header_);
   existing_page.initialize();
   existing_page.set_next_page_number(header.first_free_page);
   header.first_free_page = page_number;
   ++header.num_free_pages;
-  if (previous_page.isUsed()) {
-    writePage(previous_page.page_number(), previous_page);
-  }
   writePage(page_number, existing_page);
   writeHeader(header);
 }
@@ -216,28 +416,64 @@ FileIterator File::begin() {
   return FileIterator(this, header.first_used_page);
 }
 
+FileStats File::stats() const {
+  const FileHeader header = readHeader();
+  const FileStats stats = {header.num_pages - 1,
+                           header.num_pages - 1 - header.num_free_pages,
+                           header.num_free_pages, header.num_records,
+                           header.free_bytes, header.free_slots};
+  return stats;
+}
+
 FileIterator File::end() {
   return FileIterator(this, Page::INVALID_NUMBER);
 }
 
-File::File(const std::string& name, const bool create_new) : filename_(name) {
+File::File(const std::string& name, const bool create_new,
+           const PageFormat format, const std::size_t page_size,
+           const PageCompression compression)
+    : filename_(name) {
   openIfNeeded(create_new);
 
   if (create_new) {
     // File starts with 1 page (the header).
     FileHeader header = {1 /* num_pages */, 0 /* first_used_page */,
-                         0 /* num_free_pages */, 0 /* first_free_page */};
-    writeHeader(header);
+                         0 /* num_free_pages */, 0 /* first_free_page */,
+                         static_cast<std::uint32_t>(page_size),
+                         format /* page_format */, compression,
+                         0 /* num_records */, 0 /* free_bytes */,
+                         0 /* free_slots */, 0 /* page_writes */};
+    writeFully(handle_->fd, &header, sizeof(header), 0 /* pos */);
+  }
+  const FileHeader header = readHeader();
+  {
+    // The count of a file being created is loaded after it is written.
+    std::lock_guard<std::mutex> lock(handle_->page_writes_mutex);
+    if (create_new || !handle_->page_writes_loaded) {
+      handle_->page_writes = header.page_writes;
+      handle_->page_writes_loaded = true;
+    }
+  }
+  page_size_ = header.page_size;
+  compression_ = header.compression;
+
+  if (compression_ != PageCompression::NONE) {
+    openPageMapIfNeeded(create_new);
+    if (create_new) {
+      // Slots are placed after the file header.
+      const PageMapEntry allocation = {sizeof(FileHeader), 0, 0};
+      writePageMapEntry(0, allocation);
+    }
   }
 }
 
 void File::openIfNeeded(const bool create_new) {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
   if (open_counts_.find(filename_) != open_counts_.end()) {	//exists an entry already
     ++open_counts_[filename_];
-    stream_ = open_streams_[filename_];
+    handle_ = open_files_[filename_];
   } else {
-    std::ios_base::openmode mode =
-        std::fstream::in | std::fstream::out | std::fstream::binary;
+    int flags = O_RDWR;
     const bool already_exists = exists(filename_);
     if (create_new) {
       // Error if we try to overwrite an existing file.
@@ -245,59 +481,208 @@ void File::openIfNeeded(const bool create_new) {
         throw FileExistsException(filename_);
       }
       // New files have to be truncated on open.
-      mode = mode | std::fstream::trunc;
+      flags |= O_CREAT | O_TRUNC;
     } else {
       // Error if we try to open a file that doesn't exist.
       if (!already_exists) {
         throw FileNotFoundException(filename_);
       }
     }
-    stream_.reset(new std::fstream(filename_, mode));
-    open_streams_[filename_] = stream_;
+    handle_ = std::make_shared<OpenFile>(::open(filename_.c_str(), flags, 0666));
+    open_files_[filename_] = handle_;
     open_counts_[filename_] = 1;
   }
 }
 
+void File::openPageMapIfNeeded(const bool create_new) {
+  const std::string map_filename = pageMapFilename(filename_);
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  OpenFileMap::iterator existing = open_files_.find(map_filename);
+  if (existing != open_files_.end()) {
+    map_handle_ = existing->second;
+    return;
+  }
+  int flags = O_RDWR | O_CREAT;
+  if (create_new) {
+    flags |= O_TRUNC;
+  }
+  map_handle_ =
+      std::make_shared<OpenFile>(::open(map_filename.c_str(), flags, 0666));
+  open_files_[map_filename] = map_handle_;
+}
+
 void File::close() {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
   --open_counts_[filename_];
-  stream_.reset();
+  handle_.reset();
+  map_handle_.reset();
   if (open_counts_[filename_] == 0) {
-    open_streams_.erase(filename_);
+    open_files_.erase(filename_);
+    open_files_.erase(pageMapFilename(filename_));
     open_counts_.erase(filename_);
   }
 }
 
+File::OpenFile::~OpenFile() {
+  if (fd >= 0) {
+    ::close(fd);
+  }
+}
+
 void File::writePage(const PageId page_number, const Page& new_page) {
   writePage(page_number, new_page.header_, new_page);
 }
 
 void File::writePage(const PageId page_number, const PageHeader& header,
-                     const Page& new_page) {
-  stream_->seekp(pagePosition(page_number), std::ios::beg);
-  stream_->write(reinterpret_cast<const char*>(&header), sizeof(header));
-  stream_->write(reinterpret_cast<const char*>(&new_page.data_[0]),
-                 Page::DATA_SIZE);
-  stream_->flush();
+                     const Page& new_page, const bool write_next_page_number) {
+  PageHeader stamped_header = header;
+  if (checksums_enabled_) {
+    stamped_header.flags |= Page::CHECKSUM_FLAG;
+    stamped_header.checksum = pageChecksum(stamped_header, new_page);
+  } else {
+    stamped_header.flags &= ~Page::CHECKSUM_FLAG;
+    stamped_header.checksum = 0;
+  }
+  if (compression_ != PageCompression::NONE) {
+    writeCompressedPage(page_number, stamped_header, new_page);
+    return;
+  }
+  const off_t position = pagePosition(page_number);
+  std::size_t skipped = 0;
+  if (!write_next_page_number) {
+    // The header up to the link, then everything after it.
+    const std::size_t link = offsetof(PageHeader, next_page_number);
+    writeFully(handle_->fd, &stamped_header, link, position);
+    skipped = link + sizeof(stamped_header.next_page_number);
+  }
+  writeFully(handle_->fd, reinterpret_cast<const char*>(&stamped_header) +
+                 skipped, sizeof(stamped_header) - skipped,
+             position + skipped);
+  writeFully(handle_->fd, &new_page.data_[0], new_page.data_.size(),
+             position + sizeof(stamped_header));
+}
+
+void File::writeNextPageNumber(const PageId page_number,
+                               const PageId next_page_number) {
+  off_t position;
+  if (compression_ == PageCompression::NONE) {
+    position = pagePosition(page_number);
+  } else {
+    // Headers are stored uncompressed at the start of each slot.
+    position = readPageMapEntry(page_number).offset;
+  }
+  writeFully(handle_->fd, &next_page_number, sizeof(next_page_number),
+             position + offsetof(PageHeader, next_page_number));
+}
+
+void File::writeCompressedPage(const PageId page_number,
+                               const PageHeader& header,
+                               const Page& new_page) {
+  const std::size_t data_size = new_page.data_.size();
+  std::string compressed(LzCodec::maxCompressedSize(data_size), '\0');
+  // Compression only pays off if it saves at least a byte; otherwise the data
+  // area is stored as-is, which readCompressedPage recognises by its length.
+  std::size_t length = LzCodec::compress(new_page.data_.data(), data_size,
+                                         &compressed[0], data_size - 1);
+  const char* stored_data = compressed.data();
+  if (length == 0) {
+    length = data_size;
+    stored_data = new_page.data_.data();
+  }
+
+  PageMapEntry entry = readPageMapEntry(page_number);
+  const std::uint32_t slot_bytes = sizeof(PageHeader) + length;
+  if (entry.offset == 0 || entry.capacity < slot_bytes) {
+    // Reserve a new slot at the end of the file.
+    PageMapEntry allocation = readPageMapEntry(0);
+    entry.offset = allocation.offset;
+    entry.capacity =
+        (slot_bytes + kSlotAlignment - 1) / kSlotAlignment * kSlotAlignment;
+    allocation.offset += entry.capacity;
+    writePageMapEntry(0, allocation);
+  }
+  entry.length = length;
+
+  // Write the data before pointing the page map at it.
+  writeFully(handle_->fd, &header, sizeof(header), entry.offset);
+  writeFully(handle_->fd, stored_data, length, entry.offset + sizeof(header));
+  writePageMapEntry(page_number, entry);
+}
+
+PageMapEntry File::readPageMapEntry(const PageId page_number) const {
+  PageMapEntry entry = {0, 0, 0};
+  if (!readFully(map_handle_->fd, &entry, sizeof(entry),
+                 static_cast<off_t>(page_number) * sizeof(entry))) {
+    // Past the end of the map: the page has never been written.
+    entry.offset = 0;
+    entry.capacity = 0;
+    entry.length = 0;
+  }
+  return entry;
+}
+
+void File::writePageMapEntry(const PageId page_number,
+                             const PageMapEntry& entry) {
+  writeFully(map_handle_->fd, &entry, sizeof(entry),
+             static_cast<off_t>(page_number) * sizeof(entry));
+}
+
+std::uint32_t File::pageChecksum(const PageHeader& header, const Page& page) {
+  PageHeader zeroed_header = header;
+  zeroed_header.checksum = 0;
+  zeroed_header.next_page_number = 0;
+  const std::uint32_t crc =
+      Crc32c::extend(0, &zeroed_header, sizeof(zeroed_header));
+  return Crc32c::extend(crc, page.data_.data(), page.data_.size());
 }
 
 FileHeader File::readHeader() const {
   FileHeader header;
-  stream_->seekg(0 /* pos */, std::ios::beg);
-  stream_->read(reinterpret_cast<char*>(&header), sizeof(header));
+  readFully(handle_->fd, &header, sizeof(header), 0 /* pos */);
 
   return header;
 }
 
 void File::writeHeader(const FileHeader& header) {
-  stream_->seekp(0 /* pos */, std::ios::beg);
-  stream_->write(reinterpret_cast<const char*>(&header), sizeof(header));
-  stream_->flush();
+  writeFully(handle_->fd, &header, offsetof(FileHeader, page_writes),
+             0 /* pos */);
+}
+
+void File::startCountingPageWrites() {
+  std::lock_guard<std::mutex> lock(handle_->page_writes_mutex);
+  if (handle_->page_writes.load() != 0) {
+    return;
+  }
+  const std::uint64_t page_writes = 1;
+  writeFully(handle_->fd, &page_writes, sizeof(page_writes),
+             offsetof(FileHeader, page_writes));
+  handle_->page_writes = page_writes;
+}
+
+void File::addPageWrite() {
+  if (handle_->page_writes.load() == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(handle_->page_writes_mutex);
+  const std::uint64_t page_writes = handle_->page_writes.load() + 1;
+  writeFully(handle_->fd, &page_writes, sizeof(page_writes),
+             offsetof(FileHeader, page_writes));
+  handle_->page_writes = page_writes;
 }
 
 PageHeader File::readPageHeader(PageId page_number) const {
-  PageHeader header;
-  stream_->seekg(pagePosition(page_number), std::ios::beg);
-  stream_->read(reinterpret_cast<char*>(&header), sizeof(header));
+  // Pages never written read as free pages.
+  PageHeader header = Page(Page::DEFAULT_FORMAT, page_size_).header_;
+  if (compression_ != PageCompression::NONE) {
+    // Headers are stored uncompressed at the start of each slot.
+    const PageMapEntry entry = readPageMapEntry(page_number);
+    if (entry.offset == 0) {
+      return header;
+    }
+    readFully(handle_->fd, &header, sizeof(header), entry.offset);
+    return header;
+  }
+  readFully(handle_->fd, &header, sizeof(header), pagePosition(page_number));
 
   return header;
 }
@@ -7,10 +7,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <fstream>
 #include <string>
 #include <map>
 #include <memory>
+#include <mutex>
 
 #include "page.h"
 
@@ -18,6 +20,22 @@ namespace badgerdb {
 
 class FileIterator;
 
+/**
+ * @brief How pages of a file are stored on disk.
+ */
+enum class PageCompression : std::uint16_t {
+  /**
+   * Pages are stored as-is at fixed positions in the file.
+   */
+  NONE = 0,
+
+  /**
+   * Each page's data area is compressed with LzCodec and stored in a
+   * variable-size slot located through the file's page map.
+   */
+  LZ = 1
+};
+
 /**
  * @brief Header metadata for files on disk which contain pages.
  */
@@ -42,6 +60,47 @@ struct FileHeader {
    */
   PageId first_free_page;
 
+  /**
+   * Size in bytes of every page in the file, including the page header.
+   */
+  std::uint32_t page_size;
+
+  /**
+   * Slot directory layout used for pages allocated in the file.
+   */
+  PageFormat page_format;
+
+  /**
+   * How pages of the file are stored on disk.
+   */
+  PageCompression compression;
+
+  /**
+   * Number of records on the used pages of the file.
+   */
+  std::uint64_t num_records;
+
+  /**
+   * Bytes of free space between the slot directory and the records, summed
+   * over the used pages of the file.
+   */
+  std::uint64_t free_bytes;
+
+  /**
+   * Unused slots left in slot directories by deleted records, summed over the
+   * used pages of the file.
+   */
+  std::uint64_t free_slots;
+
+  /**
+   * One more than the number of times a page has been written with
+   * File::writePage() since File::startCountingPageWrites(), as a stamp for
+   * summaries of the pages kept in other files (see ZoneMap); 0 while page
+   * writes are not counted.  Counted apart from the rest of the header, which
+   * writeHeader() leaves it out of, so it must stay the last field.
+   */
+  std::uint64_t page_writes;
+
   /**
    * Returns true if this file header is equal to the other.
    *
@@ -52,23 +111,112 @@ struct FileHeader {
     return num_pages == rhs.num_pages &&
         num_free_pages == rhs.num_free_pages &&
         first_used_page == rhs.first_used_page &&
-        first_free_page == rhs.first_free_page;
+        first_free_page == rhs.first_free_page &&
+        page_size == rhs.page_size &&
+        page_format == rhs.page_format &&
+        compression == rhs.compression &&
+        num_records == rhs.num_records &&
+        free_bytes == rhs.free_bytes &&
+        free_slots == rhs.free_slots &&
+        page_writes == rhs.page_writes;
   }
 };
 
+/**
+ * @brief Statistics about the pages and records of a file, as last written to
+ * disk.  Kept up to date in the file header as pages are allocated, written
+ * and deleted, so they are read without touching any page.
+ */
+struct FileStats {
+  /**
+   * Number of pages allocated in the file, not counting the file header.
+   */
+  PageId num_pages;
+
+  /**
+   * Number of pages in use.
+   */
+  PageId used_pages;
+
+  /**
+   * Number of pages allocated but not in use.
+   */
+  PageId free_pages;
+
+  /**
+   * Number of records on the used pages.
+   */
+  std::uint64_t num_records;
+
+  /**
+   * Bytes of free space on the used pages, not counting unused slots.
+   */
+  std::uint64_t free_bytes;
+
+  /**
+   * Unused slots left in slot directories by deleted records.
+   */
+  std::uint64_t free_slots;
+
+  /**
+   * Returns the fraction of slots on the used pages that are unused, a
+   * measure of how fragmented their slot directories are.
+   *
+   * @return  Fraction between 0 and 1.
+   */
+  double fragmentation() const {
+    const std::uint64_t slots = num_records + free_slots;
+    return slots == 0 ? 0.0 : static_cast<double>(free_slots) / slots;
+  }
+};
+
+/**
+ * @brief Location of one page of a compressed file.
+ *
+ * Compressed files keep a page map in a side file (see File::pageMapFilename())
+ * holding one entry per page number.  Entry 0 is never a page; its offset
+ * records where the next new slot will be placed in the file.
+ */
+struct PageMapEntry {
+  /**
+   * Position of the page's slot in the file, or 0 if the page has never been
+   * written.
+   */
+  std::uint64_t offset;
+
+  /**
+   * Bytes reserved for the slot.  A page is rewritten in place as long as it
+   * still fits.
+   */
+  std::uint32_t capacity;
+
+  /**
+   * Length of the stored data area following the page header in the slot.
+   * Equal to the page's data area size if the page was stored uncompressed.
+   */
+  std::uint32_t length;
+};
+
 /**
  * @brief Class which represents a file in the filesystem containing database
  *        pages.
  *
- * The File class wraps a stream to an underlying file on disk.  Files contain
- * fixed-sized pages, and they never deallocate space (though they do reuse
- * deleted pages if possible).  If multiple File objects refer to the same
- * underlying file, they will share the stream in memory.
+ * The File class wraps a descriptor of an underlying file on disk.  Files
+ * contain fixed-sized pages (the size is chosen when the file is created), and
+ * they never deallocate space (though they do reuse deleted pages if possible).
+ * Pages of a compressed file are stored in variable-size slots located through
+ * a page map kept next to the file.  If multiple File objects refer to the
+ * same underlying file, they will share the descriptor.
  * If a file that has already been opened (possibly by another query), then the File class
- * detects this (by looking in the open_streams_ map) and just returns a file object with
- * the already created stream for the file without actually opening the UNIX file again. 
+ * detects this (by looking in the open_files_ map) and just returns a file object with
+ * the already open descriptor for the file without actually opening the UNIX file again.
  *
- * @warning This class is not threadsafe.
+ * Pages are read and written with positional I/O, so several threads may
+ * read and write different pages of a file at once, through the same or
+ * different File objects.  Changes to the file's structure (allocatePage(),
+ * deletePage(), the file statistics and the slots of a compressed file) are
+ * serialized on a lock shared by all File objects for the file.  A single
+ * File object must not be assigned to while other threads use it.
  */
 class File {
  public:
@@ -76,9 +224,17 @@ class File {
    * Creates a new file.
    *
    * @param filename  Name of the file.
+   * @param format    Slot directory layout for pages allocated in the file.
+   * @param page_size Size in bytes of every page in the file.
+   * @param compression How pages of the file are stored on disk.
    * @throws  FileExistsException     If the requested file already exists.
+   * @throws  InvalidPageSizeException  If page_size is not supported (see
+   *                                    Page::isValidSize()).
    */
-  static File create(const std::string& filename);
+  static File create(const std::string& filename,
+                     const PageFormat format = Page::DEFAULT_FORMAT,
+                     const std::size_t page_size = Page::SIZE,
+                     const PageCompression compression = PageCompression::NONE);
 
   /**
    * Opens the file named fileName and returns the corresponding File object.
@@ -93,7 +249,8 @@ class File {
   static File open(const std::string& filename);
 
   /**
-   * Deletes an existing file.
+   * Deletes an existing file, along with its page map if it is compressed and
+   * its zone map if it has one.
    *
    * @param filename  Name of the file.
    * @throws  FileNotFoundException   If the file doesn't exist.
@@ -116,6 +273,23 @@ class File {
    */
   static bool exists(const std::string& filename);
 
+  /**
+   * Turns page checksums on or off for all files.  While on (the default),
+   * every page written is stamped with a CRC32C of its contents, and every
+   * stamped page read back is verified against it.  While off, pages are
+   * written unstamped and nothing is verified.
+   *
+   * @param enabled Whether to stamp and verify page checksums.
+   */
+  static void setChecksumsEnabled(const bool enabled) {
+    checksums_enabled_ = enabled;
+  }
+
+  /**
+   * Returns true if page checksums are stamped and verified.
+   */
+  static bool checksumsEnabled() { return checksums_enabled_; }
+
   /**
    * Copy constructor.
    * 
@@ -139,7 +313,8 @@ class File {
   ~File();
 
   /**
-   * Allocates a new page in the file.
+   * Allocates a new page in the file.  The page uses the slot directory layout
+   * the file was created with.
    *
    * @return The new page.
    */
@@ -152,15 +327,48 @@ class File {
    * @return  The page.
    * @throws  InvalidPageException  If the page doesn't exist in the file or is
    *                                not currently used.
+   * @throws  ChecksumMismatchException If the page's contents don't match the
+   *                                    checksum stamped when it was written.
    */
   Page readPage(const PageId page_number) const;
 
+  /**
+   * Reads an existing page from the file into the given page object, reusing
+   * its storage.  Compressed pages are decompressed directly into it.
+   *
+   * @param page_number   Number of page to read.
+   * @param page          Page to overwrite with the page read.  Must have the
+   *                      file's page size.
+   * @throws  InvalidPageException  If the page doesn't exist in the file or is
+   *                                not currently used.
+   * @throws  InvalidPageSizeException  If <page> is not of the file's page
+   *                                    size.
+   * @throws  ChecksumMismatchException If the page's contents don't match the
+   *                                    checksum stamped when it was written.
+   * @throws  CorruptPageException  If a compressed page cannot be decoded.
+   */
+  void readPage(const PageId page_number, Page& page) const;
+
+  /**
+   * Tells the operating system that a run of pages will be read soon, so it
+   * can start fetching them from disk in the background.  This is only a
+   * hint: nothing is read into memory here and errors are ignored.
+   *
+   * @param first_page  Number of first page of the run.
+   * @param num_pages   Number of pages in the run.
+   */
+  void prefetchPages(const PageId first_page, const PageId num_pages) const;
+
   /**
    * Writes a page into the file, replacing any existing contents.  The page
    * must have been already allocated in this file by a call to allocatePage().
+   * The page's next page number is left as it is on disk, since it belongs to
+   * the file's list of used pages.
    *
    * @see allocatePage()
    * @param new_page  Page to write.
+   * @throws  InvalidPageSizeException  If the page's size differs from the
+   *                                    file's page size.
    */
   void writePage(const Page& new_page);
 
@@ -171,6 +379,32 @@ class File {
    */
   void deletePage(const PageId page_number);
 
+  /**
+   * Returns statistics about the file's pages and records, as of the last
+   * write of each page.  Only the file header is read.
+   *
+   * @return  File statistics.
+   */
+  FileStats stats() const;
+
+  /**
+   * Starts counting the page writes of the file, as summaries of its pages
+   * kept elsewhere need (see ZoneMap).  From then on, every writePage() of
+   * the file first adds to a count in the file header.  Files never counted
+   * pay nothing for it.  Does nothing if the writes are already counted.
+   */
+  void startCountingPageWrites();
+
+  /**
+   * Returns the count of page writes of the file: 0 if they are not
+   * counted, and otherwise one more than the number of pages written with
+   * writePage() since startCountingPageWrites().  Stored in the file header,
+   * and read from memory once the file is open.
+   *
+   * @return  Count of page writes.
+   */
+  std::uint64_t pageWrites() const { return handle_->page_writes.load(); }
+
   /**
    * Returns the name of the file this object represents.
    *
@@ -178,6 +412,42 @@ class File {
    */
   const std::string& filename() const { return filename_; }
 
+  /**
+   * Returns the size in bytes of every page in this file.
+   *
+   * @return Page size.
+   */
+  std::size_t page_size() const { return page_size_; }
+
+  /**
+   * Returns how pages of this file are stored on disk.
+   *
+   * @return Compression mode.
+   */
+  PageCompression compression() const { return compression_; }
+
+  /**
+   * Returns the name of the side file holding the page map of a compressed
+   * file.
+   *
+   * @param filename  Name of the compressed file.
+   * @return  Name of its page map file.
+   */
+  static std::string pageMapFilename(const std::string& filename) {
+    return filename + ".pagemap";
+  }
+
+  /**
+   * Returns the name of the side file holding the zone map of a file (see
+   * ZoneMap).
+   *
+   * @param filename  Name of the file.
+   * @return  Name of its zone map file.
+   */
+  static std::string zoneMapFilename(const std::string& filename) {
+    return filename + ".zonemap";
+  }
+
   /**
    * Returns an iterator at the first page in the file.
    *
@@ -201,8 +471,9 @@ class File {
    * @param page_number   Number of page.
    * @return  Position of page in file.
    */
-  static std::streampos pagePosition(const PageId page_number) {
-    return sizeof(FileHeader) + ((page_number - 1) * Page::SIZE);
+  std::streamoff pagePosition(const PageId page_number) const {
+    return sizeof(FileHeader) +
+        (static_cast<std::streamoff>(page_number - 1) * page_size_);
   }
 
   /**
@@ -214,17 +485,26 @@ class File {
    * @see File::open()
    * @param name        Name of file.
    * @param create_new  Whether to create a new file.
+   * @param format      Slot directory layout recorded in a new file's header.
+   *                    Ignored if create_new is false.
+   * @param page_size   Page size recorded in a new file's header.  Ignored if
+   *                    create_new is false.
+   * @param compression Compression mode recorded in a new file's header.
+   *                    Ignored if create_new is false.
    * @throws  FileExistsException     If the underlying file exists and
    *                                  create_new is true.
    * @throws  FileNotFoundException   If the underlying file doesn't exist and
    *                                  create_new is false.
    */
-  File(const std::string& name, const bool create_new);
+  File(const std::string& name, const bool create_new,
+       const PageFormat format = Page::DEFAULT_FORMAT,
+       const std::size_t page_size = Page::SIZE,
+       const PageCompression compression = PageCompression::NONE);
 
   /**
    * Opens the underlying file named in filename_.
    * This method only opens the file if no other File objects exist that access
-   * the same filesystem file; otherwise, it reuses the existing stream.
+   * the same filesystem file; otherwise, it reuses the existing descriptor.
    *
    * @param create_new  Whether to create a new file.
    * @throws  FileExistsException     If the underlying file exists and
@@ -235,7 +515,15 @@ class File {
   void openIfNeeded(const bool create_new);
 
   /**
-   * Closes the underlying file stream in <stream_>.
+   * Opens the page map of a compressed file, reusing the descriptor of another
+   * File object for the same file if there is one.
+   *
+   * @param create_new  Whether to create a new, empty page map.
+   */
+  void openPageMapIfNeeded(const bool create_new);
+
+  /**
+   * Releases the underlying file descriptor in <handle_>.
    * This method only closes the file if no other File objects exist that access
    * the same file.
    */
@@ -245,17 +533,74 @@ class File {
    * Reads a page from the file.  If <allow_free> is not set, an exception
    * will be thrown if the page read from disk is not currently in use.
    *
-   * No bounds checking is performed; the underlying file stream will throw
-   * an exception if the page is past the end of the file.
+   * No bounds checking is performed; a page past the end of the file fails
+   * to read with an exception.
    *
    * @param page_number   Number of page to read.
    * @param allow_free    Whether to allow reading a free (unused) page.
    * @return  The page.
    * @throws  InvalidPageException  If the page is free (unused) and
    *                                allow_free is false.
+   * @throws  ChecksumMismatchException If checksums are enabled and the page's
+   *                                    contents don't match its checksum.
    */
   Page readPage(const PageId page_number, const bool allow_free) const;
 
+  /**
+   * Reads a page from the file into the given page object.  Behaves like
+   * readPage(page_number, allow_free) otherwise.
+   *
+   * @param page_number   Number of page to read.
+   * @param allow_free    Whether to allow reading a free (unused) page.
+   * @param page          Page to overwrite.  Must have the file's page size.
+   * @throws  InvalidPageException  If the page is free (unused) and
+   *                                allow_free is false.
+   * @throws  ChecksumMismatchException If checksums are enabled and the page's
+   *                                    contents don't match its checksum.
+   * @throws  CorruptPageException  If a compressed page cannot be decoded.
+   */
+  void readPage(const PageId page_number, const bool allow_free,
+                Page& page) const;
+
+  /**
+   * Reads the stored form of a page of a compressed file into the given page
+   * object, decompressing its data area.  A page that has never been written
+   * is returned as a free page.
+   *
+   * @param page_number   Number of page to read.
+   * @param page          Page to overwrite.
+   * @throws  CorruptPageException  If the page cannot be decoded.
+   */
+  void readCompressedPage(const PageId page_number, Page& page) const;
+
+  /**
+   * Compresses a page and stores it in its slot, moving it to a new slot at
+   * the end of the file if it no longer fits.  Space of outgrown slots is not
+   * reused.
+   *
+   * @param page_number Number of page whose contents to replace.
+   * @param header      Header of page to write.
+   * @param new_page    Page whose data area to write.
+   */
+  void writeCompressedPage(const PageId page_number, const PageHeader& header,
+                           const Page& new_page);
+
+  /**
+   * Reads the page map entry of the given page of a compressed file.
+   *
+   * @param page_number   Number of page, or 0 for the slot allocation entry.
+   * @return  Page map entry.
+   */
+  PageMapEntry readPageMapEntry(const PageId page_number) const;
+
+  /**
+   * Writes the page map entry of the given page of a compressed file.
+   *
+   * @param page_number   Number of page, or 0 for the slot allocation entry.
+   * @param entry         Entry to write.
+   */
+  void writePageMapEntry(const PageId page_number, const PageMapEntry& entry);
+
   /**
    * Writes a page into the file at the given page number.  This does not
    * update ensure that the number in the header equals the position on disk.
@@ -269,14 +614,32 @@ class File {
   /**
    * Writes a page into the file at the given page number with the given header.
    * This does not ensure that the number in the header equals the position on
-   * disk.  No bounds checking is performed.
+   * disk.  No bounds checking is performed.  This is the only path by which
+   * pages reach the disk, so it is where checksums are stamped.
    *
    * @param page_number Number of page whose contents to replace.
    * @param header      Header of page to write.
    * @param new_page    Page to write.
+   * @param write_next_page_number  Whether to write the header's next page
+   *                    number too; if not, the one on disk is kept, so that
+   *                    the page can be written without the structure lock.
+   *                    Always written in a compressed file, whose writes hold
+   *                    the lock.
    */
   void writePage(const PageId page_number, const PageHeader& header,
-                 const Page& new_page);
+                 const Page& new_page,
+                 const bool write_next_page_number = true);
+
+  /**
+   * Changes only the next page number in the header of a page on disk, to
+   * relink the file's used or free list without rewriting the page.  The
+   * caller must hold the file's structure lock.
+   *
+   * @param page_number       Number of page to relink.
+   * @param next_page_number  New next page number of the page.
+   */
+  void writeNextPageNumber(const PageId page_number,
+                           const PageId next_page_number);
 
   /**
    * Reads the header for this file from disk.
@@ -286,12 +649,20 @@ class File {
   FileHeader readHeader() const;
 
   /**
-   * Writes the given header to the disk as the header for this file.
+   * Writes the given header to the disk as the header for this file, all but
+   * its count of page writes (see addPageWrite()).
    *
    * @param header  File header to write.
    */
   void writeHeader(const FileHeader& header);
 
+  /**
+   * Adds a page write to the count kept in the file header, if page writes
+   * are counted.  Called before the page is written, so a write that fails
+   * or is cut short still leaves the count changed.
+   */
+  void addPageWrite();
+
   /**
    * Reads only the header of the given page from disk (not the record data
    * or slot table).  No bounds checking is performed.
@@ -301,31 +672,114 @@ class File {
    */
   PageHeader readPageHeader(const PageId page_number) const;
 
-  typedef std::map<std::string,
-                   std::shared_ptr<std::fstream> > StreamMap;
+  /**
+   * Computes the checksum of a page as it will appear on disk: the given
+   * header with its checksum and next page number fields zeroed, followed by
+   * the page's data area.  The next page number is left out so that pages can
+   * be relinked in place (see writeNextPageNumber()).
+   *
+   * @param header  Header that is (or will be) stored with the page.
+   * @param page    Page whose data area to checksum.
+   * @return  CRC32C of the page.
+   */
+  static std::uint32_t pageChecksum(const PageHeader& header,
+                                    const Page& page);
+
+  /**
+   * @brief Descriptor of an open filesystem file, shared by all File objects
+   * for it.
+   */
+  struct OpenFile {
+    /**
+     * Takes ownership of a descriptor, which is closed on destruction.
+     */
+    explicit OpenFile(const int fd)
+        : fd(fd), page_writes(0), page_writes_loaded(false) {}
+    ~OpenFile();
+
+    /**
+     * Descriptor of the file, only used for positional reads and writes.
+     */
+    const int fd;
+
+    /**
+     * Serializes changes to the structure of the file.  Recursive because
+     * allocatePage() and deletePage() are built out of writes that take it.
+     */
+    std::recursive_mutex structure_mutex;
+
+    /**
+     * Count of page writes in the file header, loaded when the file is first
+     * opened and written through on every change.  Only read, without
+     * page_writes_mutex, while it is 0.
+     */
+    std::atomic<std::uint64_t> page_writes;
+
+    /**
+     * Serializes changes to page_writes, and its loading.
+     */
+    std::mutex page_writes_mutex;
+
+    /**
+     * Whether page_writes has been loaded from the file header.
+     */
+    bool page_writes_loaded;
+  };
+
+  typedef std::map<std::string, std::shared_ptr<OpenFile> > OpenFileMap;
   typedef std::map<std::string, int> CountMap;
 
   /**
-   * Streams for opened files.
+   * Descriptors of opened files and page maps.
    */
-  static StreamMap open_streams_;
+  static OpenFileMap open_files_;
 
   /**
    * Counts for opened files.
    */
   static CountMap open_counts_;
 
+  /**
+   * Guards open_files_ and open_counts_.
+   */
+  static std::mutex registry_mutex_;
+
+  /**
+   * Whether page checksums are stamped on write and verified on read.  Read
+   * by every thread reading or writing pages, so changes are atomic.
+   */
+  static std::atomic<bool> checksums_enabled_;
+
   /**
    * Name of the file this object represents.
    */
   std::string filename_;
 
   /**
-   * Stream for underlying filesystem object.
+   * Descriptor of underlying filesystem object.
+   */
+  std::shared_ptr<OpenFile> handle_;
+
+  /**
+   * Descriptor of the page map of a compressed file; empty otherwise.
+   */
+  std::shared_ptr<OpenFile> map_handle_;
+
+  /**
+   * Size in bytes of every page in the file, cached from the file header.
+   */
+  std::size_t page_size_;
+
+  /**
+   * How pages of the file are stored, cached from the file header.
    */
-  std::shared_ptr<std::fstream> stream_;
+  PageCompression compression_;
 
+  friend class BufMgr;
   friend class FileIterator;
+  friend class FileSampler;
+  friend class ParallelScan;
+  friend class ScanIterator;
   friend class FileTest;
 };
 
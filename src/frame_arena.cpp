@@ -0,0 +1,125 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "frame_arena.h"
+
+#include <sys/mman.h>
+
+#include <cstdint>
+
+namespace badgerdb {
+
+namespace {
+
+const std::size_t kCacheLine = 64;
+const std::size_t kHugePage2M = std::size_t(1) << 21;
+const std::size_t kHugePage1G = std::size_t(1) << 30;
+
+#ifdef MAP_HUGETLB
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+const int kHugeTlb2M = MAP_HUGETLB | (21 << MAP_HUGE_SHIFT);
+const int kHugeTlb1G = MAP_HUGETLB | (30 << MAP_HUGE_SHIFT);
+#endif
+
+std::size_t roundUp(const std::size_t bytes, const std::size_t unit) {
+  return (bytes + unit - 1) / unit * unit;
+}
+
+/**
+ * Returns an anonymous private mapping of <bytes>, or null.
+ */
+void* mapAnonymous(const std::size_t bytes, const int extra_flags) {
+  void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+  return mapping == MAP_FAILED ? nullptr : mapping;
+}
+
+}
+
+const char* arenaBackingName(const ArenaBacking backing) {
+  switch (backing) {
+    case ArenaBacking::HEAP:
+      return "heap";
+    case ArenaBacking::NORMAL_PAGES:
+      return "normal-pages";
+    case ArenaBacking::TRANSPARENT_HUGE_PAGES:
+      return "transparent-huge-pages";
+    case ArenaBacking::HUGETLB_2MB:
+      return "hugetlb-2MB";
+    case ArenaBacking::HUGETLB_1GB:
+      return "hugetlb-1GB";
+  }
+  return "unknown";
+}
+
+FrameArena::FrameArena(const std::size_t slots, const std::size_t slot_bytes,
+                       const bool huge_pages)
+    : mapping_(nullptr),
+      mapped_bytes_(0),
+      slots_begin_(nullptr),
+      num_slots_(slots),
+      slot_bytes_(roundUp(slot_bytes, kCacheLine)),
+      next_slot_(0),
+      backing_(ArenaBacking::NORMAL_PAGES) {
+  const std::size_t bytes = num_slots_ * slot_bytes_;
+#ifdef MAP_HUGETLB
+  // Reserved huge pages need a pool set aside by the administrator, and
+  // mappings whose length is a multiple of the huge page size
+  if (huge_pages && bytes >= kHugePage1G) {
+    mapped_bytes_ = roundUp(bytes, kHugePage1G);
+    mapping_ = mapAnonymous(mapped_bytes_, kHugeTlb1G);
+    backing_ = ArenaBacking::HUGETLB_1GB;
+  }
+  if (huge_pages && mapping_ == nullptr) {
+    mapped_bytes_ = roundUp(bytes, kHugePage2M);
+    mapping_ = mapAnonymous(mapped_bytes_, kHugeTlb2M);
+    backing_ = ArenaBacking::HUGETLB_2MB;
+  }
+#endif
+  if (mapping_ != nullptr) {
+    slots_begin_ = static_cast<char*>(mapping_);
+    return;
+  }
+
+  // Transparent huge pages only cover whole aligned 2 MiB ranges, so map a
+  // spare one to align the slots in
+  mapped_bytes_ = huge_pages ? bytes + kHugePage2M : bytes;
+  mapping_ = mapAnonymous(mapped_bytes_, 0);
+  if (mapping_ == nullptr) {
+    throw std::bad_alloc();
+  }
+  slots_begin_ = static_cast<char*>(mapping_);
+  backing_ = ArenaBacking::NORMAL_PAGES;
+#ifdef MADV_HUGEPAGE
+  if (huge_pages) {
+    slots_begin_ = reinterpret_cast<char*>(
+        roundUp(reinterpret_cast<std::uintptr_t>(mapping_), kHugePage2M));
+    if (madvise(slots_begin_, bytes, MADV_HUGEPAGE) == 0) {
+      backing_ = ArenaBacking::TRANSPARENT_HUGE_PAGES;
+    }
+  }
+#endif
+}
+
+FrameArena::~FrameArena() {
+  munmap(mapping_, mapped_bytes_);
+}
+
+void* FrameArena::allocate(const std::size_t bytes) {
+  if (bytes > slot_bytes_ || next_slot_.load() >= num_slots_) {
+    return nullptr;
+  }
+  const std::size_t slot = next_slot_.fetch_add(1);
+  if (slot >= num_slots_) {
+    return nullptr;
+  }
+  return slots_begin_ + slot * slot_bytes_;
+}
+
+}
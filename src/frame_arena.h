@@ -0,0 +1,190 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+namespace badgerdb {
+
+/**
+ * @brief Kind of memory a FrameArena got from the operating system.
+ */
+enum class ArenaBacking {
+  /**
+   * No arena: each frame's data is allocated on its own from the heap.
+   */
+  HEAP,
+
+  /**
+   * Ordinary pages; huge pages were not asked for or are not available.
+   */
+  NORMAL_PAGES,
+
+  /**
+   * Ordinary pages the kernel was asked to back with transparent huge pages
+   * (madvise(MADV_HUGEPAGE)).  The kernel may still leave parts of the arena
+   * in small pages.
+   */
+  TRANSPARENT_HUGE_PAGES,
+
+  /**
+   * Reserved 2 MiB huge pages (MAP_HUGETLB).
+   */
+  HUGETLB_2MB,
+
+  /**
+   * Reserved 1 GiB huge pages (MAP_HUGETLB).
+   */
+  HUGETLB_1GB
+};
+
+/**
+ * Returns a short name for <backing>, such as "hugetlb-2MB".
+ */
+const char* arenaBackingName(const ArenaBacking backing);
+
+/**
+ * @brief One contiguous mapping holding the data of every frame of a buffer
+ * pool, so that few TLB entries cover the whole pool when it is backed by huge
+ * pages.
+ *
+ * The arena is carved into equal slots, handed out in order by allocate()
+ * until they run out; after that allocate() returns null and callers fall
+ * back to the heap.  Slots are never reused, since a frame keeps its data for
+ * the life of the pool.  The mapping is tried with 1 GiB huge pages (if the
+ * arena is that large), then 2 MiB huge pages, then ordinary pages advised to
+ * become transparent huge pages, and backing() tells which was got.
+ *
+ * allocate() and owns() are safe to call from several threads at once.
+ */
+class FrameArena {
+ public:
+  /**
+   * Maps the arena.
+   *
+   * @param slots       Number of slots.
+   * @param slot_bytes  Smallest size of each slot, rounded up to a cache line.
+   * @param huge_pages  Whether to try huge pages; if false, the arena is
+   *                    mapped with ordinary pages.
+   * @throws  std::bad_alloc  If no mapping could be made at all.
+   */
+  FrameArena(const std::size_t slots, const std::size_t slot_bytes,
+             const bool huge_pages);
+
+  /**
+   * Unmaps the arena.  Nothing allocated from it may be used afterwards.
+   */
+  ~FrameArena();
+
+  /**
+   * Returns the next unused slot, or null if <bytes> does not fit in a slot
+   * or none is left.
+   */
+  void* allocate(const std::size_t bytes);
+
+  /**
+   * Returns true if <pointer> lies in the arena.
+   */
+  bool owns(const void* pointer) const {
+    const char* p = static_cast<const char*>(pointer);
+    return p >= slots_begin_ && p < slots_begin_ + num_slots_ * slot_bytes_;
+  }
+
+  /**
+   * Returns the kind of memory backing the arena.
+   */
+  ArenaBacking backing() const { return backing_; }
+
+  /**
+   * Returns the number of bytes mapped.
+   */
+  std::size_t mappedBytes() const { return mapped_bytes_; }
+
+ private:
+  /**
+   * Start of the mapping, as returned by mmap().
+   */
+  void* mapping_;
+  std::size_t mapped_bytes_;
+
+  /**
+   * First slot, aligned for transparent huge pages if they are used.
+   */
+  char* slots_begin_;
+
+  std::size_t num_slots_;
+  std::size_t slot_bytes_;
+  std::atomic<std::size_t> next_slot_;
+  ArenaBacking backing_;
+
+  FrameArena(const FrameArena&);
+  FrameArena& operator=(const FrameArena&);
+};
+
+/**
+ * @brief Allocator drawing from a FrameArena while it has slots left, and
+ * from the heap otherwise or when it has no arena.
+ *
+ * Copies of containers using it get an allocator without an arena, so only
+ * containers built with an arena on purpose take its slots.
+ */
+template <typename T>
+class ArenaAllocator {
+ public:
+  typedef T value_type;
+
+  ArenaAllocator() : arena_(nullptr) {}
+  explicit ArenaAllocator(FrameArena* arena) : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+  T* allocate(const std::size_t n) {
+    if (arena_ != nullptr) {
+      void* slot = arena_->allocate(n * sizeof(T));
+      if (slot != nullptr) {
+        return static_cast<T*>(slot);
+      }
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* pointer, const std::size_t) {
+    // Arena slots go back with the arena as a whole
+    if (arena_ == nullptr || !arena_->owns(pointer)) {
+      ::operator delete(pointer);
+    }
+  }
+
+  ArenaAllocator select_on_container_copy_construction() const {
+    return ArenaAllocator();
+  }
+
+  FrameArena* arena() const { return arena_; }
+
+  template <typename U>
+  struct rebind {
+    typedef ArenaAllocator<U> other;
+  };
+
+ private:
+  FrameArena* arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return !(a == b);
+}
+
+}
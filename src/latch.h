@@ -0,0 +1,201 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace badgerdb {
+
+/**
+ * @brief Access a page is pinned for.
+ */
+enum class LatchMode {
+  /**
+   * Pinned only; the caller coordinates access to the page itself.
+   */
+  NONE,
+
+  /**
+   * Read access, held together with any number of other readers.
+   */
+  SHARED,
+
+  /**
+   * Read access that can later be upgraded to write access.  Held together
+   * with readers, but not with another upgradable or exclusive holder.
+   */
+  UPGRADABLE,
+
+  /**
+   * Write access, held by one thread at a time with no readers.
+   */
+  EXCLUSIVE
+};
+
+/**
+ * @brief Reader-writer latch in a single 32-bit word.
+ *
+ * The top bit marks an exclusive holder (or one waiting for readers to
+ * leave), the next bit an upgradable holder, and the rest count shared
+ * holders.  A thread wanting exclusive access sets its bit first and then
+ * waits for readers to drain, and no new reader enters while the bit is set,
+ * so a steady stream of readers cannot starve writers.
+ *
+ * Waiters spin briefly and then yield the CPU.  Latches are meant to be
+ * held for short stretches, such as reading or updating records on a page;
+ * nothing is queued, so they are not fair among waiters of the same kind.
+ * Not reentrant: a thread holding the latch must not acquire it again, as
+ * even a second shared acquisition waits behind a queued exclusive one.
+ */
+class RWLatch {
+ public:
+  RWLatch() : state_(0) {}
+
+  /**
+   * Acquires the latch in the given mode.  Does nothing for LatchMode::NONE.
+   *
+   * @param mode  Mode to acquire.
+   */
+  void lock(const LatchMode mode) {
+    switch (mode) {
+      case LatchMode::SHARED:
+        lockShared();
+        break;
+      case LatchMode::UPGRADABLE:
+        lockUpgradable();
+        break;
+      case LatchMode::EXCLUSIVE:
+        lockExclusive();
+        break;
+      case LatchMode::NONE:
+        break;
+    }
+  }
+
+  /**
+   * Releases the latch held in the given mode.  Does nothing for
+   * LatchMode::NONE.
+   *
+   * @param mode  Mode the latch is held in.
+   */
+  void unlock(const LatchMode mode) {
+    switch (mode) {
+      case LatchMode::SHARED:
+        state_.fetch_sub(1, std::memory_order_release);
+        break;
+      case LatchMode::UPGRADABLE:
+        state_.fetch_and(~kUpgradable, std::memory_order_release);
+        break;
+      case LatchMode::EXCLUSIVE:
+        state_.fetch_and(~kExclusive, std::memory_order_release);
+        break;
+      case LatchMode::NONE:
+        break;
+    }
+  }
+
+  /**
+   * Turns an upgradable hold into an exclusive one, waiting for readers to
+   * leave.  New readers are kept out in the meantime.
+   */
+  void upgrade() {
+    // No one else can hold the exclusive bit while we are upgradable.
+    state_.fetch_or(kExclusive, std::memory_order_acquire);
+    waitForReaders();
+    state_.fetch_and(~kUpgradable, std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns true if nobody holds the latch.
+   *
+   * @return  Whether the latch is free.
+   */
+  bool isFree() const {
+    return state_.load(std::memory_order_relaxed) == 0;
+  }
+
+ private:
+  static const std::uint32_t kExclusive = 1u << 31;
+  static const std::uint32_t kUpgradable = 1u << 30;
+  static const std::uint32_t kReaders = kUpgradable - 1;
+
+  /**
+   * Spins issued before a waiter starts yielding the CPU.
+   */
+  static const int kSpins = 64;
+
+  static void pause(int& spins) {
+    if (spins < kSpins) {
+      ++spins;
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  void lockShared() {
+    int spins = 0;
+    std::uint32_t state = state_.load(std::memory_order_relaxed);
+    for (;;) {
+      if ((state & kExclusive) == 0) {
+        if (state_.compare_exchange_weak(state, state + 1,
+                                         std::memory_order_acquire,
+                                         std::memory_order_relaxed)) {
+          return;
+        }
+        continue;
+      }
+      pause(spins);
+      state = state_.load(std::memory_order_relaxed);
+    }
+  }
+
+  void lockUpgradable() {
+    acquireBit(kUpgradable);
+  }
+
+  void lockExclusive() {
+    acquireBit(kExclusive);
+    waitForReaders();
+  }
+
+  /**
+   * Sets <bit> once neither the exclusive nor the upgradable bit is set.
+   */
+  void acquireBit(const std::uint32_t bit) {
+    int spins = 0;
+    std::uint32_t state = state_.load(std::memory_order_relaxed);
+    for (;;) {
+      if ((state & (kExclusive | kUpgradable)) == 0) {
+        if (state_.compare_exchange_weak(state, state | bit,
+                                         std::memory_order_acquire,
+                                         std::memory_order_relaxed)) {
+          return;
+        }
+        continue;
+      }
+      pause(spins);
+      state = state_.load(std::memory_order_relaxed);
+    }
+  }
+
+  void waitForReaders() {
+    int spins = 0;
+    while ((state_.load(std::memory_order_acquire) & kReaders) != 0) {
+      pause(spins);
+    }
+  }
+
+  std::atomic<std::uint32_t> state_;
+};
+
+}
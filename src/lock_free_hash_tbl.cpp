@@ -0,0 +1,204 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "lock_free_hash_tbl.h"
+
+#include <algorithm>
+
+#include "epoch.h"
+#include "exceptions/hash_already_present_exception.h"
+#include "exceptions/hash_not_found_exception.h"
+
+namespace badgerdb {
+
+struct LockFreeBufHashTbl::Node {
+  Node(const File* file, const PageId page_number, const FrameId frame_number)
+      : file(file), page_number(page_number), frame_number(frame_number) {}
+
+  const File* const file;
+  const PageId page_number;
+  const FrameId frame_number;
+  Link next;
+};
+
+namespace {
+
+const std::uintptr_t kRemoved = 1;
+
+template <typename Node>
+Node* pointer(const std::uintptr_t link) {
+  return reinterpret_cast<Node*>(link & ~kRemoved);
+}
+
+template <typename Node>
+void deleteNode(void* node) {
+  delete static_cast<Node*>(node);
+}
+
+/**
+ * Returns true if (file, page_number) sorts before (other_file, other_page).
+ */
+bool keyLess(const File* file, const PageId page_number,
+             const File* other_file, const PageId other_page) {
+  const std::uintptr_t a = reinterpret_cast<std::uintptr_t>(file);
+  const std::uintptr_t b = reinterpret_cast<std::uintptr_t>(other_file);
+  return a < b || (a == b && page_number < other_page);
+}
+
+}
+
+LockFreeBufHashTbl::LockFreeBufHashTbl(const int size)
+    : size_(size), buckets_(new Link[size]) {
+  for (int i = 0; i < size_; i++) {
+    buckets_[i].store(0);
+  }
+}
+
+LockFreeBufHashTbl::~LockFreeBufHashTbl() {
+  for (int i = 0; i < size_; i++) {
+    Node* node = pointer<Node>(buckets_[i].load());
+    while (node != nullptr) {
+      Node* next = pointer<Node>(node->next.load());
+      delete node;
+      node = next;
+    }
+  }
+  delete[] buckets_;
+}
+
+LockFreeBufHashTbl::Link& LockFreeBufHashTbl::bucket(
+    const File* file, const PageId page_number) const {
+  // Same as BufHashTbl::hash(), which keeps runs of pages in separate buckets
+  return buckets_[(reinterpret_cast<std::uintptr_t>(file) + page_number) %
+                  size_];
+}
+
+bool LockFreeBufHashTbl::search(const File* file, const PageId page_number,
+                                Link*& prev, Node*& curr) {
+retry:
+  prev = &bucket(file, page_number);
+  curr = pointer<Node>(prev->load());
+  while (curr != nullptr) {
+    const std::uintptr_t next = curr->next.load();
+    if (next & kRemoved) {
+      // Finish the removal; fails if <prev> changed or was removed itself
+      std::uintptr_t expected = reinterpret_cast<std::uintptr_t>(curr);
+      if (!prev->compare_exchange_strong(expected, next & ~kRemoved)) {
+        goto retry;
+      }
+      Epoch::retire(curr, &deleteNode<Node>);
+      curr = pointer<Node>(next);
+      continue;
+    }
+    if (!keyLess(curr->file, curr->page_number, file, page_number)) {
+      return curr->file == file && curr->page_number == page_number;
+    }
+    prev = &curr->next;
+    curr = pointer<Node>(next);
+  }
+  return false;
+}
+
+void LockFreeBufHashTbl::insert(const File* file, const PageId pageNo,
+                                const FrameId frameNo) {
+  Epoch::Guard guard;
+  Node* node = nullptr;
+  for (;;) {
+    Link* prev;
+    Node* curr;
+    if (search(file, pageNo, prev, curr)) {
+      delete node;
+      throw HashAlreadyPresentException(file->filename(), pageNo,
+                                        curr->frame_number);
+    }
+    if (node == nullptr) {
+      node = new Node(file, pageNo, frameNo);
+    }
+    node->next.store(reinterpret_cast<std::uintptr_t>(curr));
+    std::uintptr_t expected = reinterpret_cast<std::uintptr_t>(curr);
+    if (prev->compare_exchange_strong(expected,
+                                      reinterpret_cast<std::uintptr_t>(node))) {
+      return;
+    }
+  }
+}
+
+void LockFreeBufHashTbl::lookup(const File* file, const PageId pageNo,
+                                FrameId& frameNo) {
+  if (!find(file, pageNo, frameNo)) {
+    throw HashNotFoundException(file->filename(), pageNo);
+  }
+}
+
+bool LockFreeBufHashTbl::find(const File* file, const PageId pageNo,
+                              FrameId& frameNo) {
+  Epoch::Guard guard;
+  // Unlike search(), leaves removed entries for writers to unlink
+  Node* curr = pointer<Node>(bucket(file, pageNo).load());
+  while (curr != nullptr &&
+         keyLess(curr->file, curr->page_number, file, pageNo)) {
+    curr = pointer<Node>(curr->next.load());
+  }
+  if (curr == nullptr || curr->file != file || curr->page_number != pageNo ||
+      (curr->next.load() & kRemoved)) {
+    return false;
+  }
+  frameNo = curr->frame_number;
+  return true;
+}
+
+void LockFreeBufHashTbl::remove(const File* file, const PageId pageNo) {
+  Epoch::Guard guard;
+  for (;;) {
+    Link* prev;
+    Node* curr;
+    if (!search(file, pageNo, prev, curr)) {
+      throw HashNotFoundException(file->filename(), pageNo);
+    }
+    std::uintptr_t next = curr->next.load();
+    if (next & kRemoved) {
+      continue;
+    }
+    // Once marked the entry is removed, whoever unlinks it
+    if (!curr->next.compare_exchange_strong(next, next | kRemoved)) {
+      continue;
+    }
+    std::uintptr_t expected = reinterpret_cast<std::uintptr_t>(curr);
+    if (prev->compare_exchange_strong(expected, next)) {
+      Epoch::retire(curr, &deleteNode<Node>);
+    } else {
+      search(file, pageNo, prev, curr);
+    }
+    return;
+  }
+}
+
+bool LockFreeBufHashTbl::concurrentReads() const {
+  return true;
+}
+
+PageTableStats LockFreeBufHashTbl::getStats() {
+  Epoch::Guard guard;
+  PageTableStats stats;
+  stats.buckets = size_;
+  for (int i = 0; i < size_; i++) {
+    std::size_t probe = 0;
+    for (Node* node = pointer<Node>(buckets_[i].load()); node != nullptr;) {
+      const std::uintptr_t next = node->next.load();
+      probe++;
+      if (!(next & kRemoved)) {
+        stats.entries++;
+        stats.totalProbes += probe;
+        stats.longestProbe = std::max(stats.longestProbe, probe);
+      }
+      node = pointer<Node>(next);
+    }
+  }
+  return stats;
+}
+
+}
@@ -0,0 +1,94 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "bufHashTbl.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Page table that threads may search, insert into and remove from at
+ * the same time without locks.
+ *
+ * Each bucket is a linked list kept sorted by (file, page number).  An entry
+ * is removed by first marking the low bit of its next pointer, which stops
+ * anything being linked after it, and then unlinking it with a
+ * compare-and-swap on its predecessor; a search that runs into a marked entry
+ * unlinks it on the remover's behalf.  find() and lookup() never write and
+ * never wait.  Unlinked entries are freed through Epoch once no search can
+ * still be reading them.
+ *
+ * Inserting and removing the same page from different threads is safe, but
+ * the buffer pool still serializes them per shard, since a page's frame must
+ * be filled before it is published.
+ */
+class LockFreeBufHashTbl : public PageTable {
+ public:
+  /**
+   * @param size  Number of buckets.
+   */
+  explicit LockFreeBufHashTbl(const int size);
+
+  /**
+   * Must not run while other threads use the table.
+   */
+  ~LockFreeBufHashTbl();
+
+  void insert(const File* file, const PageId pageNo, const FrameId frameNo);
+  void lookup(const File* file, const PageId pageNo, FrameId& frameNo);
+  bool find(const File* file, const PageId pageNo, FrameId& frameNo);
+  void remove(const File* file, const PageId pageNo);
+
+  /**
+   * Always true.
+   */
+  bool concurrentReads() const;
+
+  /**
+   * Counts only entries not yet removed.  May run alongside find() and
+   * lookup().
+   */
+  PageTableStats getStats();
+
+ private:
+  struct Node;
+
+  /**
+   * Link to a node, with the low bit set once the node holding the link has
+   * been removed.
+   */
+  typedef std::atomic<std::uintptr_t> Link;
+
+  /**
+   * Returns the bucket (file, page_number) belongs in.
+   */
+  Link& bucket(const File* file, const PageId page_number) const;
+
+  /**
+   * Finds the first entry of the bucket not less than (file, page_number),
+   * unlinking removed entries on the way.  Must be called inside an
+   * Epoch::Guard.
+   *
+   * @param prev  Set to the link pointing at <curr>.
+   * @param curr  Set to the entry found, or null at the end of the bucket.
+   * @return  True if <curr> is the entry for (file, page_number).
+   */
+  bool search(const File* file, const PageId page_number, Link*& prev,
+              Node*& curr);
+
+  const int size_;
+  Link* buckets_;
+
+  LockFreeBufHashTbl(const LockFreeBufHashTbl&);
+  LockFreeBufHashTbl& operator=(const LockFreeBufHashTbl&);
+};
+
+}
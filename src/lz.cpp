@@ -0,0 +1,264 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "lz.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Shortest match worth encoding.
+ */
+const std::size_t kMinMatch = 4;
+
+/**
+ * The last kLastLiterals bytes of a block are always literals, and no match
+ * may start within the last kMatchFindLimit bytes.  These are the limits of
+ * the LZ4 block format.
+ */
+const std::size_t kLastLiterals = 5;
+const std::size_t kMatchFindLimit = 12;
+
+/**
+ * Farthest back a match may reference (16-bit offsets).
+ */
+const std::size_t kMaxOffset = 65535;
+
+const int kHashBits = 12;
+
+inline std::uint32_t read32(const unsigned char* p) {
+  std::uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline std::uint32_t hashSequence(const std::uint32_t sequence) {
+  return (sequence * 2654435761U) >> (32 - kHashBits);
+}
+
+/**
+ * Writes the extra length bytes that follow a token nibble of 15.  Returns
+ * the new output position, or NULL if the output would overflow.
+ */
+inline unsigned char* writeLength(unsigned char* op, const unsigned char* oend,
+                                  std::size_t length) {
+  while (length >= 255) {
+    if (op >= oend) {
+      return NULL;
+    }
+    *op++ = 255;
+    length -= 255;
+  }
+  if (op >= oend) {
+    return NULL;
+  }
+  *op++ = static_cast<unsigned char>(length);
+  return op;
+}
+
+/**
+ * Writes a token's literal run.  Returns the new output position, or NULL
+ * if the output would overflow.
+ */
+inline unsigned char* writeLiterals(unsigned char* op, const unsigned char* oend,
+                                    unsigned char* token,
+                                    const unsigned char* literals,
+                                    const std::size_t length) {
+  if (length >= 15) {
+    *token = 15 << 4;
+    op = writeLength(op, oend, length - 15);
+    if (op == NULL) {
+      return NULL;
+    }
+  } else {
+    *token = static_cast<unsigned char>(length << 4);
+  }
+  if (static_cast<std::size_t>(oend - op) < length) {
+    return NULL;
+  }
+  std::memcpy(op, literals, length);
+  return op + length;
+}
+
+/**
+ * Reads the extra length bytes that follow a token nibble of 15.  Returns
+ * false if the input ends first.
+ */
+inline bool readLength(const unsigned char*& ip, const unsigned char* iend,
+                       std::size_t& length) {
+  unsigned char byte;
+  do {
+    if (ip >= iend) {
+      return false;
+    }
+    byte = *ip++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+}
+
+std::size_t LzCodec::compress(const char* src, const std::size_t src_length,
+                              char* dst, const std::size_t dst_capacity) {
+  const unsigned char* const base = reinterpret_cast<const unsigned char*>(src);
+  const unsigned char* const iend = base + src_length;
+  unsigned char* op = reinterpret_cast<unsigned char*>(dst);
+  const unsigned char* const oend = op + dst_capacity;
+  const unsigned char* anchor = base;
+
+  if (src_length > kMatchFindLimit) {
+    const unsigned char* const mflimit = iend - kMatchFindLimit;
+    const unsigned char* const matchlimit = iend - kLastLiterals;
+    std::uint32_t table[1 << kHashBits] = {0};
+    const unsigned char* ip = base + 1;
+
+    while (ip < mflimit) {
+      // Look for a match, stepping faster through incompressible runs.
+      const unsigned char* ref = NULL;
+      std::size_t misses = 0;
+      while (ip < mflimit) {
+        const std::uint32_t sequence = read32(ip);
+        const std::uint32_t h = hashSequence(sequence);
+        const unsigned char* candidate = base + table[h];
+        table[h] = static_cast<std::uint32_t>(ip - base);
+        if (candidate < ip && static_cast<std::size_t>(ip - candidate) <= kMaxOffset &&
+            read32(candidate) == sequence) {
+          ref = candidate;
+          break;
+        }
+        ip += 1 + (misses++ >> 6);
+      }
+      if (ref == NULL) {
+        break;
+      }
+
+      // Extend the match backwards over bytes not yet emitted.
+      while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+        --ip;
+        --ref;
+      }
+
+      unsigned char* token = op++;
+      if (op > oend) {
+        return 0;
+      }
+      op = writeLiterals(op, oend, token, anchor, ip - anchor);
+      if (op == NULL || oend - op < 2) {
+        return 0;
+      }
+      const std::size_t offset = ip - ref;
+      *op++ = static_cast<unsigned char>(offset & 0xFF);
+      *op++ = static_cast<unsigned char>(offset >> 8);
+
+      // Extend the match forwards.
+      const unsigned char* const match_start = ip;
+      ip += kMinMatch;
+      ref += kMinMatch;
+      while (ip < matchlimit && *ip == *ref) {
+        ++ip;
+        ++ref;
+      }
+      const std::size_t match_length = (ip - match_start) - kMinMatch;
+      if (match_length >= 15) {
+        *token |= 15;
+        op = writeLength(op, oend, match_length - 15);
+        if (op == NULL) {
+          return 0;
+        }
+      } else {
+        *token |= static_cast<unsigned char>(match_length);
+      }
+      anchor = ip;
+
+      // Remember a position inside the match so repeats are found sooner.
+      if (ip - 2 > base && ip < mflimit) {
+        table[hashSequence(read32(ip - 2))] =
+            static_cast<std::uint32_t>(ip - 2 - base);
+      }
+    }
+  }
+
+  // Whatever is left is emitted as a final run of literals.
+  unsigned char* token = op++;
+  if (op > oend) {
+    return 0;
+  }
+  op = writeLiterals(op, oend, token, anchor, iend - anchor);
+  if (op == NULL) {
+    return 0;
+  }
+  return op - reinterpret_cast<unsigned char*>(dst);
+}
+
+bool LzCodec::decompress(const char* src, const std::size_t src_length,
+                         char* dst, const std::size_t dst_length) {
+  const unsigned char* ip = reinterpret_cast<const unsigned char*>(src);
+  const unsigned char* const iend = ip + src_length;
+  unsigned char* const obase = reinterpret_cast<unsigned char*>(dst);
+  unsigned char* op = obase;
+  unsigned char* const oend = op + dst_length;
+
+  while (ip < iend) {
+    const unsigned char token = *ip++;
+
+    std::size_t literal_length = token >> 4;
+    if (literal_length == 15 && !readLength(ip, iend, literal_length)) {
+      return false;
+    }
+    if (static_cast<std::size_t>(iend - ip) < literal_length ||
+        static_cast<std::size_t>(oend - op) < literal_length) {
+      return false;
+    }
+    std::memcpy(op, ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+
+    // The last sequence of a block has literals only.
+    if (ip == iend) {
+      break;
+    }
+
+    if (iend - ip < 2) {
+      return false;
+    }
+    const std::size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > static_cast<std::size_t>(op - obase)) {
+      return false;
+    }
+
+    std::size_t match_length = token & 15;
+    if (match_length == 15 && !readLength(ip, iend, match_length)) {
+      return false;
+    }
+    match_length += kMinMatch;
+    if (static_cast<std::size_t>(oend - op) < match_length) {
+      return false;
+    }
+
+    // An overlapping match repeats the last <offset> bytes.  Everything
+    // between <ref> and <op> is a whole number of repetitions, so each pass
+    // can copy all of it without overlap, doubling the copy size each time.
+    const unsigned char* const ref = op - offset;
+    while (match_length > 0) {
+      const std::size_t chunk =
+          std::min(static_cast<std::size_t>(op - ref), match_length);
+      std::memcpy(op, ref, chunk);
+      op += chunk;
+      match_length -= chunk;
+    }
+  }
+  return op == oend;
+}
+
+}
@@ -0,0 +1,64 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace badgerdb {
+
+/**
+ * @brief Fast LZ77-family block codec used for compressed files.
+ *
+ * Produces the LZ4 block format (sequences of a token, literals, a 16-bit
+ * match offset and a match length), which favours decompression speed over
+ * ratio.  Blocks carry no framing; callers must remember both the compressed
+ * and the original length.
+ */
+class LzCodec {
+ public:
+  /**
+   * Returns the largest possible compressed size of <length> bytes of input,
+   * i.e. the output capacity that guarantees compress() succeeds.
+   *
+   * @param length  Size of the input in bytes.
+   * @return  Worst-case size of the compressed block.
+   */
+  static std::size_t maxCompressedSize(const std::size_t length) {
+    return length + length / 255 + 16;
+  }
+
+  /**
+   * Compresses a block.
+   *
+   * @param src           Bytes to compress.
+   * @param src_length    Number of bytes at <src>.
+   * @param dst           Output buffer.
+   * @param dst_capacity  Size of <dst> in bytes.
+   * @return  Size of the compressed block, or 0 if it would not fit in
+   *          <dst_capacity> bytes.
+   */
+  static std::size_t compress(const char* src, const std::size_t src_length,
+                              char* dst, const std::size_t dst_capacity);
+
+  /**
+   * Decompresses a block produced by compress().  The input is treated as
+   * untrusted: malformed blocks are rejected rather than read or written out
+   * of bounds.
+   *
+   * @param src         Compressed block.
+   * @param src_length  Size of the compressed block in bytes.
+   * @param dst         Output buffer.
+   * @param dst_length  Exact size of the original data in bytes.
+   * @return  True if the block was well formed and decompressed to exactly
+   *          <dst_length> bytes.
+   */
+  static bool decompress(const char* src, const std::size_t src_length,
+                         char* dst, const std::size_t dst_length);
+};
+
+}
@@ -3,15 +3,39 @@
 //#include <stdio.h>
 #include <cstring>
 #include <memory>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include "checksum.h"
+#include "event_loop.h"
 #include "page.h"
 #include "buffer.h"
 #include "file_iterator.h"
+#include "lock_free_hash_tbl.h"
 #include "page_iterator.h"
+#include "parallel_scan.h"
+#include "pool_registry.h"
+#include "record_predicate.h"
+#include "sampler.h"
+#include "slot_scan.h"
+#include "zone_map.h"
+#include "scan_iterator.h"
 #include "exceptions/file_not_found_exception.h"
 #include "exceptions/invalid_page_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
+#include "exceptions/pool_exists_exception.h"
+#include "exceptions/pool_not_found_exception.h"
 #include "exceptions/buffer_exceeded_exception.h"
+#include "exceptions/checksum_mismatch_exception.h"
+#include "exceptions/hash_already_present_exception.h"
+#include "exceptions/hash_not_found_exception.h"
+#include "exceptions/insufficient_space_exception.h"
+#include "exceptions/invalid_page_size_exception.h"
 
 #define PRINT_ERROR(str) \
 { \
@@ -37,6 +61,32 @@ void test4();
 void test5();
 void test6();
 void testBufMgr();
+void testPageFormats();
+void testBulkLoad();
+void testPageSizes();
+void testChecksums();
+void testCompression();
+void testScanIterator();
+void testParallelScan();
+void testSlotScan();
+void testPredicateScan();
+void testZoneMap();
+void testSampling();
+void testFileStats();
+void testLatchModes();
+void testShardedPool();
+void testConcurrentFile();
+void testLockFreeHashTbl();
+void testAsyncRead();
+void testInFlightRead();
+void testFrameCache();
+void testHugePagePool();
+void testResizePool();
+void testIncrementalRehash();
+void testNodePool();
+void testClockSweep();
+void testPoolRegistry();
+void testZoneMapEviction();
 
 int main() 
 {
@@ -48,7 +98,7 @@ int main()
 	{
     File::remove(filename);
   }
-	catch(FileNotFoundException)
+	catch(const FileNotFoundException&)
 	{
   }
 
@@ -74,12 +124,14 @@ int main()
     for (FileIterator iter = new_file.begin();
          iter != new_file.end();
          ++iter) {
-      // Iterate through all records on the page.
-      for (PageIterator page_iter = (*iter).begin();
-           page_iter != (*iter).end();
+      // Iterate through all records on the page.  The iterator holds a
+      // pointer to the page, so keep a copy of it alive for the loop.
+      Page current_page = *iter;
+      for (PageIterator page_iter = current_page.begin();
+           page_iter != current_page.end();
            ++page_iter) {
         std::cout << "Found record: " << *page_iter
-            << " on page " << (*iter).page_number() << "\n";
+            << " on page " << current_page.page_number() << "\n";
       }
     }
 
@@ -97,6 +149,33 @@ int main()
   // Delete the file since we're done with it.
   File::remove(filename);
 
+	testPageFormats();
+	testBulkLoad();
+	testPageSizes();
+	testChecksums();
+	testCompression();
+	testScanIterator();
+	testParallelScan();
+	testSlotScan();
+	testPredicateScan();
+	testZoneMap();
+	testSampling();
+	testFileStats();
+	testLatchModes();
+	testShardedPool();
+	testConcurrentFile();
+	testLockFreeHashTbl();
+	testAsyncRead();
+	testInFlightRead();
+	testFrameCache();
+	testHugePagePool();
+	testResizePool();
+	testIncrementalRehash();
+	testNodePool();
+	testClockSweep();
+	testPoolRegistry();
+	testZoneMapEviction();
+
 	//This function tests buffer manager, comment this line if you don't wish to test buffer manager
 	testBufMgr();
 }
@@ -319,3 +398,2633 @@ void test6()
 
 	bufMgr->flushFile(file1ptr);
 }
+
+void testPageFormats()
+{
+	//Fill a page of each slot directory layout with tiny records
+	const std::string record = "ab";
+	Page standard_page(PageFormat::STANDARD);
+	Page compact_page(PageFormat::COMPACT);
+	std::uint32_t standard_count = 0, compact_count = 0;
+	while (standard_page.hasSpaceForRecord(record))
+	{
+		standard_page.insertRecord(record);
+		standard_count++;
+	}
+	while (compact_page.hasSpaceForRecord(record))
+	{
+		compact_page.insertRecord(record);
+		compact_count++;
+	}
+	if (compact_count <= standard_count)
+	{
+		PRINT_ERROR("ERROR :: Compact page format should hold more records than the standard format");
+	}
+
+	//Delete every other record and make sure the iterator skips the holes
+	for (SlotId s = 1; s <= compact_count; s += 2)
+	{
+		compact_page.deleteRecord({Page::INVALID_NUMBER, s});
+	}
+	std::uint32_t live = 0;
+	for (PageIterator iter = compact_page.begin(); iter != compact_page.end(); ++iter)
+	{
+		if (*iter != record)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+		live++;
+	}
+	if (live != compact_count / 2)
+	{
+		PRINT_ERROR("ERROR :: Iterator returned the wrong number of records");
+	}
+
+	//Freed slots are reused before the slot directory grows
+	const RecordId reused = compact_page.insertRecord("xyz");
+	if (reused.slot_number != 1 || compact_page.getRecord(reused) != "xyz")
+	{
+		PRINT_ERROR("ERROR :: Freed slot was not reused");
+	}
+
+	//Pages keep their layout when written to and read back from a file
+	const std::string filename = "test.formats";
+	try
+	{
+		File::remove(filename);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+	{
+		File file = File::create(filename, PageFormat::STANDARD);
+		Page new_page = file.allocatePage();
+		const RecordId rid = new_page.insertRecord("hello!");
+		file.writePage(new_page);
+		Page same_page = file.readPage(new_page.page_number());
+		if (same_page.format() != PageFormat::STANDARD || same_page.getRecord(rid) != "hello!")
+		{
+			PRINT_ERROR("ERROR :: Page format was not preserved on disk");
+		}
+	}
+	File::remove(filename);
+
+	std::cout << "Test page formats passed" << "\n";
+}
+
+void testBulkLoad()
+{
+	std::vector<std::string> records;
+	for (int r = 0; r < 2000; r++)
+	{
+		sprintf(tmpbuf, "bulk record %d", r);
+		records.push_back(tmpbuf);
+	}
+
+	//A single page takes as many records as fit and reports how many it took
+	Page single_page;
+	std::vector<RecordId> page_rids;
+	const std::size_t taken = single_page.insertRecords(records, 0, &page_rids);
+	if (taken == 0 || taken >= records.size() || page_rids.size() != taken)
+	{
+		PRINT_ERROR("ERROR :: insertRecords consumed the wrong number of records");
+	}
+	if (single_page.hasSpaceForRecord(records[taken]))
+	{
+		PRINT_ERROR("ERROR :: insertRecords stopped before the page was full");
+	}
+	for (std::size_t r = 0; r < taken; r++)
+	{
+		if (single_page.getRecord(page_rids[r]) != records[r])
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+	}
+
+	//The buffer manager spreads the batch across as many pages as it needs
+	const std::string filename = "test.bulk";
+	try
+	{
+		File::remove(filename);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+	{
+		File file = File::create(filename);
+		BufMgr* bulkMgr = new BufMgr(4);
+		std::vector<RecordId> rids;
+		const std::uint32_t pages = bulkMgr->loadRecords(&file, records, &rids);
+		if (pages < 2 || rids.size() != records.size())
+		{
+			PRINT_ERROR("ERROR :: loadRecords did not load the whole batch");
+		}
+		for (std::size_t r = 0; r < records.size(); r++)
+		{
+			bulkMgr->readPage(&file, rids[r].page_number, page);
+			if (page->getRecord(rids[r]) != records[r])
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+			bulkMgr->unPinPage(&file, rids[r].page_number, false);
+		}
+
+		//A record that can never fit is rejected without leaving a page behind
+		std::vector<std::string> huge(1, std::string(Page::DATA_SIZE, 'x'));
+		try
+		{
+			bulkMgr->loadRecords(&file, huge);
+			PRINT_ERROR("ERROR :: Record larger than a page should not load. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const InsufficientSpaceException&)
+		{
+		}
+		delete bulkMgr;
+	}
+	File::remove(filename);
+
+	std::cout << "Test bulk load passed" << "\n";
+}
+
+void testPageSizes()
+{
+	const std::string small_name = "test.small";
+	const std::string wide_name = "test.wide";
+	try
+	{
+		File::remove(small_name);
+		File::remove(wide_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	try
+	{
+		File::create(small_name, Page::DEFAULT_FORMAT, 5000);
+		PRINT_ERROR("ERROR :: Page size 5000 is not supported. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(const InvalidPageSizeException&)
+	{
+	}
+
+	{
+		File small_file = File::create(small_name, Page::DEFAULT_FORMAT, 4096);
+		File wide_file = File::create(wide_name, Page::DEFAULT_FORMAT, Page::MAX_SIZE);
+		BufMgr smallMgr(10, 4096);
+		BufMgr wideMgr(10, Page::MAX_SIZE);
+
+		//Records near the end of a 64 KiB page must still be addressable
+		const std::string wide_record(30000, 'w');
+		PageId wide_pid;
+		bufMgr = &wideMgr;
+		bufMgr->allocPage(&wide_file, wide_pid, page);
+		const RecordId first = page->insertRecord(wide_record);
+		const RecordId second = page->insertRecord(wide_record);
+		if (page->hasSpaceForRecord(wide_record))
+		{
+			PRINT_ERROR("ERROR :: 64 KiB page should not hold three 30000 byte records");
+		}
+		bufMgr->unPinPage(&wide_file, wide_pid, true);
+
+		//Small pages are laid out 4 KiB apart on disk
+		std::vector<std::string> records(200, "small page record");
+		std::vector<RecordId> rids;
+		bufMgr = &smallMgr;
+		if (bufMgr->loadRecords(&small_file, records, &rids) < 2)
+		{
+			PRINT_ERROR("ERROR :: 200 records should not fit on one 4 KiB page");
+		}
+
+		//A file can only be read through a pool of its own page size
+		try
+		{
+			smallMgr.readPage(&wide_file, wide_pid, page);
+			PRINT_ERROR("ERROR :: Page size mismatch. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const InvalidPageSizeException&)
+		{
+		}
+
+		//Evict everything and read it back from disk
+		smallMgr.flushFile(&small_file);
+		wideMgr.flushFile(&wide_file);
+		File reopened = File::open(wide_name);
+		if (reopened.page_size() != Page::MAX_SIZE)
+		{
+			PRINT_ERROR("ERROR :: Page size was not recorded in the file header");
+		}
+		Page wide_page = reopened.readPage(wide_pid);
+		if (wide_page.getRecord(first) != wide_record || wide_page.getRecord(second) != wide_record)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+		for (std::size_t r = 0; r < rids.size(); r++)
+		{
+			if (small_file.readPage(rids[r].page_number).getRecord(rids[r]) != records[r])
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+		}
+	}
+	File::remove(small_name);
+	File::remove(wide_name);
+
+	std::cout << "Test page sizes passed" << "\n";
+}
+
+void testChecksums()
+{
+	//Standard CRC32C check value, computed in one piece and in two
+	const std::string check = "123456789";
+	if (Crc32c::extend(0, check.data(), check.length()) != 0xE3069283 ||
+			Crc32c::extendPortable(0, check.data(), check.length()) != 0xE3069283 ||
+			Crc32c::extend(Crc32c::extend(0, check.data(), 4), check.data() + 4, 5) != 0xE3069283)
+	{
+		PRINT_ERROR("ERROR :: CRC32C check value did not match");
+	}
+
+	const std::string filename = "test.crc";
+	try
+	{
+		File::remove(filename);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+	{
+		File file = File::create(filename);
+		BufMgr crcMgr(4);
+		PageId crc_pid;
+		crcMgr.allocPage(&file, crc_pid, page);
+		const RecordId crc_rid = page->insertRecord("checksummed record");
+		crcMgr.unPinPage(&file, crc_pid, true);
+		//Page is stamped when the buffer manager writes it back
+		crcMgr.flushFile(&file);
+		if (file.readPage(crc_pid).getRecord(crc_rid) != "checksummed record")
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+
+		//Flip one byte of the record on disk
+		{
+			std::fstream raw(filename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+			raw.seekp(sizeof(FileHeader) + (crc_pid - 1) * file.page_size() + file.page_size() - 1);
+			raw.put('!');
+		}
+		try
+		{
+			crcMgr.readPage(&file, crc_pid, page);
+			PRINT_ERROR("ERROR :: Page was corrupted on disk. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const ChecksumMismatchException&)
+		{
+		}
+
+		//With checksums switched off the page is trusted as-is
+		File::setChecksumsEnabled(false);
+		crcMgr.readPage(&file, crc_pid, page);
+		crcMgr.unPinPage(&file, crc_pid, false);
+		File::setChecksumsEnabled(true);
+	}
+	File::remove(filename);
+
+	std::cout << "Test checksums passed" << "\n";
+}
+
+void testCompression()
+{
+	const std::string plain_name = "test.plain";
+	const std::string packed_name = "test.packed";
+	try
+	{
+		File::remove(plain_name);
+		File::remove(packed_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	std::vector<std::string> records;
+	for (int r = 0; r < 3000; r++)
+	{
+		sprintf(tmpbuf, "archived order %d status=shipped region=west", r);
+		records.push_back(tmpbuf);
+	}
+
+	std::vector<RecordId> plain_rids, packed_rids;
+	{
+		File plain_file = File::create(plain_name);
+		File packed_file = File::create(packed_name, Page::DEFAULT_FORMAT, Page::SIZE, PageCompression::LZ);
+		BufMgr zipMgr(8);
+		zipMgr.loadRecords(&plain_file, records, &plain_rids);
+		zipMgr.loadRecords(&packed_file, records, &packed_rids);
+		zipMgr.flushFile(&plain_file);
+		zipMgr.flushFile(&packed_file);
+
+		//Deleting and reusing a page goes through the page map as well
+		zipMgr.disposePage(&packed_file, packed_rids[0].page_number);
+		PageId reused;
+		zipMgr.allocPage(&packed_file, reused, page);
+		if (reused != packed_rids[0].page_number)
+		{
+			PRINT_ERROR("ERROR :: Deleted page of compressed file was not reused");
+		}
+		page->insertRecord("first page again");
+		zipMgr.unPinPage(&packed_file, reused, true);
+	}
+
+	{
+		std::ifstream plain_raw(plain_name.c_str(), std::ios::binary | std::ios::ate);
+		std::ifstream packed_raw(packed_name.c_str(), std::ios::binary | std::ios::ate);
+		if (packed_raw.tellg() * 2 > plain_raw.tellg())
+		{
+			PRINT_ERROR("ERROR :: Compressed file should be less than half the size of the plain one");
+		}
+	}
+
+	//Pages read back through a fresh File and the iterator match the originals
+	{
+		File packed_file = File::open(packed_name);
+		if (packed_file.compression() != PageCompression::LZ)
+		{
+			PRINT_ERROR("ERROR :: Compression mode was not recorded in the file header");
+		}
+		for (std::size_t r = 0; r < records.size(); r++)
+		{
+			if (packed_rids[r].page_number == packed_rids[0].page_number)
+				continue;
+			if (packed_file.readPage(packed_rids[r].page_number).getRecord(packed_rids[r]) != records[r])
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+		}
+		PageId pages = 0;
+		for (FileIterator iter = packed_file.begin(); iter != packed_file.end(); ++iter)
+			pages++;
+		if (pages != packed_rids.back().page_number)
+		{
+			PRINT_ERROR("ERROR :: Iterator did not visit every page of the compressed file");
+		}
+	}
+	File::remove(plain_name);
+	File::remove(packed_name);
+	if (File::exists(File::pageMapFilename(packed_name)))
+	{
+		PRINT_ERROR("ERROR :: Page map was not removed with the file");
+	}
+
+	std::cout << "Test compression passed" << "\n";
+}
+
+void testScanIterator()
+{
+	const std::string scan_name = "test.scan";
+	try
+	{
+		File::remove(scan_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	std::vector<std::string> records;
+	for (int r = 0; r < 2000; r++)
+	{
+		sprintf(tmpbuf, "scan record %d", r);
+		records.push_back(tmpbuf);
+	}
+
+	{
+		File scan_file = File::create(scan_name);
+		BufMgr scanMgr(4);
+		std::vector<RecordId> rids;
+		const std::uint32_t num_pages = scanMgr.loadRecords(&scan_file, records, &rids);
+		//Leave a hole in the chain of used pages
+		scanMgr.disposePage(&scan_file, rids[0].page_number + 1);
+		//The file iterator reads from disk, so it must see what the pool holds
+		scanMgr.flushFile(&scan_file);
+
+		//Scan through a pool much smaller than the file
+		std::vector<std::string> scanned;
+		PageId pages = 0;
+		for (ScanIterator iter = scanMgr.scanBegin(&scan_file); iter != scanMgr.scanEnd(&scan_file); ++iter)
+		{
+			pages++;
+			for (PageIterator page_iter = iter->begin(); page_iter != iter->end(); ++page_iter)
+				scanned.push_back(*page_iter);
+		}
+
+		std::vector<std::string> expected;
+		for (FileIterator iter = scan_file.begin(); iter != scan_file.end(); ++iter)
+		{
+			Page current_page = *iter;
+			for (PageIterator page_iter = current_page.begin(); page_iter != current_page.end(); ++page_iter)
+				expected.push_back(*page_iter);
+		}
+		if (pages != num_pages - 1 || scanned != expected)
+		{
+			PRINT_ERROR("ERROR :: Scan through the buffer pool did not match the file iterator");
+		}
+
+		//Every pin taken by the scan has been released
+		try
+		{
+			scanMgr.flushFile(&scan_file);
+		}
+		catch(const PagePinnedException&)
+		{
+			PRINT_ERROR("ERROR :: Scan left a page pinned");
+		}
+
+		//Pages past the end of the file do not exist
+		try
+		{
+			scan_file.readPage(num_pages + 1);
+			PRINT_ERROR("ERROR :: Page past the end of the file should not be readable");
+		}
+		catch(const InvalidPageException&)
+		{
+		}
+	}
+	File::remove(scan_name);
+
+	std::cout << "Test scan iterator passed" << "\n";
+}
+
+void testParallelScan()
+{
+	const std::string scan_name = "test.pscan";
+	try
+	{
+		File::remove(scan_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	std::vector<std::string> records;
+	for (int r = 0; r < 5000; r++)
+	{
+		sprintf(tmpbuf, "parallel record %d", r);
+		records.push_back(tmpbuf);
+	}
+
+	{
+		File scan_file = File::create(scan_name);
+		BufMgr scanMgr(8);
+		std::vector<RecordId> rids;
+		const std::uint32_t num_pages = scanMgr.loadRecords(&scan_file, records, &rids);
+		//Free pages in the middle of the file are skipped
+		scanMgr.disposePage(&scan_file, rids[0].page_number + 2);
+		std::vector<std::string> expected;
+		for (std::size_t r = 0; r < records.size(); r++)
+		{
+			if (rids[r].page_number != rids[0].page_number + 2)
+				expected.push_back(records[r]);
+		}
+		std::sort(expected.begin(), expected.end());
+
+		//Small morsels so that every worker has several and stealing happens
+		ParallelScan scan(&scanMgr, &scan_file, 4, 2);
+		std::vector<std::vector<std::string> > seen(scan.num_threads());
+		scan.forEachRecord([&seen](unsigned worker, const RecordId& rid, const std::string& record)
+		{
+			seen[worker].push_back(record);
+		});
+		std::vector<std::string> scanned;
+		for (std::size_t w = 0; w < seen.size(); w++)
+			scanned.insert(scanned.end(), seen[w].begin(), seen[w].end());
+		std::sort(scanned.begin(), scanned.end());
+		if (scanned != expected)
+		{
+			PRINT_ERROR("ERROR :: Parallel scan did not return every record exactly once");
+		}
+
+		std::atomic<PageId> pages(0);
+		scan.forEachPage([&pages](unsigned worker, const Page& page)
+		{
+			pages++;
+		});
+		if (pages != num_pages - 1)
+		{
+			PRINT_ERROR("ERROR :: Parallel scan did not visit every used page");
+		}
+
+		//An exception thrown by a callback reaches the caller once the workers stop
+		try
+		{
+			scan.forEachPage([](unsigned worker, const Page& page)
+			{
+				throw std::runtime_error("callback failed");
+			});
+			PRINT_ERROR("ERROR :: Callback exception was not rethrown");
+		}
+		catch(const std::runtime_error&)
+		{
+		}
+
+		//No pins are left behind, even by the failed scan
+		try
+		{
+			scanMgr.flushFile(&scan_file);
+		}
+		catch(const PagePinnedException&)
+		{
+			PRINT_ERROR("ERROR :: Parallel scan left a page pinned");
+		}
+	}
+	File::remove(scan_name);
+
+	std::cout << "Test parallel scan passed" << "\n";
+}
+
+void testSlotScan()
+{
+	const PageFormat formats[] = {PageFormat::STANDARD, PageFormat::COMPACT};
+	for (int f = 0; f < 2; f++)
+	{
+		//Keep every k-th record for a range of densities, including full and nearly empty pages
+		for (int keep_every = 1; keep_every <= 40; keep_every += 3)
+		{
+			Page sparse_page(formats[f]);
+			std::vector<RecordId> rids;
+			while (sparse_page.hasSpaceForRecord("r"))
+				rids.push_back(sparse_page.insertRecord("r"));
+			std::vector<SlotId> expected;
+			for (std::size_t r = 0; r < rids.size(); r++)
+			{
+				if ((r * 7) % keep_every == 0)
+					expected.push_back(rids[r].slot_number);
+				else
+					sparse_page.deleteRecord(rids[r]);
+			}
+
+			std::vector<SlotId> iterated;
+			for (PageIterator iter = sparse_page.begin(); iter != sparse_page.end(); ++iter)
+				iterated.push_back(iter.record_id().slot_number);
+			std::vector<SlotId> collected;
+			sparse_page.getUsedSlots(collected);
+			if (iterated != expected || collected != expected)
+			{
+				PRINT_ERROR("ERROR :: Slot scan did not find exactly the used slots");
+			}
+
+			//Vector and portable searches agree from every starting slot
+			PageIterator probe = sparse_page.begin();
+			for (SlotId start = 0; start <= rids.size(); start++)
+			{
+				const SlotId vector_slot = probe.getNextUsedSlot(start);
+				std::vector<SlotId>::iterator next = std::upper_bound(expected.begin(), expected.end(), start);
+				const SlotId expected_slot = next == expected.end() ? Page::INVALID_SLOT : *next;
+				if (vector_slot != expected_slot)
+				{
+					PRINT_ERROR("ERROR :: Slot scan returned the wrong next used slot");
+				}
+			}
+		}
+	}
+
+	std::cout << "Test slot scan (" << SlotScan::implementation() << ") passed" << "\n";
+}
+
+void testPredicateScan()
+{
+	const std::string filter_name = "test.filter";
+	try
+	{
+		File::remove(filter_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	//Records are a 32-bit key, a tag and a run of x's of varying length
+	std::vector<std::string> records;
+	for (std::int32_t r = 0; r < 3000; r++)
+	{
+		sprintf(tmpbuf, "tag-%d-", r % 7);
+		records.push_back(std::string(reinterpret_cast<const char*>(&r), sizeof(r)) + tmpbuf + std::string(r % 37, 'x'));
+	}
+
+	//Each predicate paired with the same condition written against a copy of the record
+	std::vector<RecordPredicate> predicates;
+	std::vector<std::function<bool(const std::string&)> > conditions;
+	predicates.push_back(RecordPredicate::bytesAt(4, "tag-3-"));
+	conditions.push_back([](const std::string& record) { return record.compare(4, 6, "tag-3-") == 0; });
+	//Longer than a vector, so both whole and partial vectors are compared
+	predicates.push_back(RecordPredicate::bytesAt(4, "tag-5-" + std::string(20, 'x')));
+	conditions.push_back([](const std::string& record) { return record.compare(4, 26, "tag-5-" + std::string(20, 'x')) == 0; });
+	predicates.push_back(RecordPredicate::prefix(records[42].substr(0, 5)));
+	conditions.push_back([&records](const std::string& record) { return record.compare(0, 5, records[42], 0, 5) == 0; });
+	predicates.push_back(RecordPredicate::int32At(0, CompareOp::LESS, 100));
+	conditions.push_back([](const std::string& record) { std::int32_t key; memcpy(&key, record.data(), sizeof(key)); return key < 100; });
+	predicates.push_back(RecordPredicate::int32At(0, CompareOp::GREATER_EQUAL, 2990));
+	conditions.push_back([](const std::string& record) { std::int32_t key; memcpy(&key, record.data(), sizeof(key)); return key >= 2990; });
+	predicates.push_back(RecordPredicate::custom([](const RecordView& record) { return record.length % 2 == 0; }));
+	conditions.push_back([](const std::string& record) { return record.size() % 2 == 0; });
+	//Records too short for the bytes looked at never match
+	predicates.push_back(RecordPredicate::bytesAt(46, "x"));
+	conditions.push_back([](const std::string& record) { return false; });
+
+	//Views of matching records point into the page
+	Page page;
+	std::vector<RecordId> page_rids;
+	page.insertRecords(records, 0, &page_rids);
+	for (std::size_t p = 0; p < predicates.size(); p++)
+	{
+		std::vector<RecordId> matched;
+		std::vector<RecordView> views;
+		const std::size_t count = page.filterRecords(predicates[p], &matched, &views);
+		std::vector<RecordId> expected;
+		for (std::size_t r = 0; r < page_rids.size(); r++)
+		{
+			if (conditions[p](records[r]))
+				expected.push_back(page_rids[r]);
+		}
+		if (count != expected.size() || matched != expected || views.size() != expected.size())
+		{
+			PRINT_ERROR("ERROR :: Page filter did not return exactly the matching records");
+		}
+		for (std::size_t m = 0; m < views.size(); m++)
+		{
+			if (std::string(views[m].data, views[m].length) != page.getRecord(matched[m]))
+			{
+				PRINT_ERROR("ERROR :: Page filter returned a view of the wrong bytes");
+			}
+		}
+	}
+
+	{
+		File filter_file = File::create(filter_name);
+		BufMgr filterMgr(8);
+		std::vector<RecordId> rids;
+		filterMgr.loadRecords(&filter_file, records, &rids);
+		for (std::size_t p = 0; p < predicates.size(); p++)
+		{
+			std::vector<RecordId> expected;
+			for (std::size_t r = 0; r < records.size(); r++)
+			{
+				if (conditions[p](records[r]))
+					expected.push_back(rids[r]);
+			}
+
+			//Bulk loading fills pages in file order, which is also scan order
+			std::vector<RecordId> matched;
+			if (filterMgr.filterFile(&filter_file, predicates[p], matched) != expected.size() || matched != expected)
+			{
+				PRINT_ERROR("ERROR :: File filter did not return exactly the matching records");
+			}
+
+			ParallelScan scan(&filterMgr, &filter_file, 4, 2);
+			std::vector<std::vector<std::string> > seen(scan.num_threads());
+			scan.forEachMatch(predicates[p], [&seen](unsigned worker, const RecordId& rid, const RecordView& record)
+			{
+				seen[worker].push_back(std::string(record.data, record.length));
+			});
+			std::vector<std::string> scanned;
+			for (std::size_t w = 0; w < seen.size(); w++)
+				scanned.insert(scanned.end(), seen[w].begin(), seen[w].end());
+			std::vector<std::string> expected_records;
+			for (std::size_t r = 0; r < records.size(); r++)
+			{
+				if (conditions[p](records[r]))
+					expected_records.push_back(records[r]);
+			}
+			std::sort(scanned.begin(), scanned.end());
+			std::sort(expected_records.begin(), expected_records.end());
+			if (scanned != expected_records)
+			{
+				PRINT_ERROR("ERROR :: Parallel filter did not return exactly the matching records");
+			}
+		}
+		filterMgr.flushFile(&filter_file);
+	}
+	File::remove(filter_name);
+
+	std::cout << "Test predicate scan passed" << "\n";
+}
+
+void testZoneMap()
+{
+	const std::string zone_name = "test.zone";
+	try
+	{
+		File::remove(zone_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	//Records start with a 32-bit key and are loaded in key order
+	std::vector<std::string> records;
+	for (std::int32_t r = 0; r < 3000; r++)
+	{
+		sprintf(tmpbuf, "zone record %d", r);
+		records.push_back(std::string(reinterpret_cast<const char*>(&r), sizeof(r)) + tmpbuf);
+	}
+	const RecordPredicate low_keys = RecordPredicate::int32At(0, CompareOp::LESS, 100);
+	PageId last_page;
+
+	{
+		File zone_file = File::create(zone_name);
+		ZoneMap zones(zone_name, 0, ZoneKeyType::INT32);
+		BufMgr zoneMgr(8);
+		zoneMgr.setWriteBackHook(&zone_file, [&zones](const Page& page) { zones.summarize(page); });
+		std::vector<RecordId> rids;
+		const std::uint32_t num_pages = zoneMgr.loadRecords(&zone_file, records, &rids);
+		zoneMgr.flushFile(&zone_file);
+
+		//Every page written back has been summarized with its key range
+		for (std::size_t r = 0; r < rids.size(); r++)
+		{
+			const ZoneEntry entry = zones.entry(rids[r].page_number);
+			if (!entry.summarized || entry.min > static_cast<std::int64_t>(r) || entry.max < static_cast<std::int64_t>(r))
+			{
+				PRINT_ERROR("ERROR :: Zone map does not cover the keys of a page");
+			}
+		}
+
+		//Pages ruled out by the zone map are not read, and no match is lost
+		std::vector<RecordId> expected(rids.begin(), rids.begin() + 100);
+		std::vector<RecordId> matched;
+		zoneMgr.clearBufStats();
+		zoneMgr.filterFile(&zone_file, low_keys, matched, &zones);
+		if (matched != expected)
+		{
+			PRINT_ERROR("ERROR :: Zone map filter did not return exactly the matching records");
+		}
+		const PageId read_pages = rids[99].page_number - rids[0].page_number + 1;
+		if (static_cast<PageId>(zoneMgr.getBufStats().diskreads) != read_pages || read_pages >= num_pages)
+		{
+			PRINT_ERROR("ERROR :: Zone map filter did not skip the pages that cannot match");
+		}
+
+		ParallelScan scan(&zoneMgr, &zone_file, 4, 2);
+		std::atomic<std::size_t> parallel_matches(0);
+		scan.forEachMatch(low_keys, [&parallel_matches](unsigned worker, const RecordId& rid, const RecordView& record)
+		{
+			parallel_matches++;
+		}, &zones);
+		if (parallel_matches != expected.size())
+		{
+			PRINT_ERROR("ERROR :: Parallel zone map filter did not return exactly the matching records");
+		}
+
+		//A change not yet written back is still found, and its write-back updates the summary
+		const RecordId moved = rids[2500];
+		Page* page;
+		zoneMgr.readPage(&zone_file, moved.page_number, page);
+		const std::int32_t low_key = 5;
+		page->updateRecord(moved, std::string(reinterpret_cast<const char*>(&low_key), sizeof(low_key)) + "moved");
+		zoneMgr.unPinPage(&zone_file, moved.page_number, true);
+		matched.clear();
+		zoneMgr.filterFile(&zone_file, low_keys, matched, &zones);
+		if (matched.size() != expected.size() + 1 || matched.back() != moved)
+		{
+			PRINT_ERROR("ERROR :: Zone map filter skipped a page changed in the buffer pool");
+		}
+		zoneMgr.flushFile(&zone_file);
+		if (zones.entry(moved.page_number).min != low_key)
+		{
+			PRINT_ERROR("ERROR :: Write-back did not update the zone map");
+		}
+		matched.clear();
+		zoneMgr.filterFile(&zone_file, low_keys, matched, &zones);
+		if (matched.size() != expected.size() + 1)
+		{
+			PRINT_ERROR("ERROR :: Zone map filter lost a match after write-back");
+		}
+		zoneMgr.setWriteBackHook(&zone_file, BufMgr::WriteBackHook());
+		last_page = rids.back().page_number;
+	}
+
+	//Summaries persist for the same key and are dropped for a different one
+	{
+		ZoneMap reopened(zone_name, 0, ZoneKeyType::INT32);
+		if (!reopened.entry(1).summarized || reopened.mayMatch(last_page, low_keys))
+		{
+			PRINT_ERROR("ERROR :: Zone map summaries were not persisted");
+		}
+
+		//A page written without the zone map stops it from skipping pages
+		File zone_file = File::open(zone_name);
+		const Page last = zone_file.readPage(last_page);
+		zone_file.writePage(last);
+		if (!reopened.mayMatch(last_page, low_keys))
+		{
+			PRINT_ERROR("ERROR :: Zone map skipped a page after a write it did not summarize");
+		}
+	}
+	{
+		//and the summaries that missed it are dropped when the zone map is reopened
+		ZoneMap reopened(zone_name, 0, ZoneKeyType::INT32);
+		if (reopened.entry(1).summarized || !reopened.mayMatch(last_page, low_keys))
+		{
+			PRINT_ERROR("ERROR :: Zone map that missed a write was reused");
+		}
+
+		//Once pages are summarized again, they are skipped again
+		File zone_file = File::open(zone_name);
+		const Page last = zone_file.readPage(last_page);
+		zone_file.writePage(last);
+		reopened.summarize(last);
+		if (reopened.mayMatch(last_page, low_keys))
+		{
+			PRINT_ERROR("ERROR :: Zone map did not skip a page summarized after its write");
+		}
+	}
+	{
+		ZoneMap reopened(zone_name, 0, ZoneKeyType::INT32);
+		if (!reopened.entry(last_page).summarized)
+		{
+			PRINT_ERROR("ERROR :: Zone map summaries were not persisted once in sync");
+		}
+	}
+	{
+		ZoneMap rekeyed(zone_name, 0, ZoneKeyType::INT64);
+		if (rekeyed.entry(1).summarized)
+		{
+			PRINT_ERROR("ERROR :: Zone map of a different key was reused");
+		}
+	}
+
+	//Page writes of a file without a zone map are not counted
+	{
+		const std::string plain_name = "test.plain";
+		{
+			File plain_file = File::create(plain_name);
+			const Page plain = plain_file.allocatePage();
+			plain_file.writePage(plain);
+			if (plain_file.pageWrites() != 0)
+			{
+				PRINT_ERROR("ERROR :: Page writes of a file without a zone map were counted");
+			}
+		}
+		File::remove(plain_name);
+	}
+
+	File::remove(zone_name);
+	if (File::exists(File::zoneMapFilename(zone_name)))
+	{
+		PRINT_ERROR("ERROR :: Zone map was not removed with its file");
+	}
+
+	std::cout << "Test zone map passed" << "\n";
+}
+
+void testSampling()
+{
+	const std::string sample_name = "test.sample";
+	try
+	{
+		File::remove(sample_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	//Records grow with their key, so later pages hold fewer of them
+	std::vector<std::string> records;
+	for (std::int32_t r = 0; r < 3000; r++)
+	{
+		records.push_back(std::string(reinterpret_cast<const char*>(&r), sizeof(r)) + std::string(r / 20, 's'));
+	}
+
+	{
+		File sample_file = File::create(sample_name);
+		BufMgr sampleMgr(8);
+		std::vector<RecordId> rids;
+		sampleMgr.loadRecords(&sample_file, records, &rids);
+		//Free pages are never sampled
+		const PageId freed = rids[1500].page_number;
+		sampleMgr.disposePage(&sample_file, freed);
+		std::vector<PageId> used_pages;
+		double key_sum = 0;
+		std::size_t num_keys = 0;
+		for (std::size_t r = 0; r < rids.size(); r++)
+		{
+			if (rids[r].page_number == freed)
+				continue;
+			if (used_pages.empty() || used_pages.back() != rids[r].page_number)
+				used_pages.push_back(rids[r].page_number);
+			key_sum += r;
+			num_keys++;
+		}
+
+		//A large enough page sample visits every used page exactly once
+		FileSampler page_sampler(&sampleMgr, &sample_file, 1);
+		std::vector<PageId> sampled_pages;
+		const std::size_t num_sampled = page_sampler.samplePages(used_pages.size() + 10, [&sampled_pages](const Page& page)
+		{
+			sampled_pages.push_back(page.page_number());
+		});
+		std::sort(sampled_pages.begin(), sampled_pages.end());
+		if (num_sampled != used_pages.size() || sampled_pages != used_pages)
+		{
+			PRINT_ERROR("ERROR :: Page sample did not cover the used pages exactly once");
+		}
+
+		//Records are equally likely whatever the number of records on their page
+		FileSampler record_sampler(&sampleMgr, &sample_file, 2);
+		double sample_sum = 0;
+		bool views_match = true;
+		const std::size_t num_records = record_sampler.sampleRecords(4000, [&](const RecordId& rid, const RecordView& record)
+		{
+			std::int32_t key;
+			memcpy(&key, record.data, sizeof(key));
+			views_match = views_match && rids[key] == rid && std::string(record.data, record.length) == records[key];
+			sample_sum += key;
+		});
+		if (num_records != 4000 || !views_match)
+		{
+			PRINT_ERROR("ERROR :: Record sample returned the wrong records");
+		}
+		//The standard error of the sample mean is about 14 here
+		if (std::abs(sample_sum / num_records - key_sum / num_keys) > 70)
+		{
+			PRINT_ERROR("ERROR :: Record sample is not uniform over records");
+		}
+
+		//Samplers with the same seed draw the same sample
+		std::vector<PageId> first_draw;
+		std::vector<PageId> second_draw;
+		FileSampler first(&sampleMgr, &sample_file, 7);
+		first.samplePages(5, [&first_draw](const Page& page) { first_draw.push_back(page.page_number()); });
+		FileSampler second(&sampleMgr, &sample_file, 7);
+		second.samplePages(5, [&second_draw](const Page& page) { second_draw.push_back(page.page_number()); });
+		if (first_draw != second_draw)
+		{
+			PRINT_ERROR("ERROR :: Samplers with the same seed drew different samples");
+		}
+
+		//Sampling does not push a normally read page out of the pool
+		Page* kept;
+		sampleMgr.readPage(&sample_file, used_pages[0], kept);
+		sampleMgr.unPinPage(&sample_file, used_pages[0], false);
+		page_sampler.samplePages(used_pages.size(), [](const Page& page) {});
+		if (!sampleMgr.prefetchPage(&sample_file, used_pages[0]))
+		{
+			PRINT_ERROR("ERROR :: Sampling evicted a page in use");
+		}
+	}
+	File::remove(sample_name);
+
+	std::cout << "Test sampling passed" << "\n";
+}
+
+void testFileStats()
+{
+	const std::string stats_name = "test.stats";
+	try
+	{
+		File::remove(stats_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	std::vector<std::string> records;
+	for (int r = 0; r < 2000; r++)
+	{
+		sprintf(tmpbuf, "counted record %d", r);
+		records.push_back(tmpbuf);
+	}
+
+	FileStats last_stats;
+	{
+		File stats_file = File::create(stats_name);
+		//Statistics gathered the slow way, by reading every used page
+		auto scanned = [&stats_file]()
+		{
+			FileStats counted = {0, 0, 0, 0, 0, 0};
+			for (FileIterator iter = stats_file.begin(); iter != stats_file.end(); ++iter)
+			{
+				Page page = *iter;
+				counted.used_pages++;
+				for (PageIterator rec = page.begin(); rec != page.end(); ++rec)
+					counted.num_records++;
+				counted.free_bytes += page.getFreeSpace();
+			}
+			return counted;
+		};
+		auto matches = [&stats_file](const FileStats& counted, const std::uint64_t free_slots)
+		{
+			const FileStats stats = stats_file.stats();
+			return stats.used_pages == counted.used_pages && stats.num_records == counted.num_records &&
+				stats.free_bytes == counted.free_bytes && stats.free_slots == free_slots &&
+				stats.num_pages == stats.used_pages + stats.free_pages;
+		};
+
+		BufMgr statsMgr(8);
+		std::vector<RecordId> rids;
+		const std::uint32_t num_pages = statsMgr.loadRecords(&stats_file, records, &rids);
+		statsMgr.flushFile(&stats_file);
+		if (!matches(scanned(), 0) || stats_file.stats().used_pages != num_pages ||
+			stats_file.stats().num_records != records.size())
+		{
+			PRINT_ERROR("ERROR :: File statistics do not match the loaded records");
+		}
+
+		//Deleting records from the middle of pages leaves unused slots behind
+		std::uint64_t deleted = 0;
+		for (std::size_t r = 1; r < rids.size(); r += 10)
+		{
+			Page* page;
+			statsMgr.readPage(&stats_file, rids[r].page_number, page);
+			page->deleteRecord(rids[r]);
+			statsMgr.unPinPage(&stats_file, rids[r].page_number, true);
+			deleted++;
+		}
+		statsMgr.flushFile(&stats_file);
+		if (!matches(scanned(), deleted) || stats_file.stats().fragmentation() <= 0)
+		{
+			PRINT_ERROR("ERROR :: File statistics do not follow deleted records");
+		}
+
+		//Disposed pages and pages allocated in their place are accounted for
+		statsMgr.disposePage(&stats_file, rids[0].page_number);
+		std::uint64_t disposed_free_slots = 0;
+		for (std::size_t r = 1; r < rids.size(); r += 10)
+		{
+			if (rids[r].page_number != rids[0].page_number)
+				disposed_free_slots++;
+		}
+		if (!matches(scanned(), disposed_free_slots) || stats_file.stats().free_pages != 1)
+		{
+			PRINT_ERROR("ERROR :: File statistics do not follow disposed pages");
+		}
+		PageId new_page_number;
+		Page* new_page;
+		statsMgr.allocPage(&stats_file, new_page_number, new_page);
+		new_page->insertRecord("fresh record");
+		statsMgr.unPinPage(&stats_file, new_page_number, true);
+		statsMgr.flushFile(&stats_file);
+		if (!matches(scanned(), disposed_free_slots) || stats_file.stats().free_pages != 0)
+		{
+			PRINT_ERROR("ERROR :: File statistics do not follow allocated pages");
+		}
+		last_stats = stats_file.stats();
+	}
+
+	//Statistics persist in the file header
+	{
+		File reopened = File::open(stats_name);
+		const FileStats stats = reopened.stats();
+		if (stats.num_records != last_stats.num_records || stats.free_bytes != last_stats.free_bytes ||
+			stats.free_slots != last_stats.free_slots || stats.used_pages != last_stats.used_pages)
+		{
+			PRINT_ERROR("ERROR :: File statistics were not persisted");
+		}
+	}
+	File::remove(stats_name);
+
+	std::cout << "Test file statistics passed" << "\n";
+}
+
+void testLatchModes()
+{
+	const std::string latch_name = "test.latch";
+	try
+	{
+		File::remove(latch_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	{
+		File latch_file = File::create(latch_name);
+		BufMgr latchMgr(4);
+		PageId hot_page_number;
+		RecordId hot_rid;
+		{
+			Page* hot_page;
+			latchMgr.allocPage(&latch_file, hot_page_number, hot_page);
+			hot_rid = hot_page->insertRecord("00000000 00000000");
+			latchMgr.unPinPage(&latch_file, hot_page_number, true);
+		}
+
+		//The record holds a counter twice; writers change both copies, readers check they agree
+		auto readCounter = [&](const Page& page)
+		{
+			int first, second;
+			sscanf(page.getRecord(hot_rid).c_str(), "%d %d", &first, &second);
+			return first == second ? first : -1;
+		};
+		auto writeCounter = [&](Page& page, const int value)
+		{
+			sprintf(tmpbuf, "%08d %08d", value, value);
+			page.updateRecord(hot_rid, tmpbuf);
+		};
+
+		const int rounds = 200;
+		std::atomic<int> readers(0);
+		std::atomic<int> most_readers(0);
+		std::atomic<bool> torn(false);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; t++)
+		{
+			threads.push_back(std::thread([&]()
+			{
+				for (int r = 0; r < rounds / 10; r++)
+				{
+					Page* page;
+					latchMgr.readPage(&latch_file, hot_page_number, page, ReadHint::NORMAL, LatchMode::SHARED);
+					const int inside = ++readers;
+					int most = most_readers;
+					while (inside > most && !most_readers.compare_exchange_weak(most, inside))
+					{
+					}
+					if (readCounter(*page) < 0)
+						torn = true;
+					std::this_thread::sleep_for(std::chrono::microseconds(200));
+					readers--;
+					latchMgr.unPinPage(&latch_file, hot_page_number, false, LatchMode::SHARED);
+				}
+			}));
+		}
+		for (int t = 0; t < 2; t++)
+		{
+			threads.push_back(std::thread([&]()
+			{
+				for (int r = 0; r < rounds; r++)
+				{
+					Page* page;
+					latchMgr.readPage(&latch_file, hot_page_number, page, ReadHint::NORMAL, LatchMode::EXCLUSIVE);
+					if (readers != 0)
+						torn = true;
+					const int value = readCounter(*page);
+					std::this_thread::yield();
+					writeCounter(*page, value + 1);
+					latchMgr.unPinPage(&latch_file, hot_page_number, true, LatchMode::EXCLUSIVE);
+				}
+			}));
+			threads.push_back(std::thread([&]()
+			{
+				for (int r = 0; r < rounds; r++)
+				{
+					Page* page;
+					latchMgr.readPage(&latch_file, hot_page_number, page, ReadHint::NORMAL, LatchMode::UPGRADABLE);
+					const int value = readCounter(*page);
+					latchMgr.upgradeLatch(&latch_file, hot_page_number);
+					if (readers != 0)
+						torn = true;
+					writeCounter(*page, value + 1);
+					latchMgr.unPinPage(&latch_file, hot_page_number, true, LatchMode::EXCLUSIVE);
+				}
+			}));
+		}
+		for (std::size_t t = 0; t < threads.size(); t++)
+			threads[t].join();
+
+		if (torn)
+		{
+			PRINT_ERROR("ERROR :: A writer shared its latch with another thread");
+		}
+		if (most_readers < 2)
+		{
+			PRINT_ERROR("ERROR :: Readers did not share the latch");
+		}
+		Page* page;
+		latchMgr.readPage(&latch_file, hot_page_number, page);
+		if (readCounter(*page) != 4 * rounds)
+		{
+			PRINT_ERROR("ERROR :: Updates under exclusive latches were lost");
+		}
+		latchMgr.unPinPage(&latch_file, hot_page_number, false);
+
+		//Upgrading needs a pinned page
+		try
+		{
+			latchMgr.upgradeLatch(&latch_file, hot_page_number);
+			PRINT_ERROR("ERROR :: Latch of an unpinned page was upgraded");
+		}
+		catch(const PageNotPinnedException&)
+		{
+		}
+
+		//Every latch and pin was released
+		try
+		{
+			latchMgr.flushFile(&latch_file);
+		}
+		catch(const PagePinnedException&)
+		{
+			PRINT_ERROR("ERROR :: Latched page was left pinned");
+		}
+
+		//A page that is not buffered has no frame to report
+		try
+		{
+			latchMgr.upgradeLatch(&latch_file, hot_page_number);
+			PRINT_ERROR("ERROR :: Latch of an unbuffered page was upgraded");
+		}
+		catch(const PageNotPinnedException& e)
+		{
+			if (e.message().find("frame") != std::string::npos)
+			{
+				PRINT_ERROR("ERROR :: Unbuffered page was reported with a frame");
+			}
+		}
+	}
+	File::remove(latch_name);
+
+	std::cout << "Test latch modes passed" << "\n";
+}
+
+void testShardedPool()
+{
+	const std::string shard_name = "test.shard";
+	try
+	{
+		File::remove(shard_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	//Every shard keeps at least one frame
+	if (BufMgr(2, Page::SIZE, 8).getNumShards() != 2 || BufMgr(2, Page::SIZE, 0).getNumShards() != 1)
+	{
+		PRINT_ERROR("ERROR :: Pool has more shards than frames");
+	}
+
+	std::vector<std::string> records;
+	for (int r = 0; r < 4000; r++)
+	{
+		sprintf(tmpbuf, "sharded record %d", r);
+		records.push_back(tmpbuf);
+	}
+
+	{
+		File shard_file = File::create(shard_name);
+		BufMgr shardMgr(8, Page::SIZE, 4);
+		const std::uint32_t num_pages = shardMgr.loadRecords(&shard_file, records);
+		shardMgr.flushFile(&shard_file);
+
+		//Shards whose frames are all pinned steal from the others, so every frame of the pool can be pinned
+		for (PageId p = 1; p <= 8; p++)
+		{
+			Page* page;
+			shardMgr.readPage(&shard_file, p, page);
+		}
+		try
+		{
+			Page* page;
+			shardMgr.readPage(&shard_file, 9, page);
+			PRINT_ERROR("ERROR :: More pages pinned than the pool has frames");
+		}
+		catch(const BufferExceededException&)
+		{
+		}
+		for (PageId p = 1; p <= 8; p++)
+			shardMgr.unPinPage(&shard_file, p, false);
+
+		//Threads reading pages of all shards get the pages they asked for
+		shardMgr.clearBufStats();
+		const int reads = 500;
+		std::atomic<bool> wrong_page(false);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; t++)
+		{
+			threads.push_back(std::thread([&, t]()
+			{
+				for (int r = 0; r < reads; r++)
+				{
+					const PageId page_number = 1 + (r * 7 + t * 13) % num_pages;
+					Page* page;
+					shardMgr.readPage(&shard_file, page_number, page);
+					if (page->page_number() != page_number)
+						wrong_page = true;
+					shardMgr.unPinPage(&shard_file, page_number, false);
+				}
+			}));
+		}
+		for (std::size_t t = 0; t < threads.size(); t++)
+			threads[t].join();
+		if (wrong_page)
+		{
+			PRINT_ERROR("ERROR :: Sharded pool returned the wrong page");
+		}
+
+		//Pool statistics add up the shards'
+		int accesses = 0;
+		int busy_shards = 0;
+		for (std::uint32_t s = 0; s < shardMgr.getNumShards(); s++)
+		{
+			accesses += shardMgr.getShardStats(s).accesses;
+			if (shardMgr.getShardStats(s).accesses > 0)
+				busy_shards++;
+		}
+		if (shardMgr.getBufStats().accesses != 4 * reads || accesses != 4 * reads || busy_shards < 2)
+		{
+			PRINT_ERROR("ERROR :: Shard statistics do not add up");
+		}
+
+		try
+		{
+			shardMgr.flushFile(&shard_file);
+		}
+		catch(const PagePinnedException&)
+		{
+			PRINT_ERROR("ERROR :: Sharded pool left a page pinned");
+		}
+	}
+	File::remove(shard_name);
+
+	std::cout << "Test sharded pool passed" << "\n";
+}
+
+void testConcurrentFile()
+{
+	const std::string concurrent_name = "test.concurrent";
+	try
+	{
+		File::remove(concurrent_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	{
+		File concurrent_file = File::create(concurrent_name);
+		const PageId owned_pages = 40;
+		for (PageId p = 0; p < owned_pages; p++)
+		{
+			Page new_page = concurrent_file.allocatePage();
+			sprintf(tmpbuf, "page %05u round %05d", new_page.page_number(), 0);
+			new_page.insertRecord(tmpbuf);
+			concurrent_file.writePage(new_page);
+		}
+
+		//Writers rewrite their own pages while other threads allocate pages through another File object
+		const int rounds = 50;
+		const int allocations = 20;
+		std::atomic<bool> wrong_page(false);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; t++)
+		{
+			threads.push_back(std::thread([&, t]()
+			{
+				char record[100];
+				for (int r = 1; r <= rounds; r++)
+				{
+					for (PageId p = 1 + t; p <= owned_pages; p += 4)
+					{
+						Page page = concurrent_file.readPage(p);
+						PageIterator rec = page.begin();
+						sprintf(record, "page %05u round %05d", p, r - 1);
+						if (*rec != record)
+							wrong_page = true;
+						sprintf(record, "page %05u round %05d", p, r);
+						page.updateRecord(rec.record_id(), record);
+						concurrent_file.writePage(page);
+					}
+				}
+			}));
+		}
+		for (int t = 0; t < 2; t++)
+		{
+			threads.push_back(std::thread([&]()
+			{
+				File same_file = File::open(concurrent_name);
+				for (int a = 0; a < allocations; a++)
+				{
+					Page new_page = same_file.allocatePage();
+					new_page.insertRecord("allocated concurrently");
+					same_file.writePage(new_page);
+				}
+			}));
+		}
+		for (std::size_t t = 0; t < threads.size(); t++)
+			threads[t].join();
+		if (wrong_page)
+		{
+			PRINT_ERROR("ERROR :: Concurrent reads returned the wrong page");
+		}
+
+		//The used list holds every page once, and no update was lost
+		std::vector<PageId> used;
+		for (FileIterator iter = concurrent_file.begin(); iter != concurrent_file.end(); ++iter)
+		{
+			Page page = *iter;
+			used.push_back(page.page_number());
+			if (page.page_number() <= owned_pages)
+			{
+				sprintf(tmpbuf, "page %05u round %05d", page.page_number(), rounds);
+				if (*page.begin() != tmpbuf)
+					PRINT_ERROR("ERROR :: Concurrent page write was lost");
+			}
+		}
+		std::vector<PageId> expected;
+		for (PageId p = 1; p <= owned_pages + 2 * allocations; p++)
+			expected.push_back(p);
+		const FileStats stats = concurrent_file.stats();
+		if (used != expected || stats.used_pages != expected.size() || stats.num_records != expected.size())
+		{
+			PRINT_ERROR("ERROR :: Concurrent allocations corrupted the file");
+		}
+	}
+	File::remove(concurrent_name);
+
+	std::cout << "Test concurrent file passed" << "\n";
+}
+
+void testLockFreeHashTbl()
+{
+	const std::string table_name = "test.lockfree";
+	try
+	{
+		File::remove(table_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	{
+		File table_file = File::create(table_name);
+		LockFreeBufHashTbl table(13);
+
+		//Stable entries stay in the table throughout
+		const PageId stable_pages = 100;
+		for (PageId p = 1; p <= stable_pages; p++)
+			table.insert(&table_file, p, p);
+		try
+		{
+			table.insert(&table_file, 1, 7);
+			PRINT_ERROR("ERROR :: Page inserted twice into the lock-free table");
+		}
+		catch(const HashAlreadyPresentException&)
+		{
+		}
+		try
+		{
+			table.remove(&table_file, stable_pages + 1);
+			PRINT_ERROR("ERROR :: Missing page removed from the lock-free table");
+		}
+		catch(const HashNotFoundException&)
+		{
+		}
+
+		//Writers race to insert and remove the same few pages while readers look up the stable ones
+		const PageId first_churn = 1000;
+		const PageId churn_pages = 16;
+		const int operations = 3000;
+		std::atomic<int> present(0);
+		std::atomic<bool> wrong_entry(false);
+		std::atomic<int> writers_left(2);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 2; t++)
+		{
+			threads.push_back(std::thread([&, t]()
+			{
+				for (int o = 0; o < operations; o++)
+				{
+					const PageId page_number = first_churn + (o * 5 + t) % churn_pages;
+					try
+					{
+						if ((o + t) % 2 == 0)
+						{
+							table.insert(&table_file, page_number, page_number + 1);
+							present++;
+						}
+						else
+						{
+							table.remove(&table_file, page_number);
+							present--;
+						}
+					}
+					catch(const HashAlreadyPresentException&)
+					{
+					}
+					catch(const HashNotFoundException&)
+					{
+					}
+				}
+				writers_left--;
+			}));
+		}
+		for (int t = 0; t < 2; t++)
+		{
+			threads.push_back(std::thread([&, t]()
+			{
+				do
+				{
+					for (PageId p = 1; p <= stable_pages; p++)
+					{
+						FrameId frame;
+						if (!table.find(&table_file, p, frame) || frame != p)
+							wrong_entry = true;
+					}
+					for (PageId p = first_churn; p < first_churn + churn_pages; p++)
+					{
+						FrameId frame;
+						if (table.find(&table_file, p, frame) && frame != p + 1)
+							wrong_entry = true;
+					}
+				} while (writers_left > 0);
+			}));
+		}
+		for (std::size_t t = 0; t < threads.size(); t++)
+			threads[t].join();
+		if (wrong_entry)
+		{
+			PRINT_ERROR("ERROR :: Lock-free table lookup returned a wrong or missing entry");
+		}
+
+		//Every successful insert and remove took effect exactly once
+		int found = 0;
+		for (PageId p = first_churn; p < first_churn + churn_pages; p++)
+		{
+			FrameId frame;
+			if (table.find(&table_file, p, frame))
+				found++;
+		}
+		if (found != present)
+		{
+			PRINT_ERROR("ERROR :: Lock-free table lost an insert or remove");
+		}
+
+		//A pool built on the lock-free table behaves like one on the chained table
+		std::vector<std::string> records;
+		for (int r = 0; r < 2000; r++)
+		{
+			sprintf(tmpbuf, "lock-free record %d", r);
+			records.push_back(tmpbuf);
+		}
+		BufMgr lockFreeMgr(8, Page::SIZE, 2, PageTableType::LOCK_FREE);
+		const std::uint32_t num_pages = lockFreeMgr.loadRecords(&table_file, records);
+		lockFreeMgr.flushFile(&table_file);
+		for (PageId p = 1; p <= num_pages; p++)
+		{
+			Page* page;
+			lockFreeMgr.readPage(&table_file, p, page);
+			if (page->page_number() != p || !lockFreeMgr.prefetchPage(&table_file, p))
+				PRINT_ERROR("ERROR :: Pool on the lock-free table lost a page");
+			lockFreeMgr.unPinPage(&table_file, p, false);
+		}
+	}
+	File::remove(table_name);
+
+	std::cout << "Test lock-free hash table passed" << "\n";
+}
+
+void testAsyncRead()
+{
+	const std::string async_name = "test.async";
+	try
+	{
+		File::remove(async_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	{
+		File async_file = File::create(async_name);
+		std::vector<std::string> records;
+		for (int r = 0; r < 2000; r++)
+		{
+			sprintf(tmpbuf, "async record %d", r);
+			records.push_back(tmpbuf);
+		}
+		BufMgr asyncMgr(8);
+		const std::uint32_t num_pages = asyncMgr.loadRecords(&async_file, records);
+		asyncMgr.flushFile(&async_file);
+		if (num_pages < 4)
+		{
+			PRINT_ERROR("ERROR :: Too few pages for the async read test");
+		}
+
+		//A buffered page is handed over before readPageAsync returns
+		Page* page;
+		asyncMgr.readPage(&async_file, 1, page);
+		asyncMgr.unPinPage(&async_file, 1, false);
+		EventLoop loop(2);
+		bool handed_over = false;
+		if (!asyncMgr.readPageAsync(&async_file, 1, loop, [&](Page* page, std::exception_ptr error)
+			{
+				handed_over = page != NULL && page->page_number() == 1 && !error;
+				asyncMgr.unPinPage(&async_file, 1, false);
+			}) || !handed_over)
+		{
+			PRINT_ERROR("ERROR :: Buffered page was not handed over at once");
+		}
+
+		//Missing pages are handed over on the loop's thread, including reads issued from a callback
+		const std::thread::id loop_thread = std::this_thread::get_id();
+		std::vector<PageId> handed;
+		bool wrong_page = false;
+		std::function<void(Page*, std::exception_ptr)> collect = [&](Page* page, std::exception_ptr error)
+		{
+			if (page == NULL || error || std::this_thread::get_id() != loop_thread)
+			{
+				wrong_page = true;
+				return;
+			}
+			const PageId page_number = page->page_number();
+			handed.push_back(page_number);
+			asyncMgr.unPinPage(&async_file, page_number, false);
+			if (page_number == 2)
+				asyncMgr.readPageAsync(&async_file, 4, loop, collect);
+		};
+		for (PageId p = 2; p <= 3; p++)
+		{
+			if (asyncMgr.readPageAsync(&async_file, p, loop, collect))
+				PRINT_ERROR("ERROR :: Page not yet read was handed over at once");
+		}
+		loop.run();
+		std::sort(handed.begin(), handed.end());
+		if (wrong_page || handed != std::vector<PageId>({2, 3, 4}))
+		{
+			PRINT_ERROR("ERROR :: Async reads handed over the wrong pages");
+		}
+
+		//A failed read hands over its exception
+		bool failed = false;
+		asyncMgr.readPageAsync(&async_file, num_pages + 10, loop, [&](Page* page, std::exception_ptr error)
+		{
+			try
+			{
+				if (error)
+					std::rethrow_exception(error);
+			}
+			catch(const InvalidPageException&)
+			{
+				failed = page == NULL;
+			}
+		});
+		loop.run();
+		if (!failed)
+		{
+			PRINT_ERROR("ERROR :: Failed async read did not report its exception");
+		}
+	}
+	File::remove(async_name);
+
+	std::cout << "Test async read passed" << "\n";
+}
+
+void testInFlightRead()
+{
+	const std::string flight_name = "test.inflight";
+	try
+	{
+		File::remove(flight_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	{
+		File flight_file = File::create(flight_name);
+		std::vector<std::string> records;
+		for (int r = 0; r < 2000; r++)
+		{
+			sprintf(tmpbuf, "in-flight record %d", r);
+			records.push_back(tmpbuf);
+		}
+		BufMgr flightMgr(4);
+		const std::uint32_t num_pages = flightMgr.loadRecords(&flight_file, records);
+		flightMgr.flushFile(&flight_file);
+
+		//Threads missing on the same page at once share a single read of it
+		const int rounds = 20;
+		std::atomic<bool> wrong_page(false);
+		for (int r = 0; r < rounds; r++)
+		{
+			const PageId page_number = 1 + r % num_pages;
+			std::atomic<int> ready(0);
+			std::vector<std::thread> threads;
+			for (int t = 0; t < 4; t++)
+			{
+				threads.push_back(std::thread([&]()
+				{
+					ready++;
+					while (ready < 4)
+						std::this_thread::yield();
+					Page* page;
+					flightMgr.readPage(&flight_file, page_number, page);
+					if (page->page_number() != page_number)
+						wrong_page = true;
+					flightMgr.unPinPage(&flight_file, page_number, false);
+				}));
+			}
+			for (std::size_t t = 0; t < threads.size(); t++)
+				threads[t].join();
+			flightMgr.flushFile(&flight_file);
+		}
+		if (wrong_page)
+		{
+			PRINT_ERROR("ERROR :: Waiting on an in-flight read returned the wrong page");
+		}
+		if (flightMgr.getBufStats().diskreads != rounds + (int) num_pages)
+		{
+			PRINT_ERROR("ERROR :: A page missed on by several threads was read more than once");
+		}
+
+		//Threads waiting on a read that fails see it fail too, and the frame is freed
+		const PageId free_page = num_pages;
+		flightMgr.disposePage(&flight_file, free_page);
+		std::atomic<int> failures(0);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; t++)
+		{
+			threads.push_back(std::thread([&]()
+			{
+				try
+				{
+					Page* page;
+					flightMgr.readPage(&flight_file, free_page, page);
+				}
+				catch(const InvalidPageException&)
+				{
+					failures++;
+				}
+			}));
+		}
+		for (std::size_t t = 0; t < threads.size(); t++)
+			threads[t].join();
+		if (failures != 4)
+		{
+			PRINT_ERROR("ERROR :: Failed in-flight read was not reported to every reader");
+		}
+		for (PageId p = 1; p <= 4; p++)
+		{
+			Page* page;
+			flightMgr.readPage(&flight_file, p, page);
+		}
+		for (PageId p = 1; p <= 4; p++)
+			flightMgr.unPinPage(&flight_file, p, false);
+	}
+	File::remove(flight_name);
+
+	std::cout << "Test in-flight read passed" << "\n";
+}
+
+void testFrameCache()
+{
+	const std::string cache_name = "test.framecache";
+	try
+	{
+		File::remove(cache_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	{
+		File cache_file = File::create(cache_name);
+		std::vector<std::string> records;
+		for (int r = 0; r < 4000; r++)
+		{
+			sprintf(tmpbuf, "frame cache record %d", r);
+			records.push_back(tmpbuf);
+		}
+		BufMgr cacheMgr(8, Page::SIZE, 2);
+		const std::uint32_t num_pages = cacheMgr.loadRecords(&cache_file, records);
+		cacheMgr.flushFile(&cache_file);
+		cacheMgr.setFrameCache(true);
+
+		//Repeat pins are counted as accesses and update the page in the pool
+		cacheMgr.clearBufStats();
+		Page* page;
+		RecordId rid;
+		for (int r = 0; r < 3; r++)
+		{
+			cacheMgr.readPage(&cache_file, 1, page);
+			rid = page->begin().record_id();
+			page->updateRecord(rid, "cached update");
+			cacheMgr.unPinPage(&cache_file, 1, true);
+		}
+		if (cacheMgr.getBufStats().accesses != 3 || cacheMgr.getBufStats().diskreads != 1)
+		{
+			PRINT_ERROR("ERROR :: Frame cache pins were miscounted");
+		}
+		cacheMgr.flushFile(&cache_file);
+		if (cache_file.readPage(1).getRecord(rid) != "cached update")
+		{
+			PRINT_ERROR("ERROR :: Page unpinned dirty through the frame cache was not written back");
+		}
+
+		//Entries of flushed, evicted and disposed pages are not used
+		cacheMgr.readPage(&cache_file, 1, page);
+		cacheMgr.unPinPage(&cache_file, 1, false);
+		for (PageId p = 2; p <= num_pages; p++)
+		{
+			cacheMgr.readPage(&cache_file, p, page);
+			cacheMgr.unPinPage(&cache_file, p, false);
+		}
+		cacheMgr.readPage(&cache_file, 1, page);
+		if (page->page_number() != 1)
+		{
+			PRINT_ERROR("ERROR :: Frame cache returned the frame of an evicted page");
+		}
+		cacheMgr.unPinPage(&cache_file, 1, false);
+		cacheMgr.disposePage(&cache_file, 1);
+		try
+		{
+			cacheMgr.readPage(&cache_file, 1, page);
+			PRINT_ERROR("ERROR :: Frame cache returned the frame of a disposed page");
+		}
+		catch(const InvalidPageException&)
+		{
+		}
+
+		//Threads re-pinning hot pages through their caches while another evicts keep getting the right pages
+		const PageId hot_pages = 4;
+		std::atomic<bool> wrong_page(false);
+		std::atomic<bool> done(false);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 3; t++)
+		{
+			threads.push_back(std::thread([&, t]()
+			{
+				for (int r = 0; r < 3000; r++)
+				{
+					const PageId page_number = 2 + (r + t) % hot_pages;
+					Page* page;
+					cacheMgr.readPage(&cache_file, page_number, page, ReadHint::NORMAL, LatchMode::SHARED);
+					if (page->page_number() != page_number)
+						wrong_page = true;
+					cacheMgr.unPinPage(&cache_file, page_number, false, LatchMode::SHARED);
+				}
+			}));
+		}
+		threads.push_back(std::thread([&]()
+		{
+			for (int r = 0; r < 300; r++)
+			{
+				const PageId page_number = 2 + hot_pages + r % (num_pages - 1 - hot_pages);
+				Page* page;
+				try
+				{
+					cacheMgr.readPage(&cache_file, page_number, page, ReadHint::NORMAL, LatchMode::EXCLUSIVE);
+				}
+				catch(const BufferExceededException&)
+				{
+					continue;
+				}
+				if (page->page_number() != page_number)
+					wrong_page = true;
+				cacheMgr.unPinPage(&cache_file, page_number, false, LatchMode::EXCLUSIVE);
+			}
+		}));
+		for (std::size_t t = 0; t < threads.size(); t++)
+			threads[t].join();
+		if (wrong_page)
+		{
+			PRINT_ERROR("ERROR :: Frame cache returned the wrong page under eviction");
+		}
+		cacheMgr.flushFile(&cache_file);
+	}
+	File::remove(cache_name);
+
+	std::cout << "Test frame cache passed" << "\n";
+}
+
+void testHugePagePool()
+{
+	const std::string huge_name = "test.hugepages";
+	try
+	{
+		File::remove(huge_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	//Pools only use an arena when asked, and get some backing for it wherever they run
+	if (BufMgr(4).getFrameBacking() != ArenaBacking::HEAP)
+	{
+		PRINT_ERROR("ERROR :: Pool not asked for huge pages has an arena");
+	}
+
+	{
+		File huge_file = File::create(huge_name, Page::DEFAULT_FORMAT, 4096);
+		std::vector<std::string> records;
+		for (int r = 0; r < 3000; r++)
+		{
+			sprintf(tmpbuf, "huge page record %d", r);
+			records.push_back(tmpbuf);
+		}
+		BufMgr hugeMgr(8, 4096, 2, PageTableType::CHAINED, true);
+		if (hugeMgr.getFrameBacking() == ArenaBacking::HEAP)
+		{
+			PRINT_ERROR("ERROR :: Pool asked for huge pages has no arena");
+		}
+
+		//Frames in the arena hold pages like any others, and copies of them are independent
+		const std::uint32_t num_pages = hugeMgr.loadRecords(&huge_file, records);
+		Page* page;
+		hugeMgr.readPage(&huge_file, 1, page);
+		const Page copy = *page;
+		const RecordId rid = page->begin().record_id();
+		page->updateRecord(rid, "arena update");
+		hugeMgr.unPinPage(&huge_file, 1, true);
+		if (copy.getRecord(rid) != "huge page record 0")
+		{
+			PRINT_ERROR("ERROR :: Copy of a page in the arena shares its data");
+		}
+		hugeMgr.flushFile(&huge_file);
+		std::size_t found = 0;
+		for (PageId p = 1; p <= num_pages; p++)
+		{
+			hugeMgr.readPage(&huge_file, p, page);
+			for (PageIterator it = page->begin(); it != page->end(); ++it)
+				found++;
+			hugeMgr.unPinPage(&huge_file, p, false);
+		}
+		if (found != records.size() || huge_file.readPage(1).getRecord(rid) != "arena update")
+		{
+			PRINT_ERROR("ERROR :: Pages read through an arena pool came back wrong");
+		}
+		hugeMgr.flushFile(&huge_file);
+	}
+	File::remove(huge_name);
+
+	std::cout << "Test huge page pool passed" << "\n";
+}
+
+void testResizePool()
+{
+	const std::string resize_name = "test.resize";
+	try
+	{
+		File::remove(resize_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	{
+		File resize_file = File::create(resize_name);
+		std::vector<std::string> records;
+		for (int r = 0; r < 6000; r++)
+		{
+			sprintf(tmpbuf, "resize record %d", r);
+			records.push_back(tmpbuf);
+		}
+		BufMgr resizeMgr(8, Page::SIZE, 2, PageTableType::LOCK_FREE);
+		resizeMgr.setFrameCache(true);
+		const std::uint32_t num_pages = resizeMgr.loadRecords(&resize_file, records);
+		resizeMgr.flushFile(&resize_file);
+
+		//Growing keeps the pages already buffered, and the new frames hold the rest of the file
+		Page* page;
+		for (PageId p = 1; p <= 4; p++)
+		{
+			resizeMgr.readPage(&resize_file, p, page);
+			resizeMgr.unPinPage(&resize_file, p, false);
+		}
+		resizeMgr.clearBufStats();
+		resizeMgr.resize(64);
+		if (resizeMgr.getNumBufs() != 64)
+		{
+			PRINT_ERROR("ERROR :: Pool did not grow to the size asked for");
+		}
+		for (PageId p = 1; p <= 4; p++)
+		{
+			resizeMgr.readPage(&resize_file, p, page);
+			resizeMgr.unPinPage(&resize_file, p, false);
+		}
+		if (resizeMgr.getBufStats().diskreads != 0)
+		{
+			PRINT_ERROR("ERROR :: Growing the pool dropped buffered pages");
+		}
+		for (int pass = 0; pass < 2; pass++)
+		{
+			for (PageId p = 1; p <= num_pages; p++)
+			{
+				resizeMgr.readPage(&resize_file, p, page);
+				resizeMgr.unPinPage(&resize_file, p, false);
+			}
+		}
+		if (resizeMgr.getBufStats().diskreads != (int) num_pages - 4)
+		{
+			PRINT_ERROR("ERROR :: Grown pool does not hold the whole file");
+		}
+
+		//Shrinking leaves pinned pages in place and gives up their frames once they are unpinned
+		Page* pinned;
+		resizeMgr.readPage(&resize_file, 1, pinned);
+		resizeMgr.readPage(&resize_file, 2, page);
+		resizeMgr.resize(2);
+		if (resizeMgr.getNumBufs() != 2 || !resizeMgr.prefetchPage(&resize_file, 1))
+		{
+			PRINT_ERROR("ERROR :: Shrinking the pool dropped a pinned page");
+		}
+		const RecordId rid = pinned->begin().record_id();
+		pinned->updateRecord(rid, "resized");
+		resizeMgr.unPinPage(&resize_file, 1, true);
+		resizeMgr.unPinPage(&resize_file, 2, false);
+		for (PageId p = 3; p <= num_pages; p++)
+		{
+			resizeMgr.readPage(&resize_file, p, page);
+			resizeMgr.unPinPage(&resize_file, p, false);
+		}
+		std::vector<PageId> pins;
+		try
+		{
+			for (PageId p = 1; p <= 3; p++)
+			{
+				resizeMgr.readPage(&resize_file, p, page);
+				pins.push_back(p);
+			}
+			PRINT_ERROR("ERROR :: Shrunk pool kept frames it was to give up");
+		}
+		catch(const BufferExceededException&)
+		{
+		}
+		for (std::size_t i = 0; i < pins.size(); i++)
+			resizeMgr.unPinPage(&resize_file, pins[i], false);
+		resizeMgr.flushFile(&resize_file);
+		if (resize_file.readPage(1).getRecord(rid) != "resized")
+		{
+			PRINT_ERROR("ERROR :: Page dirtied across a shrink was not written back");
+		}
+
+		//Readers keep getting the right pages while the pool is resized under them
+		std::atomic<bool> resizing(true);
+		std::atomic<int> wrong(0);
+		std::vector<std::thread> readers;
+		for (int t = 0; t < 3; t++)
+		{
+			readers.push_back(std::thread([&, t]()
+			{
+				Page* page;
+				for (int r = 0; resizing || r < 200; r++)
+				{
+					const PageId p = 1 + (r * 7 + t) % num_pages;
+					resizeMgr.prefetchPage(&resize_file, p);
+					try
+					{
+						resizeMgr.readPage(&resize_file, p, page);
+					}
+					catch(const BufferExceededException&)
+					{
+						continue;
+					}
+					if (page->page_number() != p)
+						wrong++;
+					resizeMgr.unPinPage(&resize_file, p, false);
+				}
+			}));
+		}
+		for (int r = 0; r < 40; r++)
+			resizeMgr.resize(r % 2 == 0 ? 32 : 4);
+		resizing = false;
+		for (int t = 0; t < 3; t++)
+			readers[t].join();
+		if (wrong != 0)
+		{
+			PRINT_ERROR("ERROR :: Reader got the wrong page while the pool was resized");
+		}
+		resizeMgr.flushFile(&resize_file);
+	}
+	File::remove(resize_name);
+
+	std::cout << "Test resize pool passed" << "\n";
+}
+
+void testIncrementalRehash()
+{
+	const std::string rehash_name = "test.rehash";
+	try
+	{
+		File::remove(rehash_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	{
+		File rehash_file = File::create(rehash_name);
+		BufHashTbl table(7);
+
+		//Every page stays findable while the table grows a few buckets at a time
+		const PageId num_entries = 2000;
+		bool missing = false;
+		for (PageId p = 1; p <= num_entries; p++)
+		{
+			table.insert(&rehash_file, p, p + 1);
+			FrameId frame;
+			if (!table.find(&rehash_file, p / 2 + 1, frame) || frame != p / 2 + 2)
+				missing = true;
+		}
+		try
+		{
+			table.insert(&rehash_file, 1, 9);
+			PRINT_ERROR("ERROR :: Page inserted twice into a rehashing table");
+		}
+		catch(const HashAlreadyPresentException&)
+		{
+		}
+		PageTableStats stats = table.getStats();
+		if (missing || stats.entries != num_entries || stats.buckets < num_entries || stats.loadFactor() > 1)
+		{
+			PRINT_ERROR("ERROR :: Table did not grow with its entries");
+		}
+		if (stats.averageProbe() < 1 || stats.longestProbe < 1 || stats.averageProbe() > stats.longestProbe)
+		{
+			PRINT_ERROR("ERROR :: Table reported impossible probe lengths");
+		}
+
+		//Removing the pages shrinks it back to the size it was made with
+		for (PageId p = 1; p <= num_entries; p++)
+		{
+			table.remove(&rehash_file, p);
+			FrameId frame;
+			if (p < num_entries && !table.find(&rehash_file, (p + num_entries + 1) / 2, frame))
+				missing = true;
+		}
+		for (int i = 0; i < 100; i++)
+		{
+			FrameId frame;
+			table.find(&rehash_file, 1, frame);
+		}
+		stats = table.getStats();
+		if (missing || stats.entries != 0 || stats.buckets != 7 || stats.pendingBuckets != 0 || stats.totalProbes != 0)
+		{
+			PRINT_ERROR("ERROR :: Table did not shrink with its entries");
+		}
+
+		//A pool grown past its tables' size keeps them short
+		BufMgr rehashMgr(4, Page::SIZE, 2);
+		std::vector<std::string> records;
+		for (int r = 0; r < 20000; r++)
+		{
+			sprintf(tmpbuf, "rehash record %d", r);
+			records.push_back(tmpbuf);
+		}
+		rehashMgr.resize(64);
+		const std::uint32_t num_pages = rehashMgr.loadRecords(&rehash_file, records);
+		stats = rehashMgr.getPageTableStats();
+		if (num_pages < 20 || stats.entries != num_pages || stats.loadFactor() > 1)
+		{
+			PRINT_ERROR("ERROR :: Page tables of a grown pool did not grow");
+		}
+		rehashMgr.flushFile(&rehash_file);
+	}
+	File::remove(rehash_name);
+
+	std::cout << "Test incremental rehash passed" << "\n";
+}
+
+void testNodePool()
+{
+	const std::string pool_name = "test.nodepool";
+	try
+	{
+		File::remove(pool_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	{
+		File pool_file = File::create(pool_name);
+
+		//A table drawing on a pool runs out of entries with the pool, and reuses the ones it frees
+		NodePool<hashBucket> nodes(4);
+		{
+			BufHashTbl table(7, &nodes);
+			for (PageId p = 1; p <= 4; p++)
+				table.insert(&pool_file, p, p);
+			try
+			{
+				table.insert(&pool_file, 5, 5);
+				PRINT_ERROR("ERROR :: Table took an entry from an empty node pool");
+			}
+			catch(const BufferExceededException&)
+			{
+			}
+			FrameId frame;
+			if (nodes.available() != 0 || table.find(&pool_file, 5, frame))
+			{
+				PRINT_ERROR("ERROR :: Failed insert changed the table or its node pool");
+			}
+			table.remove(&pool_file, 2);
+			table.insert(&pool_file, 5, 5);
+			if (!table.find(&pool_file, 5, frame) || frame != 5 || table.find(&pool_file, 2, frame))
+			{
+				PRINT_ERROR("ERROR :: Table lost track of pages in a reused entry");
+			}
+		}
+		NodePool<hashBucket> other;
+		if (nodes.available() != 4 || !nodes.give(other) || nodes.available() != 3 || other.available() != 1)
+		{
+			PRINT_ERROR("ERROR :: Node pool miscounted its free nodes");
+		}
+
+		//Shards stealing frames from each other carry entries along and keep reading pages right
+		std::vector<std::string> records;
+		for (int r = 0; r < 8000; r++)
+		{
+			sprintf(tmpbuf, "node pool record %d", r);
+			records.push_back(tmpbuf);
+		}
+		BufMgr poolMgr(6, Page::SIZE, 3);
+		const std::uint32_t num_pages = poolMgr.loadRecords(&pool_file, records);
+		bool wrong = false;
+		for (int round = 0; round < 50; round++)
+		{
+			std::vector<PageId> pinned;
+			for (PageId p = 0; p < 4; p++)
+			{
+				const PageId page_number = 1 + (round * 3 + p * 5) % num_pages;
+				if (std::find(pinned.begin(), pinned.end(), page_number) != pinned.end())
+					continue;
+				Page* page;
+				try
+				{
+					poolMgr.readPage(&pool_file, page_number, page);
+				}
+				catch(const BufferExceededException&)
+				{
+					continue;
+				}
+				if (page->page_number() != page_number)
+					wrong = true;
+				pinned.push_back(page_number);
+			}
+			for (std::size_t i = 0; i < pinned.size(); i++)
+				poolMgr.unPinPage(&pool_file, pinned[i], false);
+		}
+		if (wrong)
+		{
+			PRINT_ERROR("ERROR :: Pool with node pools returned the wrong page");
+		}
+		poolMgr.flushFile(&pool_file);
+	}
+	File::remove(pool_name);
+
+	std::cout << "Test node pool passed" << "\n";
+}
+
+void testClockSweep()
+{
+	const std::string clock_name = "test.clock";
+	try
+	{
+		File::remove(clock_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	{
+		File clock_file = File::create(clock_name);
+		//Two full words of refbits and pinned bits and part of a third
+		const PageId num_frames = 130;
+		BufMgr clockMgr(num_frames, Page::SIZE, 1);
+		clockMgr.setFrameCache(true);
+		Page* page;
+		PageId pageNo;
+		for (PageId p = 1; p <= num_frames + 40; p++)
+		{
+			clockMgr.allocPage(&clock_file, pageNo, page);
+			clockMgr.unPinPage(&clock_file, pageNo, true);
+		}
+		clockMgr.flushFile(&clock_file);
+
+		//Pages used since the clock last came by are passed over for the ones that were not
+		for (PageId p = 1; p <= num_frames + 1; p++)
+		{
+			clockMgr.readPage(&clock_file, p, page);
+			clockMgr.unPinPage(&clock_file, p, false);
+		}
+		int cold = 0;
+		std::vector<PageId> hot;
+		for (PageId p = 1; p <= num_frames; p++)
+		{
+			if (!clockMgr.prefetchPage(&clock_file, p))
+				continue;
+			if (p % 13 == 0)
+			{
+				cold++;
+				continue;
+			}
+			clockMgr.readPage(&clock_file, p, page);
+			clockMgr.unPinPage(&clock_file, p, false);
+			hot.push_back(p);
+		}
+		clockMgr.clearBufStats();
+		for (int i = 0; i < cold; i++)
+		{
+			clockMgr.readPage(&clock_file, num_frames + 2 + i, page);
+			clockMgr.unPinPage(&clock_file, num_frames + 2 + i, false);
+		}
+		for (std::size_t i = 0; i < hot.size(); i++)
+		{
+			clockMgr.readPage(&clock_file, hot[i], page);
+			clockMgr.unPinPage(&clock_file, hot[i], false);
+		}
+		if (clockMgr.getBufStats().diskreads != cold)
+		{
+			PRINT_ERROR("ERROR :: Clock evicted a page used since it last came by");
+		}
+
+		//Pinned frames are skipped, and the clock gives up once every frame is pinned
+		for (PageId p = 1; p < num_frames; p++)
+		{
+			clockMgr.readPage(&clock_file, p, page);
+		}
+		for (PageId p = num_frames + 1; p <= num_frames + 40; p++)
+		{
+			clockMgr.readPage(&clock_file, p, page);
+			clockMgr.unPinPage(&clock_file, p, false);
+		}
+		for (PageId p = 1; p < num_frames; p++)
+		{
+			if (!clockMgr.prefetchPage(&clock_file, p))
+			{
+				PRINT_ERROR("ERROR :: Clock evicted a pinned page");
+			}
+		}
+		clockMgr.readPage(&clock_file, num_frames, page);
+		try
+		{
+			clockMgr.readPage(&clock_file, num_frames + 1, page);
+			PRINT_ERROR("ERROR :: Clock took a frame while every frame was pinned");
+		}
+		catch(const BufferExceededException&)
+		{
+		}
+		for (PageId p = 1; p <= num_frames; p++)
+		{
+			clockMgr.unPinPage(&clock_file, p, false);
+		}
+	}
+	File::remove(clock_name);
+
+	std::cout << "Test clock sweep passed" << "\n";
+}
+
+void testPoolRegistry()
+{
+	const std::string hot_name = "test.hot";
+	const std::string log_name = "test.log";
+	try
+	{
+		File::remove(hot_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+	try
+	{
+		File::remove(log_name);
+	}
+	catch(const FileNotFoundException&)
+	{
+	}
+
+	{
+		File hot_file = File::create(hot_name);
+		File log_file = File::create(log_name);
+		PoolRegistry registry(16);
+		BufMgr& keep = registry.addPool("keep", 8);
+		BufMgr& recycle = registry.addPool("recycle", 4, ReplacementPolicy::RECYCLE);
+		try
+		{
+			registry.addPool("keep", 8);
+			PRINT_ERROR("ERROR :: Two pools were added under one name");
+		}
+		catch(const PoolExistsException&)
+		{
+		}
+		try
+		{
+			registry.bindFile(&hot_file, "missing");
+			PRINT_ERROR("ERROR :: File was bound to a pool that does not exist");
+		}
+		catch(const PoolNotFoundException&)
+		{
+		}
+		if (&registry.pool(PoolRegistry::kDefaultPool) != &registry.poolOf(&hot_file) ||
+				recycle.getReplacementPolicy() != ReplacementPolicy::RECYCLE)
+		{
+			PRINT_ERROR("ERROR :: Pool registry was not set up as asked");
+		}
+
+		//Pages of a bound file go to its pool only
+		registry.bindFile(&hot_file, "keep");
+		registry.bindFile(&log_file, "recycle");
+		Page* page;
+		PageId pageNo;
+		for (int i = 0; i < 6; i++)
+		{
+			registry.allocPage(&hot_file, pageNo, page);
+			registry.unPinPage(&hot_file, pageNo, true);
+		}
+		for (int i = 0; i < 40; i++)
+		{
+			registry.allocPage(&log_file, pageNo, page);
+			page->insertRecord("log entry");
+			registry.unPinPage(&log_file, pageNo, true);
+		}
+		if (keep.getBufStats().accesses != 6 || recycle.getBufStats().accesses != 40 ||
+				registry.pool(PoolRegistry::kDefaultPool).getBufStats().accesses != 0)
+		{
+			PRINT_ERROR("ERROR :: Pages went to a pool their file is not bound to");
+		}
+
+		//Scanning the log, even over and over, leaves the hot pages buffered
+		for (PageId p = 1; p <= 6; p++)
+		{
+			registry.readPage(&hot_file, p, page);
+			registry.unPinPage(&hot_file, p, false);
+		}
+		keep.clearBufStats();
+		for (int pass = 0; pass < 3; pass++)
+		{
+			for (PageId p = 1; p <= 40; p++)
+			{
+				registry.readPage(&log_file, p, page);
+				registry.unPinPage(&log_file, p, false);
+			}
+		}
+		for (PageId p = 1; p <= 6; p++)
+		{
+			registry.readPage(&hot_file, p, page);
+			registry.unPinPage(&hot_file, p, false);
+		}
+		if (keep.getBufStats().diskreads != 0)
+		{
+			PRINT_ERROR("ERROR :: Log scan pushed hot pages out of their pool");
+		}
+
+		//A recycle pool of 4 frames keeps the last 4 pages read, however often earlier ones were hit
+		registry.flushFile(&log_file);
+		for (PageId p = 1; p <= 40; p++)
+		{
+			for (int hit = 0; hit < 3; hit++)
+			{
+				registry.readPage(&log_file, p, page);
+				registry.unPinPage(&log_file, p, false);
+			}
+		}
+		for (PageId p = 1; p <= 40; p++)
+		{
+			if (recycle.prefetchPage(&log_file, p) != (p > 36))
+			{
+				PRINT_ERROR("ERROR :: Recycle pool did not keep exactly the last pages read");
+			}
+		}
+
+		//Rebinding a file writes its pages back and moves it, unless one is pinned
+		registry.readPage(&hot_file, 1, page);
+		const RecordId rid = page->insertRecord("rebound");
+		try
+		{
+			registry.bindFile(&hot_file, PoolRegistry::kDefaultPool);
+			PRINT_ERROR("ERROR :: File with a pinned page was rebound");
+		}
+		catch(const PagePinnedException&)
+		{
+		}
+		registry.unPinPage(&hot_file, 1, true);
+		registry.bindFile(&hot_file, PoolRegistry::kDefaultPool);
+		if (&registry.poolOf(&hot_file) != &registry.pool(PoolRegistry::kDefaultPool) ||
+				keep.prefetchPage(&hot_file, 1) || hot_file.readPage(1).getRecord(rid) != "rebound")
+		{
+			PRINT_ERROR("ERROR :: Rebound file was not moved out of its pool");
+		}
+		registry.readPage(&hot_file, 1, page);
+		registry.unPinPage(&hot_file, 1, false);
+		if (registry.pool(PoolRegistry::kDefaultPool).getBufStats().diskreads != 1)
+		{
+			PRINT_ERROR("ERROR :: Rebound file was not read into its new pool");
+		}
+
+		registry.unbindFile(&hot_file);
+		registry.unbindFile(&log_file);
+		if (&registry.poolOf(&log_file) != &registry.pool(PoolRegistry::kDefaultPool))
+		{
+			PRINT_ERROR("ERROR :: Unbound file was left in its pool");
+		}
+	}
+	File::remove(hot_name);
+	File::remove(log_name);
+
+	std::cout << "Test pool registry passed" << "\n";
+}
+
+void testZoneMapEviction()
+{
+	const std::string race_name = "test.zonerace";
+	const std::string cold_name = "test.zonecold";
+	for (const std::string& name : {race_name, cold_name})
+	{
+		try
+		{
+			File::remove(name);
+		}
+		catch(const FileNotFoundException&)
+		{
+		}
+	}
+
+	//Records start with a 32-bit key and are loaded in key order
+	std::vector<std::string> records;
+	for (std::int32_t r = 0; r < 20000; r++)
+	{
+		sprintf(tmpbuf, "zone race record %d", r);
+		records.push_back(std::string(reinterpret_cast<const char*>(&r), sizeof(r)) + tmpbuf);
+	}
+	const std::int32_t low_key = 5;
+	const RecordPredicate low_keys = RecordPredicate::int32At(0, CompareOp::LESS, 100);
+
+	{
+		File race_file = File::create(race_name);
+		File cold_file = File::create(cold_name);
+		for (int p = 0; p < 256; p++)
+		{
+			cold_file.allocatePage();
+		}
+		ZoneMap zones(race_name, 0, ZoneKeyType::INT32);
+		BufMgr raceMgr(64, Page::SIZE, 2, PageTableType::LOCK_FREE);
+		raceMgr.setWriteBackHook(&race_file, [&zones](const Page& page) { zones.summarize(page); });
+		std::vector<RecordId> rids;
+		raceMgr.loadRecords(&race_file, records, &rids);
+		raceMgr.flushFile(&race_file);
+
+		//The first record of every page past the low keys is moved to a low key
+		std::vector<std::size_t> moved;
+		for (std::size_t r = 100; r < rids.size(); r++)
+		{
+			if (rids[r].page_number != rids[r - 1].page_number)
+			{
+				moved.push_back(r);
+			}
+		}
+
+		//Reading the cold file evicts the pages left dirty while the scans run
+		std::atomic<bool> done(false);
+		std::thread evictor([&]()
+		{
+			while (!done)
+			{
+				for (FileIterator it = cold_file.begin(); it != cold_file.end() && !done; ++it)
+				{
+					Page* page;
+					raceMgr.readPage(&cold_file, (*it).page_number(), page);
+					raceMgr.unPinPage(&cold_file, (*it).page_number(), false);
+				}
+			}
+		});
+
+		ParallelScan scan(&raceMgr, &race_file, 2, 2);
+		for (int round = 0; round < 48; round++)
+		{
+			for (std::size_t m = 0; m < moved.size(); m++)
+			{
+				const std::size_t r = moved[m];
+				Page* page;
+				raceMgr.readPage(&race_file, rids[r].page_number, page, ReadHint::NORMAL, LatchMode::EXCLUSIVE);
+				page->updateRecord(rids[r], std::string(reinterpret_cast<const char*>(&low_key), sizeof(low_key)) + records[r].substr(sizeof(low_key)));
+				raceMgr.unPinPage(&race_file, rids[r].page_number, true, LatchMode::EXCLUSIVE);
+			}
+
+			std::vector<RecordId> matched;
+			if (round % 2 == 0)
+			{
+				raceMgr.filterFile(&race_file, low_keys, matched, &zones);
+			}
+			else
+			{
+				std::mutex matchedMutex;
+				scan.forEachMatch(low_keys, [&matched, &matchedMutex](unsigned worker, const RecordId& rid, const RecordView& record)
+				{
+					std::lock_guard<std::mutex> lock(matchedMutex);
+					matched.push_back(rid);
+				}, &zones);
+			}
+			if (matched.size() != 100 + moved.size())
+			{
+				PRINT_ERROR("ERROR :: Zone map filter skipped a page being evicted dirty");
+			}
+
+			//Moved back, so the next round's pages are summarized as not matching before they change
+			for (std::size_t m = 0; m < moved.size(); m++)
+			{
+				const std::size_t r = moved[m];
+				Page* page;
+				raceMgr.readPage(&race_file, rids[r].page_number, page, ReadHint::NORMAL, LatchMode::EXCLUSIVE);
+				page->updateRecord(rids[r], records[r]);
+				raceMgr.unPinPage(&race_file, rids[r].page_number, true, LatchMode::EXCLUSIVE);
+			}
+			raceMgr.flushFile(&race_file);
+		}
+		done = true;
+		evictor.join();
+		raceMgr.flushFile(&cold_file);
+		raceMgr.setWriteBackHook(&race_file, BufMgr::WriteBackHook());
+	}
+	File::remove(race_name);
+	File::remove(cold_name);
+
+	std::cout << "Test zone map eviction passed" << "\n";
+}
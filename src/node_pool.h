@@ -0,0 +1,129 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace badgerdb {
+
+/**
+ * @brief Pool of equal-sized nodes carved out of slabs allocated in advance,
+ * so that taking and returning nodes never goes to the global allocator.
+ *
+ * Nodes are taken from a free list and returned to it.  The pool only grows
+ * when reserve() is called; once the free list is empty, allocate() returns
+ * null.  Free nodes can be moved to another pool with give().  A slab stays
+ * with the pool that allocated it, so pools trading nodes must be destroyed
+ * together, once none of their nodes is in use.
+ *
+ * allocate() hands out uninitialized memory for a T; T must be trivially
+ * destructible, since deallocate() does not destroy it.
+ *
+ * Not thread-safe.
+ */
+template <typename T>
+class NodePool {
+ public:
+  /**
+   * @param nodes  Number of nodes to allocate up front.
+   * @throws  std::bad_alloc  If the nodes cannot be allocated.
+   */
+  explicit NodePool(const std::size_t nodes = 0)
+      : free_(nullptr), available_(0) {
+    reserve(nodes);
+  }
+
+  ~NodePool() {
+    for (std::size_t s = 0; s < slabs_.size(); s++) {
+      ::operator delete(slabs_[s]);
+    }
+  }
+
+  /**
+   * Adds a slab of <nodes> nodes to the free list.
+   *
+   * @throws  std::bad_alloc  If the slab cannot be allocated.
+   */
+  void reserve(const std::size_t nodes) {
+    if (nodes == 0) {
+      return;
+    }
+    slabs_.reserve(slabs_.size() + 1);
+    Slot* slab = static_cast<Slot*>(::operator new(nodes * sizeof(Slot)));
+    slabs_.push_back(slab);
+    // Linked backwards so that nodes are handed out in address order
+    for (std::size_t n = nodes; n > 0; n--) {
+      slab[n - 1].next = free_;
+      free_ = &slab[n - 1];
+    }
+    available_ += nodes;
+  }
+
+  /**
+   * Returns memory for a T, or null if no node is free.
+   */
+  T* allocate() {
+    if (free_ == nullptr) {
+      return nullptr;
+    }
+    Slot* slot = free_;
+    free_ = slot->next;
+    available_--;
+    return reinterpret_cast<T*>(slot);
+  }
+
+  /**
+   * Returns a node taken from this pool, or given to it, to the free list.
+   */
+  void deallocate(T* node) {
+    Slot* slot = reinterpret_cast<Slot*>(node);
+    slot->next = free_;
+    free_ = slot;
+    available_++;
+  }
+
+  /**
+   * Moves a free node to <other>.
+   *
+   * @return  False if no node is free.
+   */
+  bool give(NodePool& other) {
+    T* node = allocate();
+    if (node == nullptr) {
+      return false;
+    }
+    other.deallocate(node);
+    return true;
+  }
+
+  /**
+   * Returns the number of free nodes.
+   */
+  std::size_t available() const { return available_; }
+
+ private:
+  static_assert(std::is_trivially_destructible<T>::value,
+                "nodes are never destroyed");
+
+  union Slot {
+    Slot* next;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  };
+
+  Slot* free_;
+  std::size_t available_;
+  std::vector<Slot*> slabs_;
+
+  NodePool(const NodePool&);
+  NodePool& operator=(const NodePool&);
+};
+
+}
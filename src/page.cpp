@@ -13,21 +13,71 @@
 #include "exceptions/slot_in_use_exception.h"
 #include "page_iterator.h"
 #include "page.h"
+#include "record_predicate.h"
+#include "slot_scan.h"
 
 namespace badgerdb {
 
 Page::Page() {
-  initialize();
+  initialize(DEFAULT_FORMAT, SIZE);
+}
+
+Page::Page(const PageFormat format) {
+  initialize(format, SIZE);
+}
+
+Page::Page(const PageFormat format, const std::size_t size) {
+  assert(isValidSize(size));
+  initialize(format, size);
+}
+
+Page::Page(const PageFormat format, const std::size_t size, FrameArena* arena)
+    : data_(ArenaAllocator<char>(arena)) {
+  assert(isValidSize(size));
+  initialize(format, size);
 }
 
 void Page::initialize() {
+  initialize(header_.format, page_size());
+}
+
+void Page::initialize(const PageFormat format) {
+  initialize(format, page_size());
+}
+
+void Page::initialize(const PageFormat format, const std::size_t size) {
+  const std::size_t data_size = size - sizeof(PageHeader);
   header_.free_space_lower_bound = 0;
-  header_.free_space_upper_bound = DATA_SIZE;
+  header_.free_space_upper_bound = data_size;
   header_.num_slots = 0;
   header_.num_free_slots = 0;
   header_.current_page_number = INVALID_NUMBER;
   header_.next_page_number = INVALID_NUMBER;
-  data_.assign(DATA_SIZE, char());
+  header_.format = format;
+  header_.flags = 0;
+  header_.checksum = 0;
+  data_.assign(data_size, char());
+}
+
+void Page::prefetch() const {
+  const std::size_t kCacheLine = 64;
+  const std::size_t kMaxLines = 4;
+  __builtin_prefetch(&header_);
+  const char* data = data_.data();
+  // Slot directory grows up from the start of the data area.
+  const std::size_t directory_end = header_.free_space_lower_bound;
+  for (std::size_t offset = 0;
+       offset < directory_end && offset < kMaxLines * kCacheLine;
+       offset += kCacheLine) {
+    __builtin_prefetch(data + offset);
+  }
+  // Records grow down from the end of the data area; the newest start here.
+  for (std::size_t offset = header_.free_space_upper_bound;
+       offset < data_.size() && offset < header_.free_space_upper_bound +
+                                         kMaxLines * kCacheLine;
+       offset += kCacheLine) {
+    __builtin_prefetch(data + offset);
+  }
 }
 
 RecordId Page::insertRecord(const std::string& record_data) {
@@ -40,18 +90,105 @@ RecordId Page::insertRecord(const std::string& record_data) {
   return {page_number(), slot_number};
 }
 
+std::size_t Page::insertRecords(const std::vector<std::string>& records,
+                                const std::size_t start,
+                                std::vector<RecordId>* record_ids) {
+  // Unused slots are always reused before new ones are allocated, so a
+  // single forward scan over the slot array finds every reusable slot.
+  SlotId free_slot_cursor = 1;
+  std::size_t index = start;
+  for (; index < records.size(); ++index) {
+    const std::string& record_data = records[index];
+    SlotId slot_number;
+    if (header_.num_free_slots > 0) {
+      if (record_data.length() > getFreeSpace()) {
+        break;
+      }
+      while (isSlotUsed(free_slot_cursor)) {
+        ++free_slot_cursor;
+      }
+      slot_number = free_slot_cursor;
+      --header_.num_free_slots;
+    } else {
+      if (record_data.length() + slotSize() > getFreeSpace()) {
+        break;
+      }
+      slot_number = ++header_.num_slots;
+      header_.free_space_lower_bound = slotSize() * header_.num_slots;
+    }
+
+    PageSlot slot;
+    slot.used = true;
+    slot.item_length = record_data.length();
+    slot.item_offset = header_.free_space_upper_bound - slot.item_length;
+    setSlot(slot_number, slot);
+    header_.free_space_upper_bound = slot.item_offset;
+    record_data.copy(&data_[slot.item_offset], slot.item_length);
+
+    if (record_ids != NULL) {
+      const RecordId record_id = {page_number(), slot_number};
+      record_ids->push_back(record_id);
+    }
+  }
+  return index - start;
+}
+
 std::string Page::getRecord(const RecordId& record_id) const {
   validateRecordId(record_id);
-  const PageSlot& slot = getSlot(record_id.slot_number);
-  return data_.substr(slot.item_offset, slot.item_length);
+  const PageSlot slot = getSlot(record_id.slot_number);
+  return std::string(data_.data() + slot.item_offset, slot.item_length);
+}
+
+RecordView Page::getRecordView(const RecordId& record_id) const {
+  validateRecordId(record_id);
+  const PageSlot slot = getSlot(record_id.slot_number);
+  const RecordView view = {data_.data() + slot.item_offset, slot.item_length};
+  return view;
+}
+
+std::size_t Page::filterRecords(const RecordPredicate& predicate,
+                                std::vector<RecordId>* record_ids,
+                                std::vector<RecordView>* views) const {
+  const char* data = data_.data();
+  std::size_t count = 0;
+  for (SlotId slot_number = SlotScan::findNextUsed(
+           data, header_.format, INVALID_SLOT, header_.num_slots);
+       slot_number != INVALID_SLOT;
+       slot_number = SlotScan::findNextUsed(data, header_.format, slot_number,
+                                            header_.num_slots)) {
+    const PageSlot slot = getSlot(slot_number);
+    const RecordView record = {data + slot.item_offset, slot.item_length};
+    // The rest of the page follows the record, so byte compares can read
+    // past its end.
+    if (!predicate.evaluate(record, data_.size() - slot.item_offset)) {
+      continue;
+    }
+    ++count;
+    if (record_ids != NULL) {
+      const RecordId record_id = {page_number(), slot_number};
+      record_ids->push_back(record_id);
+    }
+    if (views != NULL) {
+      views->push_back(record);
+    }
+  }
+  return count;
+}
+
+std::size_t Page::getUsedSlots(std::vector<SlotId>& slot_numbers) const {
+  slot_numbers.resize(header_.num_slots);
+  const std::size_t count = SlotScan::collectUsed(
+      data_.data(), header_.format, header_.num_slots, slot_numbers.data());
+  slot_numbers.resize(count);
+  return count;
 }
 
 void Page::updateRecord(const RecordId& record_id,
                         const std::string& record_data) {
   validateRecordId(record_id);
-  const PageSlot* slot = getSlot(record_id.slot_number);
+  const PageSlot slot = getSlot(record_id.slot_number);
   const std::size_t free_space_after_delete =
-      getFreeSpace() + slot->item_length;
+      getFreeSpace() + slot.item_length;
   if (record_data.length() > free_space_after_delete) {
     throw InsufficientSpaceException(
         page_number(), record_data.length(), free_space_after_delete);
@@ -70,35 +207,35 @@ void Page::deleteRecord(const RecordId& record_id) {
 void Page::deleteRecord(const RecordId& record_id,
                         const bool allow_slot_compaction) {
   validateRecordId(record_id);
-  PageSlot* slot = getSlot(record_id.slot_number);
-  data_.replace(slot->item_offset, slot->item_length, slot->item_length, '\0');
+  const PageSlot slot = getSlot(record_id.slot_number);
+  data_.replace(slot.item_offset, slot.item_length, slot.item_length, '\0');
 
   // Compact the data by removing the hole left by this record (if necessary).
-  std::uint16_t move_offset = slot->item_offset; 
+  std::uint16_t move_offset = slot.item_offset; 
   std::size_t move_bytes = 0;
   for (SlotId i = 1; i <= header_.num_slots; ++i) {
-    PageSlot* other_slot = getSlot(i);
-    if (other_slot->used && other_slot->item_offset < slot->item_offset) {
-      if (other_slot->item_offset < move_offset) {
-        move_offset = other_slot->item_offset;
+    PageSlot other_slot = getSlot(i);
+    if (other_slot.used && other_slot.item_offset < slot.item_offset) {
+      if (other_slot.item_offset < move_offset) {
+        move_offset = other_slot.item_offset;
       }
-      move_bytes += other_slot->item_length;
+      move_bytes += other_slot.item_length;
       // Update the slot for the other data to reflect the soon-to-be-new
       // location.
-      other_slot->item_offset += slot->item_length;
+      other_slot.item_offset += slot.item_length;
+      setSlot(i, other_slot);
     }
   }
   // If we have data to move, shift it to the right.
   if (move_bytes > 0) {
-    const std::string& data_to_move = data_.substr(move_offset, move_bytes);
-    data_.replace(move_offset + slot->item_length, move_bytes, data_to_move);
+    const Data data_to_move = data_.substr(move_offset, move_bytes);
+    data_.replace(move_offset + slot.item_length, move_bytes, data_to_move);
   }
-  header_.free_space_upper_bound += slot->item_length;
+  header_.free_space_upper_bound += slot.item_length;
 
   // Mark slot as unused.
-  slot->used = false;
-  slot->item_offset = 0;
-  slot->item_length = 0;
+  const PageSlot unused_slot = {false, 0, 0};
+  setSlot(record_id.slot_number, unused_slot);
   ++header_.num_free_slots;
 
   if (allow_slot_compaction && record_id.slot_number == header_.num_slots) {
@@ -107,8 +244,7 @@ void Page::deleteRecord(const RecordId& record_id,
     int num_slots_to_delete = 1;
     for (SlotId i = 1; i < header_.num_slots; ++i) {
       // Traverse list backwards, looking for unused slots.
-      const PageSlot* other_slot = getSlot(header_.num_slots - i);
-      if (!other_slot->used) {
+      if (!isSlotUsed(header_.num_slots - i)) {
         ++num_slots_to_delete;
       } else {
         // Stop at the first used slot we find, since we can't move used slots
@@ -118,26 +254,56 @@ void Page::deleteRecord(const RecordId& record_id,
     }
     header_.num_slots -= num_slots_to_delete;
     header_.num_free_slots -= num_slots_to_delete;
-    header_.free_space_lower_bound -= sizeof(PageSlot) * num_slots_to_delete;
+    header_.free_space_lower_bound -= slotSize() * num_slots_to_delete;
   }
 }
 
 bool Page::hasSpaceForRecord(const std::string& record_data) const {
   std::size_t record_size = record_data.length();
   if (header_.num_free_slots == 0) {
-    record_size += sizeof(PageSlot);
+    record_size += slotSize();
   }
   return record_size <= getFreeSpace();
 }
 
-PageSlot* Page::getSlot(const SlotId slot_number) {
-  return reinterpret_cast<PageSlot*>(
-      &data_[(slot_number - 1) * sizeof(PageSlot)]);
+PageSlot Page::getSlot(const SlotId slot_number) const {
+  PageSlot slot;
+  if (header_.format == PageFormat::COMPACT) {
+    const CompactPageSlot* compact_slot =
+        reinterpret_cast<const CompactPageSlot*>(
+            &data_[(slot_number - 1) * sizeof(CompactPageSlot)]);
+    slot.used = compact_slot->item_offset != 0;
+    slot.item_offset = compact_slot->item_offset;
+    slot.item_length = compact_slot->item_length;
+  } else {
+    slot = *reinterpret_cast<const PageSlot*>(
+        &data_[(slot_number - 1) * sizeof(PageSlot)]);
+  }
+  return slot;
 }
 
-const PageSlot& Page::getSlot(const SlotId slot_number) const {
-  return *reinterpret_cast<const PageSlot*>(
-      &data_[(slot_number - 1) * sizeof(PageSlot)]);
+bool Page::isSlotUsed(const SlotId slot_number) const {
+  if (header_.format == PageFormat::COMPACT) {
+    return reinterpret_cast<const CompactPageSlot*>(
+        &data_[(slot_number - 1) * sizeof(CompactPageSlot)])->item_offset != 0;
+  }
+  return reinterpret_cast<const PageSlot*>(
+      &data_[(slot_number - 1) * sizeof(PageSlot)])->used;
+}
+
+void Page::setSlot(const SlotId slot_number, const PageSlot& slot) {
+  if (header_.format == PageFormat::COMPACT) {
+    // Records always start past the slot directory, so a used slot never has
+    // a zero offset.
+    assert(!slot.used || slot.item_offset != 0);
+    CompactPageSlot* compact_slot = reinterpret_cast<CompactPageSlot*>(
+        &data_[(slot_number - 1) * sizeof(CompactPageSlot)]);
+    compact_slot->item_offset = slot.used ? slot.item_offset : 0;
+    compact_slot->item_length = slot.used ? slot.item_length : 0;
+  } else {
+    *reinterpret_cast<PageSlot*>(
+        &data_[(slot_number - 1) * sizeof(PageSlot)]) = slot;
+  }
 }
 
 SlotId Page::getAvailableSlot() {
@@ -145,8 +311,7 @@ SlotId Page::getAvailableSlot() {
   if (header_.num_free_slots > 0) {
     // Have an allocated but unused slot that we can reuse.
     for (SlotId i = 1; i <= header_.num_slots; ++i) {
-      const PageSlot* slot = getSlot(i);
-      if (!slot->used) {
+      if (!isSlotUsed(i)) {
         // We don't decrement the number of free slots until someone actually
         // puts data in the slot.
         slot_number = i;
@@ -158,7 +323,7 @@ SlotId Page::getAvailableSlot() {
     slot_number = header_.num_slots + 1;
     ++header_.num_slots;
     ++header_.num_free_slots;
-    header_.free_space_lower_bound = sizeof(PageSlot) * header_.num_slots;
+    header_.free_space_lower_bound = slotSize() * header_.num_slots;
   }
   assert(slot_number != INVALID_SLOT);
   return static_cast<SlotId>(slot_number);
@@ -170,25 +335,26 @@ void Page::insertRecordInSlot(const SlotId slot_number,
       slot_number == INVALID_SLOT) {
     throw InvalidSlotException(page_number(), slot_number);
   }
-  PageSlot* slot = getSlot(slot_number);
-  if (slot->used) {
+  if (isSlotUsed(slot_number)) {
     throw SlotInUseException(page_number(), slot_number);
   }
   const int record_length = record_data.length();
-  slot->used = true;
-  slot->item_length = record_length;
-  slot->item_offset = header_.free_space_upper_bound - record_length;
-  header_.free_space_upper_bound = slot->item_offset;
+  PageSlot slot;
+  slot.used = true;
+  slot.item_length = record_length;
+  slot.item_offset = header_.free_space_upper_bound - record_length;
+  setSlot(slot_number, slot);
+  header_.free_space_upper_bound = slot.item_offset;
   --header_.num_free_slots;
-  data_.replace(slot->item_offset, slot->item_length, record_data);
+  data_.replace(slot.item_offset, slot.item_length, record_data.data(),
+                record_data.length());
 }
 
 void Page::validateRecordId(const RecordId& record_id) const {
   if (record_id.page_number != page_number()) {
     throw InvalidRecordException(record_id, page_number());
   }
-  const PageSlot& slot = getSlot(record_id.slot_number);
-  if (!slot.used) {
+  if (!isSlotUsed(record_id.slot_number)) {
     throw InvalidRecordException(record_id, page_number());
   }
 }
@@ -11,11 +11,32 @@
 #include <stdint.h>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "frame_arena.h"
 #include "types.h"
 
 namespace badgerdb {
 
+/**
+ * @brief Version of the on-page layout of the slot directory.
+ *
+ * The format is recorded in every page header so that pages written with
+ * either layout can be read back by the same binary.
+ */
+enum class PageFormat : std::uint16_t {
+  /**
+   * Original layout: each slot is a PageSlot, including an explicit used flag.
+   */
+  STANDARD = 1,
+
+  /**
+   * Compact layout: each slot is a CompactPageSlot, with the used flag packed
+   * into the offset field.
+   */
+  COMPACT = 2
+};
+
 /**
  * @brief Header metadata in a page.
  *
@@ -57,6 +78,23 @@ struct PageHeader {
    */
   PageId next_page_number;
 
+  /**
+   * Layout of the slot directory on this page.
+   */
+  PageFormat format;
+
+  /**
+   * Bit flags describing the page on disk (see Page::CHECKSUM_FLAG).
+   */
+  std::uint16_t flags;
+
+  /**
+   * CRC32C of the page as last written to disk, computed over the header
+   * (with this field zeroed) followed by the data area.  Only meaningful if
+   * Page::CHECKSUM_FLAG is set in <flags>.
+   */
+  std::uint32_t checksum;
+
   /**
    * Returns true if this page header is equal to the other.
    *
@@ -67,7 +105,8 @@ struct PageHeader {
     return num_slots == rhs.num_slots &&
         num_free_slots == rhs.num_free_slots &&
         current_page_number == rhs.current_page_number &&
-        next_page_number == rhs.next_page_number;
+        next_page_number == rhs.next_page_number &&
+        format == rhs.format;
   }
 };
 
@@ -92,7 +131,27 @@ struct PageSlot {
   std::uint16_t item_length;
 };
 
+/**
+ * @brief Slot metadata used by pages in PageFormat::COMPACT.
+ *
+ * A record can never start at offset 0, since the slot directory itself
+ * begins there, so an offset of 0 doubles as the unused marker.  This keeps
+ * each slot at 4 bytes instead of the 6 taken by a padded PageSlot.
+ */
+struct CompactPageSlot {
+  /**
+   * Offset of the data item in the page, or 0 if the slot is unused.
+   */
+  std::uint16_t item_offset;
+
+  /**
+   * Length of the data item in this slot.
+   */
+  std::uint16_t item_length;
+};
+
 class PageIterator;
+class RecordPredicate;
 
 /**
  * @brief Class which represents a fixed-size database page containing records.
@@ -107,13 +166,24 @@ class PageIterator;
 class Page {
  public:
   /**
-   * Page size in bytes.  If this is changed, database files created with a
-   * different page size value will be unreadable by the resulting binaries.
+   * Default page size in bytes, used by pages and files that don't ask for a
+   * size explicitly.  Each file records its own page size, so changing this
+   * does not make existing database files unreadable.
    */
   static const std::size_t SIZE = 8192;
 
   /**
-   * Size of page free space area in bytes.
+   * Smallest supported page size in bytes.
+   */
+  static const std::size_t MIN_SIZE = 4096;
+
+  /**
+   * Largest supported page size in bytes.
+   */
+  static const std::size_t MAX_SIZE = 65536;
+
+  /**
+   * Size of page free space area in bytes for a page of the default size.
    */
   static const std::size_t DATA_SIZE = SIZE - sizeof(PageHeader);
 
@@ -127,11 +197,64 @@ class Page {
    */
   static const SlotId INVALID_SLOT = 0;
 
+  /**
+   * Slot directory layout used for pages that don't ask for one explicitly.
+   */
+  static const PageFormat DEFAULT_FORMAT = PageFormat::COMPACT;
+
+  /**
+   * Header flag set on pages whose checksum field was stamped when the page
+   * was written.
+   */
+  static const std::uint16_t CHECKSUM_FLAG = 0x1;
+
   /**
    * Constructs a new, uninitialized page.
    */
   Page();
 
+  /**
+   * Constructs a new, uninitialized page using the given slot directory
+   * layout.
+   *
+   * @param format  Layout of the slot directory.
+   */
+  explicit Page(const PageFormat format);
+
+  /**
+   * Constructs a new, uninitialized page of the given size using the given
+   * slot directory layout.
+   *
+   * @param format  Layout of the slot directory.
+   * @param size    Page size in bytes, including the header.  Must be
+   *                accepted by isValidSize().
+   */
+  Page(const PageFormat format, const std::size_t size);
+
+  /**
+   * Constructs a new, uninitialized page of the given size whose data is kept
+   * in a slot of the given arena, if it has one left.  The page keeps that
+   * memory when other pages are assigned to it; copies of the page do not.
+   *
+   * @param format  Layout of the slot directory.
+   * @param size    Page size in bytes, including the header.  Must be
+   *                accepted by isValidSize().
+   * @param arena   Arena to take the data's memory from.  Must outlive the
+   *                page.
+   */
+  Page(const PageFormat format, const std::size_t size, FrameArena* arena);
+
+  /**
+   * Returns true if pages of the given size are supported: a power of two
+   * between MIN_SIZE and MAX_SIZE.
+   *
+   * @param size  Page size in bytes.
+   * @return  Whether the size is supported.
+   */
+  static bool isValidSize(const std::size_t size) {
+    return size >= MIN_SIZE && size <= MAX_SIZE && (size & (size - 1)) == 0;
+  }
+
   /**
    * Inserts a new record into the page.
    *
@@ -140,6 +263,22 @@ class Page {
    */
   RecordId insertRecord(const std::string& record_data);
 
+  /**
+   * Inserts records from a batch into the page in a single pass, starting at
+   * records[start] and stopping at the first record that doesn't fit.  Unlike
+   * insertRecord, running out of space is not an error; callers find out the
+   * page is full from the returned count.
+   *
+   * @param records     Batch of records to insert.
+   * @param start       Index of the first record in the batch to insert.
+   * @param record_ids  If not NULL, the ID of every inserted record is
+   *                    appended to this vector.
+   * @return  Number of records inserted (taken from the batch in order).
+   */
+  std::size_t insertRecords(const std::vector<std::string>& records,
+                            const std::size_t start = 0,
+                            std::vector<RecordId>* record_ids = NULL);
+
   /**
    * Returns the record with the given ID.  Returned data is a copy of what is
    * stored on the page; use updateRecord to change it.
@@ -150,6 +289,43 @@ class Page {
    */
   std::string getRecord(const RecordId& record_id) const;
 
+  /**
+   * Fills <slot_numbers> with the numbers of all used slots on this page, in
+   * increasing order, replacing its contents.  Lets a caller process the
+   * page's records in a batch instead of searching for each next record.
+   *
+   * @param slot_numbers  Vector to fill.
+   * @return  Number of used slots.
+   */
+  std::size_t getUsedSlots(std::vector<SlotId>& slot_numbers) const;
+
+  /**
+   * Returns a view of the record with the given ID where it is stored on the
+   * page, without copying it.  The view is valid until the page is modified,
+   * unpinned or destroyed.
+   *
+   * @param record_id  ID of the record to view.
+   * @return  View of the record.
+   */
+  RecordView getRecordView(const RecordId& record_id) const;
+
+  /**
+   * Tests every record on the page against a predicate, in place, and reports
+   * the ones that match in increasing slot order.  Unlike iterating with
+   * begin() and end(), no record is copied.
+   *
+   * @param predicate   Condition records must satisfy.
+   * @param record_ids  If not NULL, the ID of every matching record is
+   *                    appended to this vector.
+   * @param views       If not NULL, a view of every matching record is
+   *                    appended to this vector.  Views are valid as long as
+   *                    those returned by getRecordView().
+   * @return  Number of matching records.
+   */
+  std::size_t filterRecords(const RecordPredicate& predicate,
+                            std::vector<RecordId>* record_ids,
+                            std::vector<RecordView>* views = NULL) const;
+
   /**
    * Updates the record with the given ID, replacing its data with a new
    * version.  This is equivalent to deleting the old record and inserting a
@@ -199,6 +375,37 @@ class Page {
    */
   PageId next_page_number() const { return header_.next_page_number; }
 
+  /**
+   * Returns the layout of this page's slot directory.
+   *
+   * @return  Page format.
+   */
+  PageFormat format() const { return header_.format; }
+
+  /**
+   * Returns the size of this page in bytes, including the header.
+   *
+   * @return  Page size.
+   */
+  std::size_t page_size() const { return sizeof(PageHeader) + data_.size(); }
+
+  /**
+   * Asks the CPU to start loading the parts of this page a scan touches
+   * first (the header, the start of the slot directory and the most recently
+   * inserted records) into its caches.  Has no other effect.
+   */
+  void prefetch() const;
+
+  /**
+   * Returns the number of bytes taken by one slot directory entry on this page.
+   *
+   * @return  Slot size in bytes.
+   */
+  std::size_t slotSize() const {
+    return header_.format == PageFormat::COMPACT ? sizeof(CompactPageSlot)
+                                                 : sizeof(PageSlot);
+  }
+
   /**
    * Returns an iterator at the first record in the page.
    *
@@ -217,9 +424,27 @@ class Page {
  private:
   /**
    * Initializes this page as a new page with no header information or data.
+   * The page keeps its current slot directory layout.
    */
   void initialize();
 
+  /**
+   * Initializes this page as a new page with no header information or data,
+   * using the given slot directory layout.  The page keeps its current size.
+   *
+   * @param format  Layout of the slot directory.
+   */
+  void initialize(const PageFormat format);
+
+  /**
+   * Initializes this page as a new page of the given size with no header
+   * information or data, using the given slot directory layout.
+   *
+   * @param format  Layout of the slot directory.
+   * @param size    Page size in bytes, including the header.
+   */
+  void initialize(const PageFormat format, const std::size_t size);
+
   /**
    * Sets this page's number in its file.
    *
@@ -252,24 +477,33 @@ class Page {
                     const bool allow_slot_compaction);
 
   /**
-   * Returns the slot with the given number.  This method will return
-   * unallocated slots if requested; it is up to the caller to ensure they
-   * have a valid slot number.
+   * Returns the slot with the given number, decoded from this page's slot
+   * directory layout.  This method will return unallocated slots if
+   * requested; it is up to the caller to ensure they have a valid slot number.
    *
    * @param slot_number   Number of slot to retrieve.
-   * @return  Pointer to the slot.
+   * @return  Copy of the slot.
    */
-  PageSlot* getSlot(const SlotId slot_number);
+  PageSlot getSlot(const SlotId slot_number) const;
 
   /**
-   * Returns the slot with the given number.  This method will return
-   * unallocated slots if requested; it is up to the caller to ensure they
-   * have a valid slot number.
-   * 
-   * @param slot_number   Number of slot to retrieve.
-   * @return  The slot.
+   * Returns true if the slot with the given number holds a record.  This is
+   * the same as getSlot(slot_number).used, without decoding the whole slot.
+   *
+   * @param slot_number   Number of slot to check.
+   * @return  Whether the slot is in use.
    */
-  const PageSlot& getSlot(const SlotId slot_number) const;
+  bool isSlotUsed(const SlotId slot_number) const;
+
+  /**
+   * Encodes the given slot into this page's slot directory layout.  This
+   * method will write unallocated slots if requested; it is up to the caller
+   * to ensure they have a valid slot number.
+   *
+   * @param slot_number   Number of slot to overwrite.
+   * @param slot          New slot contents.
+   */
+  void setSlot(const SlotId slot_number, const PageSlot& slot);
 
   /**
    * Returns the slot number of an available slot.  If no slots are available
@@ -325,12 +559,19 @@ class Page {
    */
   PageHeader header_;
 
+  /**
+   * Storage of the data on a page, which a page in a buffer pool frame takes
+   * from the pool's arena.
+   */
+  typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>
+      Data;
+
   /**
    * Data stored on the page.  Includes bookkeeping information about slots as
    * well as actual content.
    */
 
-  std::string data_;
+  Data data_;
 
   friend class File;
   friend class PageIterator;
@@ -342,5 +583,12 @@ static_assert(Page::SIZE > sizeof(PageHeader),
               "Page size must be large enough to hold header and data.");
 static_assert(Page::DATA_SIZE > 0,
               "Page must have some space to hold data.");
+static_assert(Page::MIN_SIZE <= Page::SIZE && Page::SIZE <= Page::MAX_SIZE,
+              "Default page size must be a supported page size.");
+// Slot offsets and lengths, and the free space bounds, are 16-bit values
+// relative to the start of the data area.  The data area of the largest page
+// must therefore stay addressable by them.
+static_assert(Page::MAX_SIZE - sizeof(PageHeader) <= UINT16_MAX,
+              "Data area of the largest page must be addressable by slots.");
 
 }
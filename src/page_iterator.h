@@ -10,6 +10,7 @@
 #include <cassert>
 #include "file.h"
 #include "page.h"
+#include "slot_scan.h"
 #include "types.h"
 
 namespace badgerdb {
@@ -101,23 +102,25 @@ class PageIterator {
 		return page_->getRecord(current_record_); 
 	}
 
+  /**
+   * Returns the ID of the record the iterator is currently pointing to.
+   *
+   * @return  Record ID.
+   */
+  const RecordId& record_id() const { return current_record_; }
+
   /**
    * Returns the next used slot in the page after the given slot or
-   * Page::INVALID_SLOT if no slots are used after the given slot.
+   * Page::INVALID_SLOT if no slots are used after the given slot.  Works with
+   * either slot directory layout, testing several slots at a time where the
+   * CPU allows (see SlotScan).
    *
    * @param start   Slot to start search at.
    * @return  Next used slot after given slot or Page::INVALID_SLOT.
    */
   SlotId getNextUsedSlot(const SlotId start) const {
-    SlotId slot_number = Page::INVALID_SLOT;
-    for (SlotId i = start + 1; i <= page_->header_.num_slots; ++i) {
-      const PageSlot* slot = page_->getSlot(i);
-      if (slot->used) {
-        slot_number = i;
-        break;
-      }
-    }
-    return slot_number;
+    return SlotScan::findNextUsed(page_->data_.data(), page_->header_.format,
+                                  start, page_->header_.num_slots);
   }
 
  private:
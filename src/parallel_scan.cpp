@@ -0,0 +1,189 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "parallel_scan.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "page_iterator.h"
+#include "exceptions/invalid_page_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Morsels still to be scanned from one worker's share.  The owner takes
+ * morsels from the front and thieves take them from the back.
+ */
+struct MorselQueue {
+  std::mutex mutex;
+  std::size_t next;
+  std::size_t end;
+
+  bool takeFront(std::size_t& morsel) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (next == end) {
+      return false;
+    }
+    morsel = next++;
+    return true;
+  }
+
+  bool takeBack(std::size_t& morsel) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (next == end) {
+      return false;
+    }
+    morsel = --end;
+    return true;
+  }
+};
+
+}
+
+ParallelScan::ParallelScan(BufMgr* buf_mgr, File* file,
+                           const unsigned num_threads,
+                           const PageId morsel_pages)
+    : buf_mgr_(buf_mgr),
+      file_(file),
+      num_threads_(num_threads),
+      morsel_pages_(std::max<PageId>(morsel_pages, 1)) {
+  if (num_threads_ == 0) {
+    num_threads_ = std::max(std::thread::hardware_concurrency(), 1U);
+  }
+}
+
+void ParallelScan::forEachPage(const PageCallback& callback) {
+  run([&callback](const unsigned worker, Page& page) {
+    callback(worker, page);
+  });
+}
+
+void ParallelScan::forEachRecord(const RecordCallback& callback) {
+  run([&callback](const unsigned worker, Page& page) {
+    for (PageIterator it = page.begin(); it != page.end(); ++it) {
+      callback(worker, it.record_id(), *it);
+    }
+  });
+}
+
+void ParallelScan::forEachMatch(const RecordPredicate& predicate,
+                                const MatchCallback& callback,
+                                const ZoneMap* zone_map) {
+  // Reused from page to page by each worker.
+  std::vector<std::vector<RecordId> > record_ids(num_threads_);
+  std::vector<std::vector<RecordView> > views(num_threads_);
+  auto visit = [&](const unsigned worker, Page& page) {
+    record_ids[worker].clear();
+    views[worker].clear();
+    const std::size_t count =
+        page.filterRecords(predicate, &record_ids[worker], &views[worker]);
+    for (std::size_t i = 0; i < count; ++i) {
+      callback(worker, record_ids[worker][i], views[worker][i]);
+    }
+  };
+  if (zone_map == NULL) {
+    run(visit);
+    return;
+  }
+  run(visit, [this, &predicate, zone_map](const PageId page_number) {
+    return buf_mgr_->mayMatch(file_, page_number, predicate, *zone_map);
+  });
+}
+
+void ParallelScan::run(const std::function<void(unsigned, Page&)>& visit,
+                       const std::function<bool(PageId)>& wanted) {
+  // Page 0 is the file header; pages 1 .. num_pages - 1 may be in use.
+  const PageId num_pages = file_->readHeader().num_pages;
+  const std::size_t num_morsels =
+      (num_pages - 1 + morsel_pages_ - 1) / morsel_pages_;
+
+  std::unique_ptr<MorselQueue[]> queues(new MorselQueue[num_threads_]);
+  for (unsigned w = 0; w < num_threads_; ++w) {
+    queues[w].next = num_morsels * w / num_threads_;
+    queues[w].end = num_morsels * (w + 1) / num_threads_;
+  }
+
+  std::atomic<bool> failed(false);
+  std::exception_ptr error;
+  std::mutex error_mutex;
+
+  auto worker = [&](const unsigned w) {
+    try {
+      std::size_t morsel;
+      while (!failed.load(std::memory_order_relaxed)) {
+        if (!queues[w].takeFront(morsel)) {
+          bool stolen = false;
+          for (unsigned i = 1; i < num_threads_ && !stolen; ++i) {
+            stolen = queues[(w + i) % num_threads_].takeBack(morsel);
+          }
+          if (!stolen) {
+            break;
+          }
+        }
+
+        PageId first = 1 + static_cast<PageId>(morsel) * morsel_pages_;
+        const PageId last = std::min<PageId>(first + morsel_pages_, num_pages);
+        if (wanted) {
+          while (first < last && !wanted(first)) {
+            ++first;
+          }
+        }
+        if (first == last) {
+          continue;
+        }
+        buf_mgr_->prefetchPages(file_, first, last - first);
+        for (PageId p = first; p < last; ++p) {
+          if (p != first && wanted && !wanted(p)) {
+            continue;
+          }
+          Page* page;
+          try {
+            buf_mgr_->readPage(file_, p, page);
+          } catch (const InvalidPageException&) {
+            continue;  // Free page.
+          }
+          try {
+            visit(w, *page);
+          } catch (...) {
+            buf_mgr_->unPinPage(file_, p, false);
+            throw;
+          }
+          buf_mgr_->unPinPage(file_, p, false);
+        }
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+      failed = true;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned w = 1; w < num_threads_; ++w) {
+    threads.push_back(std::thread(worker, w));
+  }
+  worker(0);  // The calling thread is worker 0.
+  for (std::size_t t = 0; t < threads.size(); ++t) {
+    threads[t].join();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+}
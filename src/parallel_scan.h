@@ -0,0 +1,155 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "record_predicate.h"
+#include "types.h"
+#include "zone_map.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Scan of all used pages of a file, split across worker threads.
+ *
+ * The file's page numbers are cut into morsels: runs of consecutive pages.
+ * Each worker starts with an equal share of the morsels and, once it runs
+ * out, steals morsels from the back of the other workers' shares, so a
+ * worker slowed down by expensive pages does not hold up the whole scan.
+ * Pages are pinned through the buffer pool, one at a time per worker, and
+ * handed to a callback.
+ *
+ * Pages are visited in no particular order, and callbacks run concurrently
+ * on the worker threads, so they must be safe to call from several threads
+ * at once.  The worker number passed to a callback can index per-worker
+ * state to avoid sharing.
+ *
+ * The buffer pool must have at least one frame per worker, and nothing else
+ * may use the file while a scan runs.
+ */
+class ParallelScan {
+ public:
+  /**
+   * Default number of pages per morsel.
+   */
+  static const PageId DEFAULT_MORSEL_PAGES = 32;
+
+  /**
+   * Callback run for every used page.  Takes the number of the worker
+   * running it (from 0 to num_threads() - 1) and the page, which is pinned
+   * for the duration of the call and must not be modified.
+   */
+  typedef std::function<void(unsigned, const Page&)> PageCallback;
+
+  /**
+   * Callback run for every record.  Takes the number of the worker running
+   * it, the record's ID and the record itself.
+   */
+  typedef std::function<void(unsigned, const RecordId&, const std::string&)>
+      RecordCallback;
+
+  /**
+   * Callback run for every record matching a predicate.  Takes the number of
+   * the worker running it, the record's ID and a view of the record in the
+   * pinned page, valid only during the call.
+   */
+  typedef std::function<void(unsigned, const RecordId&, const RecordView&)>
+      MatchCallback;
+
+  /**
+   * Sets up a parallel scan of a file.
+   *
+   * @param buf_mgr       Buffer pool to read pages through.
+   * @param file          File to scan.
+   * @param num_threads   Number of worker threads, or 0 for one per hardware
+   *                      thread.
+   * @param morsel_pages  Number of consecutive pages handed out at a time.
+   */
+  ParallelScan(BufMgr* buf_mgr, File* file, const unsigned num_threads = 0,
+               const PageId morsel_pages = DEFAULT_MORSEL_PAGES);
+
+  /**
+   * Runs a callback on every used page of the file, returning once all pages
+   * have been visited.  If a callback throws, the remaining morsels are
+   * abandoned and the first exception is rethrown here after all workers have
+   * stopped.
+   *
+   * @param callback  Callback to run on each page.
+   */
+  void forEachPage(const PageCallback& callback);
+
+  /**
+   * Runs a callback on every record in the used pages of the file.  Behaves
+   * like forEachPage() otherwise.
+   *
+   * @param callback  Callback to run on each record.
+   */
+  void forEachRecord(const RecordCallback& callback);
+
+  /**
+   * Runs a callback on every record of the file that matches a predicate.
+   * Records are tested in place, without being copied.  Given a zone map of
+   * the file, pages it rules out are skipped without being read (see
+   * BufMgr::mayMatch()).  Behaves like forEachPage() otherwise.
+   *
+   * @param predicate Condition records must satisfy.
+   * @param callback  Callback to run on each matching record.
+   * @param zone_map  If not NULL, zone map of the file kept up to date by the
+   *                  buffer pool's write-back hook.
+   */
+  void forEachMatch(const RecordPredicate& predicate,
+                    const MatchCallback& callback,
+                    const ZoneMap* zone_map = NULL);
+
+  /**
+   * Returns the number of worker threads the scan runs on.
+   *
+   * @return  Number of workers.
+   */
+  unsigned num_threads() const { return num_threads_; }
+
+ private:
+  /**
+   * Runs the worker threads, each pinning pages of its morsels in turn and
+   * passing them to <visit>.
+   *
+   * @param visit   Function to run on each used page.
+   * @param wanted  If set, pages for which it returns false are neither read
+   *                nor visited.
+   */
+  void run(const std::function<void(unsigned, Page&)>& visit,
+           const std::function<bool(PageId)>& wanted =
+               std::function<bool(PageId)>());
+
+  /**
+   * Buffer pool pages are read through.
+   */
+  BufMgr* buf_mgr_;
+
+  /**
+   * File being scanned.
+   */
+  File* file_;
+
+  /**
+   * Number of worker threads.
+   */
+  unsigned num_threads_;
+
+  /**
+   * Number of consecutive pages in a morsel.
+   */
+  PageId morsel_pages_;
+};
+
+}
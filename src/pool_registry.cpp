@@ -0,0 +1,119 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "pool_registry.h"
+
+#include "exceptions/pool_exists_exception.h"
+#include "exceptions/pool_not_found_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Holds a latch in the given mode for as long as it lives.
+ */
+class LatchHolder {
+ public:
+  LatchHolder(RWLatch& latch, const LatchMode mode)
+      : latch_(latch), mode_(mode) {
+    latch_.lock(mode_);
+  }
+
+  ~LatchHolder() { latch_.unlock(mode_); }
+
+ private:
+  RWLatch& latch_;
+  const LatchMode mode_;
+
+  LatchHolder(const LatchHolder&);
+  LatchHolder& operator=(const LatchHolder&);
+};
+
+}
+
+const char* const PoolRegistry::kDefaultPool = "default";
+
+PoolRegistry::PoolRegistry(const std::uint32_t frames,
+                           const std::size_t page_size,
+                           const std::uint32_t shards)
+    : page_size_(page_size),
+      default_pool_(new BufMgr(frames, page_size, shards)) {
+  pools_[kDefaultPool] = default_pool_;
+}
+
+PoolRegistry::~PoolRegistry() {
+  for (PoolMap::iterator it = pools_.begin(); it != pools_.end(); ++it) {
+    delete it->second;
+  }
+}
+
+BufMgr& PoolRegistry::addPool(const std::string& name,
+                              const std::uint32_t frames,
+                              const ReplacementPolicy policy,
+                              const std::uint32_t shards) {
+  // Made before the latch is taken, as allocating the frames takes a while
+  BufMgr* pool = new BufMgr(frames, page_size_, shards);
+  pool->setReplacementPolicy(policy);
+  {
+    LatchHolder holder(latch_, LatchMode::EXCLUSIVE);
+    if (pools_.find(name) == pools_.end()) {
+      pools_[name] = pool;
+      return *pool;
+    }
+  }
+  delete pool;
+  throw PoolExistsException(name);
+}
+
+BufMgr& PoolRegistry::pool(const std::string& name) {
+  LatchHolder holder(latch_, LatchMode::SHARED);
+  return findPool(name);
+}
+
+BufMgr& PoolRegistry::findPool(const std::string& name) {
+  const PoolMap::iterator it = pools_.find(name);
+  if (it == pools_.end()) {
+    throw PoolNotFoundException(name);
+  }
+  return *it->second;
+}
+
+void PoolRegistry::bindFile(const File* file, const std::string& name) {
+  LatchHolder holder(latch_, LatchMode::EXCLUSIVE);
+  BufMgr& pool = findPool(name);
+  const BindingMap::iterator it = bindings_.find(file);
+  BufMgr& current = it == bindings_.end() ? *default_pool_ : *it->second;
+  if (&pool == &current) {
+    return;
+  }
+  current.flushFile(file);
+  if (&pool == default_pool_) {
+    bindings_.erase(it);
+  } else {
+    bindings_[file] = &pool;
+  }
+}
+
+void PoolRegistry::unbindFile(const File* file) {
+  LatchHolder holder(latch_, LatchMode::EXCLUSIVE);
+  const BindingMap::iterator it = bindings_.find(file);
+  if (it == bindings_.end()) {
+    default_pool_->flushFile(file);
+    return;
+  }
+  it->second->flushFile(file);
+  bindings_.erase(it);
+}
+
+BufMgr& PoolRegistry::poolOf(const File* file) {
+  LatchHolder holder(latch_, LatchMode::SHARED);
+  const BindingMap::const_iterator it = bindings_.find(file);
+  return it == bindings_.end() ? *default_pool_ : *it->second;
+}
+
+}
@@ -0,0 +1,167 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "buffer.h"
+#include "latch.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Named buffer pools, each with its own size and replacement policy,
+ * and the files bound to them.
+ *
+ * Every file is bound to one pool, and the page operations made through the
+ * registry go to that pool; files never bound go to the default pool.  Small
+ * files that are used all the time, such as lookup tables and indexes, can
+ * be kept in a "keep" pool large enough to hold them, and large files that
+ * are read through once, such as logs, in a small "recycle" pool, which with
+ * ReplacementPolicy::RECYCLE keeps just the last pages read, so that reading
+ * the latter does not push the former out of memory.
+ *
+ * Pools live as long as the registry and all have its page size.  Adding
+ * pools and binding files may happen while other threads use the pools, but
+ * a file must not be used while it is being bound.
+ */
+class PoolRegistry {
+ public:
+  /**
+   * Name of the pool files are in until they are bound to another.
+   */
+  static const char* const kDefaultPool;
+
+  /**
+   * Makes a registry holding only the default pool.
+   *
+   * @param frames     Number of frames of the default pool.
+   * @param page_size  Page size of every pool.
+   * @param shards     Number of shards of the default pool.
+   * @throws  InvalidPageSizeException  If page_size is not a valid page size.
+   */
+  explicit PoolRegistry(const std::uint32_t frames,
+                        const std::size_t page_size = Page::SIZE,
+                        const std::uint32_t shards = 1);
+
+  /**
+   * Writes back the dirty pages of every pool and frees the pools.
+   */
+  ~PoolRegistry();
+
+  /**
+   * Adds a pool.
+   *
+   * @param name    Name to bind files to the pool by.
+   * @param frames  Number of frames of the pool.
+   * @param policy  How the pool picks the pages to replace.
+   * @param shards  Number of shards the pool's frames are split into.
+   * @return  The new pool.
+   * @throws  PoolExistsException  If a pool already has the name.
+   */
+  BufMgr& addPool(const std::string& name, const std::uint32_t frames,
+                  const ReplacementPolicy policy = ReplacementPolicy::CLOCK,
+                  const std::uint32_t shards = 1);
+
+  /**
+   * Returns the pool with the given name.
+   *
+   * @throws  PoolNotFoundException  If there is no such pool.
+   */
+  BufMgr& pool(const std::string& name);
+
+  /**
+   * Binds a file to a pool.  The file's pages are first written back and
+   * dropped from the pool it was in, so a page is never buffered twice.
+   *
+   * @param file  File to bind.
+   * @param name  Name of the pool to bind it to.
+   * @throws  PoolNotFoundException  If there is no such pool.
+   * @throws  PagePinnedException    If a page of the file is pinned in the
+   *                                 pool it was in; the file stays there.
+   */
+  void bindFile(const File* file, const std::string& name);
+
+  /**
+   * Writes back and drops the file's pages and forgets its pool, as is
+   * needed before the file is closed, since another file opened later may
+   * get its address.
+   *
+   * @throws  PagePinnedException  If a page of the file is pinned.
+   */
+  void unbindFile(const File* file);
+
+  /**
+   * Returns the pool the file is bound to, or the default pool.
+   */
+  BufMgr& poolOf(const File* file);
+
+  /**
+   * Same as BufMgr::readPage(), in the file's pool.
+   */
+  void readPage(File* file, const PageId page_number, Page*& page,
+                const ReadHint hint = ReadHint::NORMAL,
+                const LatchMode mode = LatchMode::NONE) {
+    poolOf(file).readPage(file, page_number, page, hint, mode);
+  }
+
+  /**
+   * Same as BufMgr::unPinPage(), in the file's pool.
+   */
+  void unPinPage(File* file, const PageId page_number, const bool dirty,
+                 const LatchMode mode = LatchMode::NONE) {
+    poolOf(file).unPinPage(file, page_number, dirty, mode);
+  }
+
+  /**
+   * Same as BufMgr::allocPage(), in the file's pool.
+   */
+  void allocPage(File* file, PageId& page_number, Page*& page) {
+    poolOf(file).allocPage(file, page_number, page);
+  }
+
+  /**
+   * Same as BufMgr::disposePage(), in the file's pool.
+   */
+  void disposePage(File* file, const PageId page_number) {
+    poolOf(file).disposePage(file, page_number);
+  }
+
+  /**
+   * Same as BufMgr::flushFile(), in the file's pool.
+   */
+  void flushFile(const File* file) { poolOf(file).flushFile(file); }
+
+ private:
+  typedef std::map<std::string, BufMgr*> PoolMap;
+  typedef std::map<const File*, BufMgr*> BindingMap;
+
+  /**
+   * Returns the pool with the given name; latch_ must be held.
+   */
+  BufMgr& findPool(const std::string& name);
+
+  const std::size_t page_size_;
+  BufMgr* default_pool_;
+
+  /**
+   * Guards pools_ and bindings_.  Held shared only while a pool is looked
+   * up, never during an operation on the pool.
+   */
+  RWLatch latch_;
+  PoolMap pools_;
+  BindingMap bindings_;
+
+  PoolRegistry(const PoolRegistry&);
+  PoolRegistry& operator=(const PoolRegistry&);
+};
+
+}
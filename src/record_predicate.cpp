@@ -0,0 +1,202 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "record_predicate.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define BADGERDB_RECORD_PREDICATE_SSE2 1
+#endif
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Bytes compared per vector.
+ */
+const std::size_t kVectorBytes = 16;
+
+/**
+ * Returns true if the <length> bytes at <data> equal those at <pattern>.
+ * <readable> bytes can be read from <data> on, and <pattern> is padded to a
+ * multiple of kVectorBytes, so a short tail is compared as a whole vector
+ * whenever the memory after the record allows it.
+ */
+inline bool bytesEqual(const char* data, const std::size_t readable,
+                       const char* pattern, const std::size_t length) {
+#if defined(BADGERDB_RECORD_PREDICATE_SSE2)
+  std::size_t i = 0;
+  for (; i + kVectorBytes <= length; i += kVectorBytes) {
+    const __m128i a =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF) {
+      return false;
+    }
+  }
+  const std::size_t rest = length - i;
+  if (rest == 0) {
+    return true;
+  }
+  if (i + kVectorBytes <= readable) {
+    const __m128i a =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + i));
+    const int wanted = (1 << rest) - 1;
+    return (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) & wanted) == wanted;
+  }
+  return std::memcmp(data + i, pattern + i, rest) == 0;
+#else
+  (void)readable;
+  return std::memcmp(data, pattern, length) == 0;
+#endif
+}
+
+/**
+ * Returns the result of "field <op> value".
+ */
+template <typename T>
+inline bool compare(const T field, const CompareOp op, const T value) {
+  switch (op) {
+    case CompareOp::LESS:
+      return field < value;
+    case CompareOp::LESS_EQUAL:
+      return field <= value;
+    case CompareOp::EQUAL:
+      return field == value;
+    case CompareOp::NOT_EQUAL:
+      return field != value;
+    case CompareOp::GREATER_EQUAL:
+      return field >= value;
+    case CompareOp::GREATER:
+      return field > value;
+  }
+  return false;
+}
+
+/**
+ * Reads the integer of type <T> at <offset> in <record> and compares it.
+ */
+template <typename T>
+inline bool compareAt(const RecordView& record, const std::size_t offset,
+                      const CompareOp op, const T value) {
+  if (record.length < offset || record.length - offset < sizeof(T)) {
+    return false;
+  }
+  T field;
+  std::memcpy(&field, record.data + offset, sizeof(field));
+  return compare(field, op, value);
+}
+
+}
+
+RecordPredicate::RecordPredicate(const Kind kind, const std::size_t offset)
+    : kind_(kind),
+      offset_(offset),
+      num_bytes_(0),
+      op_(CompareOp::EQUAL),
+      value_(0) {}
+
+RecordPredicate RecordPredicate::prefix(const std::string& bytes) {
+  return bytesAt(0, bytes);
+}
+
+RecordPredicate RecordPredicate::bytesAt(const std::size_t offset,
+                                         const std::string& bytes) {
+  RecordPredicate predicate(Kind::BYTES_AT, offset);
+  predicate.num_bytes_ = bytes.size();
+  predicate.bytes_ = bytes;
+  predicate.bytes_.resize(
+      (bytes.size() + kVectorBytes - 1) / kVectorBytes * kVectorBytes);
+  return predicate;
+}
+
+RecordPredicate RecordPredicate::int32At(const std::size_t offset,
+                                         const CompareOp op,
+                                         const std::int32_t value) {
+  RecordPredicate predicate(Kind::INT32_AT, offset);
+  predicate.op_ = op;
+  predicate.value_ = value;
+  return predicate;
+}
+
+RecordPredicate RecordPredicate::int64At(const std::size_t offset,
+                                         const CompareOp op,
+                                         const std::int64_t value) {
+  RecordPredicate predicate(Kind::INT64_AT, offset);
+  predicate.op_ = op;
+  predicate.value_ = value;
+  return predicate;
+}
+
+RecordPredicate RecordPredicate::custom(const Function& function) {
+  RecordPredicate predicate(Kind::CUSTOM, 0);
+  predicate.function_ = function;
+  return predicate;
+}
+
+bool RecordPredicate::evaluate(const RecordView& record,
+                               const std::size_t readable) const {
+  switch (kind_) {
+    case Kind::BYTES_AT:
+      if (record.length < offset_ || record.length - offset_ < num_bytes_) {
+        return false;
+      }
+      return bytesEqual(record.data + offset_, readable - offset_,
+                        bytes_.data(), num_bytes_);
+    case Kind::INT32_AT:
+      return compareAt(record, offset_, op_,
+                       static_cast<std::int32_t>(value_));
+    case Kind::INT64_AT:
+      return compareAt(record, offset_, op_, value_);
+    case Kind::CUSTOM:
+      return function_(record);
+  }
+  return false;
+}
+
+bool RecordPredicate::mayMatchRange(const std::size_t offset,
+                                    const std::size_t width,
+                                    const std::int64_t min,
+                                    const std::int64_t max) const {
+  std::size_t compared_width = 0;
+  if (kind_ == Kind::INT32_AT) {
+    compared_width = sizeof(std::int32_t);
+  } else if (kind_ == Kind::INT64_AT) {
+    compared_width = sizeof(std::int64_t);
+  }
+  if (compared_width == 0 || compared_width != width || offset_ != offset) {
+    return true;
+  }
+  if (min > max) {
+    return false;
+  }
+  switch (op_) {
+    case CompareOp::LESS:
+      return min < value_;
+    case CompareOp::LESS_EQUAL:
+      return min <= value_;
+    case CompareOp::EQUAL:
+      return min <= value_ && value_ <= max;
+    case CompareOp::NOT_EQUAL:
+      return min != value_ || max != value_;
+    case CompareOp::GREATER_EQUAL:
+      return max >= value_;
+    case CompareOp::GREATER:
+      return max > value_;
+  }
+  return true;
+}
+
+}
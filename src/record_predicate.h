@@ -0,0 +1,186 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Comparison applied by an integer predicate, as in
+ * "field <op> value".
+ */
+enum class CompareOp {
+  LESS,
+  LESS_EQUAL,
+  EQUAL,
+  NOT_EQUAL,
+  GREATER_EQUAL,
+  GREATER
+};
+
+/**
+ * @brief Condition on the raw bytes of a record, evaluated where the record
+ * is stored instead of on a copy.
+ *
+ * A predicate is one of:
+ *  - a byte match: the record holds given bytes at a given offset (a prefix
+ *    match is a byte match at offset 0);
+ *  - an integer compare: the record holds an integer, in the machine's byte
+ *    order, at a given offset that compares to a value in a given way;
+ *  - a user function of the record's bytes.
+ *
+ * Records too short to hold the bytes or integer a predicate looks at never
+ * match it.  Byte matches are compared 16 bytes per instruction with SSE2
+ * where available, and with memcmp otherwise.
+ */
+class RecordPredicate {
+ public:
+  /**
+   * Type of a user function of a record's bytes.
+   */
+  typedef std::function<bool(const RecordView&)> Function;
+
+  /**
+   * Returns a predicate matching records that start with the given bytes.
+   *
+   * @param bytes   Bytes records must start with.
+   * @return  The predicate.
+   */
+  static RecordPredicate prefix(const std::string& bytes);
+
+  /**
+   * Returns a predicate matching records that hold the given bytes at the
+   * given offset.
+   *
+   * @param offset  Offset of the bytes in the record.
+   * @param bytes   Bytes records must hold there.
+   * @return  The predicate.
+   */
+  static RecordPredicate bytesAt(const std::size_t offset,
+                                 const std::string& bytes);
+
+  /**
+   * Returns a predicate matching records whose 32-bit signed integer at the
+   * given offset compares to <value> as given by <op>.
+   *
+   * @param offset  Offset of the integer in the record.
+   * @param op      Comparison of the record's integer against <value>.
+   * @param value   Value to compare against.
+   * @return  The predicate.
+   */
+  static RecordPredicate int32At(const std::size_t offset, const CompareOp op,
+                                 const std::int32_t value);
+
+  /**
+   * Same as int32At(), for a 64-bit signed integer.
+   */
+  static RecordPredicate int64At(const std::size_t offset, const CompareOp op,
+                                 const std::int64_t value);
+
+  /**
+   * Returns a predicate matching records for which a function returns true.
+   * The function is given a view of the record's bytes, valid only during
+   * the call.
+   *
+   * @param function  Function to call on each record.
+   * @return  The predicate.
+   */
+  static RecordPredicate custom(const Function& function);
+
+  /**
+   * Returns true if a record satisfies this predicate.
+   *
+   * @param record  Record to test.
+   * @return  Whether the record matches.
+   */
+  bool operator()(const RecordView& record) const {
+    return evaluate(record, record.length);
+  }
+
+  /**
+   * Returns true if a record satisfies this predicate, for callers that know
+   * the record is followed by more readable memory (such as the rest of a
+   * page), so that byte matches can always compare whole vectors.
+   *
+   * @param record    Record to test.
+   * @param readable  Number of bytes that can be read from record.data on,
+   *                  at least record.length.
+   * @return  Whether the record matches.
+   */
+  bool evaluate(const RecordView& record, const std::size_t readable) const;
+
+  /**
+   * Returns false if no record whose integer of <width> bytes at <offset>
+   * lies between <min> and <max> can satisfy this predicate.  Returns true
+   * for predicates that do not compare that integer.  An empty range (<min>
+   * greater than <max>) stands for records too short to hold the integer.
+   *
+   * @param offset  Offset of the integer in the record.
+   * @param width   Size of the integer in bytes.
+   * @param min     Smallest value of the integer.
+   * @param max     Largest value of the integer.
+   * @return  Whether a record in the range may match.
+   */
+  bool mayMatchRange(const std::size_t offset, const std::size_t width,
+                     const std::int64_t min, const std::int64_t max) const;
+
+ private:
+  /**
+   * Kinds of predicates.
+   */
+  enum class Kind { BYTES_AT, INT32_AT, INT64_AT, CUSTOM };
+
+  /**
+   * Constructs a predicate of the given kind; the factories fill in the rest.
+   */
+  RecordPredicate(const Kind kind, const std::size_t offset);
+
+  /**
+   * Kind of this predicate.
+   */
+  Kind kind_;
+
+  /**
+   * Offset in the record of the bytes or integer looked at.
+   */
+  std::size_t offset_;
+
+  /**
+   * Bytes to match, followed by zeros up to a multiple of 16 bytes so that
+   * vector compares can read whole vectors of it.
+   */
+  std::string bytes_;
+
+  /**
+   * Number of bytes to match, not counting the zeros.
+   */
+  std::size_t num_bytes_;
+
+  /**
+   * Comparison made by integer predicates.
+   */
+  CompareOp op_;
+
+  /**
+   * Value compared against by integer predicates.
+   */
+  std::int64_t value_;
+
+  /**
+   * Function called by custom predicates.
+   */
+  Function function_;
+};
+
+}
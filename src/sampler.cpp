@@ -0,0 +1,124 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "sampler.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "exceptions/invalid_page_exception.h"
+
+namespace badgerdb {
+
+FileSampler::FileSampler(BufMgr* buf_mgr, File* file, const std::uint64_t seed,
+                         const std::size_t max_records_per_page)
+    : buf_mgr_(buf_mgr),
+      file_(file),
+      max_records_per_page_(max_records_per_page),
+      random_(seed) {
+  if (max_records_per_page_ == 0) {
+    // Every record takes at least a slot of the page's data area.
+    const FileHeader header = file_->readHeader();
+    const std::size_t slot_size = header.page_format == PageFormat::COMPACT
+        ? sizeof(CompactPageSlot) : sizeof(PageSlot);
+    max_records_per_page_ =
+        (header.page_size - sizeof(PageHeader)) / slot_size;
+  }
+}
+
+std::size_t FileSampler::samplePages(const std::size_t num_pages,
+                                     const PageCallback& callback) {
+  // Page 0 is the file header; pages 1 .. num_pages - 1 may be in use.
+  const FileHeader header = file_->readHeader();
+  const PageId candidates = header.num_pages - 1;
+  const std::size_t used_pages = candidates - header.num_free_pages;
+  const std::size_t target = std::min(num_pages, used_pages);
+
+  // Draws page numbers without repeats by shuffling 0 .. candidates - 1 one
+  // position at a time; only positions moved so far are stored.
+  std::unordered_map<PageId, PageId> moved;
+  std::size_t sampled = 0;
+  for (PageId i = 0; i < candidates && sampled < target; ++i) {
+    const PageId j =
+        std::uniform_int_distribution<PageId>(i, candidates - 1)(random_);
+    std::unordered_map<PageId, PageId>::iterator at_j = moved.find(j);
+    const PageId pick = at_j == moved.end() ? j : at_j->second;
+    std::unordered_map<PageId, PageId>::iterator at_i = moved.find(i);
+    moved[j] = at_i == moved.end() ? i : at_i->second;
+
+    const PageId page_number = pick + 1;
+    Page* page;
+    if (!readPage(page_number, page)) {
+      continue;
+    }
+    try {
+      callback(*page);
+    } catch (...) {
+      buf_mgr_->unPinPage(file_, page_number, false);
+      throw;
+    }
+    buf_mgr_->unPinPage(file_, page_number, false);
+    ++sampled;
+  }
+  return sampled;
+}
+
+std::size_t FileSampler::sampleRecords(const std::size_t num_records,
+                                       const RecordCallback& callback) {
+  const FileHeader header = file_->readHeader();
+  const PageId candidates = header.num_pages - 1;
+  const std::size_t used_pages = candidates - header.num_free_pages;
+  if (used_pages == 0) {
+    return 0;
+  }
+  std::uniform_int_distribution<PageId> pick_page(1, candidates);
+  std::uniform_int_distribution<std::size_t> pick_index(
+      0, max_records_per_page_ - 1);
+
+  // Lets sampling give up on a file whose used pages are all empty.
+  std::unordered_set<PageId> empty_pages;
+  std::vector<SlotId> slots;
+  std::size_t sampled = 0;
+  while (sampled < num_records && empty_pages.size() < used_pages) {
+    const PageId page_number = pick_page(random_);
+    Page* page;
+    if (!readPage(page_number, page)) {
+      continue;
+    }
+    try {
+      // Each record is reached by exactly one index of every page, so all
+      // records are equally likely whatever the page's number of records.
+      if (page->getUsedSlots(slots) == 0) {
+        empty_pages.insert(page_number);
+      }
+      const std::size_t index = pick_index(random_);
+      if (index < slots.size()) {
+        const RecordId record_id = {page_number, slots[index]};
+        callback(record_id, page->getRecordView(record_id));
+        ++sampled;
+      }
+    } catch (...) {
+      buf_mgr_->unPinPage(file_, page_number, false);
+      throw;
+    }
+    buf_mgr_->unPinPage(file_, page_number, false);
+  }
+  return sampled;
+}
+
+bool FileSampler::readPage(const PageId page_number, Page*& page) {
+  try {
+    buf_mgr_->readPage(file_, page_number, page, ReadHint::ONCE);
+  } catch (const InvalidPageException&) {
+    return false;  // Free page.
+  }
+  return true;
+}
+
+}
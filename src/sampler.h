@@ -0,0 +1,126 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <random>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Draws uniform random samples of the used pages or the records of a
+ * file, for approximate answers that do not need a full scan.
+ *
+ * Pages are picked by page number instead of by following the file's chain
+ * of used pages, and free pages are rejected, so the cost of a sample grows
+ * with its size rather than with the file's.  Pages are read through a
+ * buffer pool with ReadHint::ONCE, so sampling does not push other readers'
+ * pages out of the pool.
+ *
+ * Nothing else may change the file while a sample is drawn.
+ */
+class FileSampler {
+ public:
+  /**
+   * Callback run for every sampled page, which is pinned for the duration of
+   * the call and must not be modified.
+   */
+  typedef std::function<void(const Page&)> PageCallback;
+
+  /**
+   * Callback run for every sampled record.  Takes the record's ID and a view
+   * of the record in its pinned page, valid only during the call.
+   */
+  typedef std::function<void(const RecordId&, const RecordView&)>
+      RecordCallback;
+
+  /**
+   * Sets up sampling of a file.
+   *
+   * @param buf_mgr   Buffer pool to read pages through.
+   * @param file      File to sample.
+   * @param seed      Seed of the random number generator; samplers with the
+   *                  same seed draw the same samples from the same file.
+   * @param max_records_per_page  Upper bound on the number of records on any
+   *                  page of the file, or 0 to use the most a page of the
+   *                  file's size and format can hold.  A tighter bound makes
+   *                  sampleRecords() read fewer pages.
+   */
+  FileSampler(BufMgr* buf_mgr, File* file,
+              const std::uint64_t seed = std::mt19937_64::default_seed,
+              const std::size_t max_records_per_page = 0);
+
+  /**
+   * Runs a callback on a sample of distinct used pages of the file, each
+   * used page being equally likely to be in it.  Pages are visited in random
+   * order.
+   *
+   * @param num_pages Number of pages to sample.
+   * @param callback  Callback to run on each sampled page.
+   * @return  Number of pages sampled: <num_pages>, or the number of used
+   *          pages in the file if it has fewer.
+   */
+  std::size_t samplePages(const std::size_t num_pages,
+                          const PageCallback& callback);
+
+  /**
+   * Runs a callback on a sample of records of the file, each drawn
+   * independently with every record of the file equally likely (so a record
+   * may be drawn more than once).
+   *
+   * A record is drawn by picking a page number and an index below
+   * <max_records_per_page> at random, until the page is used and the index
+   * falls among its records.
+   *
+   * @param num_records Number of records to sample.
+   * @param callback    Callback to run on each sampled record.
+   * @return  Number of records sampled: <num_records>, or 0 if the file has
+   *          no records.
+   */
+  std::size_t sampleRecords(const std::size_t num_records,
+                            const RecordCallback& callback);
+
+ private:
+  /**
+   * Pins a page for sampling.
+   *
+   * @param page_number Number of page to read.
+   * @param page        Set to the pinned page.
+   * @return  False if the page is free.
+   */
+  bool readPage(const PageId page_number, Page*& page);
+
+  /**
+   * Buffer pool pages are read through.
+   */
+  BufMgr* buf_mgr_;
+
+  /**
+   * File being sampled.
+   */
+  File* file_;
+
+  /**
+   * Upper bound on the number of records on a page.
+   */
+  std::size_t max_records_per_page_;
+
+  /**
+   * Source of randomness for all samples.
+   */
+  std::mt19937_64 random_;
+};
+
+}
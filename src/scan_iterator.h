@@ -0,0 +1,243 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cassert>
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Iterator for scanning the pages of a file through a buffer pool.
+ *
+ * Unlike FileIterator, which reads every page straight from disk (and reads
+ * its header a second time to find the next page), this iterator pins each
+ * page in a BufMgr, so pages that are already buffered cost no I/O, and it
+ * follows the chain of used pages using the header of the pinned frame.
+ *
+ * While a page is being visited, the next page is prefetched: into the CPU
+ * caches if it is already buffered, or otherwise by asking the operating
+ * system to read ahead a window of pages from disk.
+ *
+ * The iterator holds a pin on the page it points to, which is released when
+ * it moves on or is destroyed.  The buffer pool must outlive it.
+ */
+class ScanIterator {
+ public:
+  /**
+   * Number of pages the operating system is asked to read ahead when the
+   * next page is not buffered.
+   */
+  static const PageId READAHEAD_PAGES = 16;
+
+  /**
+   * Constructs an empty iterator.
+   */
+  ScanIterator()
+      : buf_mgr_(NULL),
+        file_(NULL),
+        current_page_number_(Page::INVALID_NUMBER),
+        current_page_(NULL),
+        advised_begin_(Page::INVALID_NUMBER),
+        advised_end_(Page::INVALID_NUMBER) {
+  }
+
+  /**
+   * Constructs an iterator over the pages in a file, starting at the first
+   * used page.
+   *
+   * @param buf_mgr   Buffer pool to read pages through.
+   * @param file      File to iterate over.
+   */
+  ScanIterator(BufMgr* buf_mgr, File* file)
+      : buf_mgr_(buf_mgr),
+        file_(file),
+        current_page_(NULL),
+        advised_begin_(Page::INVALID_NUMBER),
+        advised_end_(Page::INVALID_NUMBER) {
+    assert(buf_mgr_ != NULL && file_ != NULL);
+    current_page_number_ = file_->readHeader().first_used_page;
+    pin();
+  }
+
+  /**
+   * Constructs an iterator over the pages in a file, starting at the given
+   * page number.
+   *
+   * @param buf_mgr     Buffer pool to read pages through.
+   * @param file        File to iterate over.
+   * @param page_number Number of page to start iterator at.
+   */
+  ScanIterator(BufMgr* buf_mgr, File* file, const PageId page_number)
+      : buf_mgr_(buf_mgr),
+        file_(file),
+        current_page_number_(page_number),
+        current_page_(NULL),
+        advised_begin_(Page::INVALID_NUMBER),
+        advised_end_(Page::INVALID_NUMBER) {
+    pin();
+  }
+
+  /**
+   * Copy constructor.  The copy holds a pin of its own on the current page.
+   *
+   * @param other   Iterator to copy.
+   */
+  ScanIterator(const ScanIterator& other)
+      : buf_mgr_(other.buf_mgr_),
+        file_(other.file_),
+        current_page_number_(other.current_page_number_),
+        current_page_(NULL),
+        advised_begin_(other.advised_begin_),
+        advised_end_(other.advised_end_) {
+    pin();
+  }
+
+  /**
+   * Assignment operator.  Releases the pin held by this iterator and takes
+   * one on the page the other iterator points to.
+   *
+   * @param rhs   Iterator to assign.
+   * @return  This iterator.
+   */
+  ScanIterator& operator=(const ScanIterator& rhs) {
+    if (this != &rhs) {
+      release();
+      buf_mgr_ = rhs.buf_mgr_;
+      file_ = rhs.file_;
+      current_page_number_ = rhs.current_page_number_;
+      advised_begin_ = rhs.advised_begin_;
+      advised_end_ = rhs.advised_end_;
+      pin();
+    }
+    return *this;
+  }
+
+  /**
+   * Destructor that releases the pin on the current page.
+   */
+  ~ScanIterator() {
+    release();
+  }
+
+  /**
+   * Advances the iterator to the next page in the file.
+   */
+  inline ScanIterator& operator++() {
+    assert(current_page_ != NULL);
+    const PageId next_page_number = current_page_->next_page_number();
+    release();
+    current_page_number_ = next_page_number;
+    pin();
+    return *this;
+  }
+
+  //postfix
+  inline ScanIterator operator++(int) {
+    ScanIterator tmp = *this;   // copy ourselves
+    ++*this;
+    return tmp;
+  }
+
+  /**
+   * Returns true if this iterator is equal to the given iterator.
+   *
+   * @param rhs   Iterator to compare against.
+   * @return    True if other iterator is equal to this one.
+   */
+  inline bool operator==(const ScanIterator& rhs) const {
+    return file_ == rhs.file_ &&
+        current_page_number_ == rhs.current_page_number_;
+  }
+
+  inline bool operator!=(const ScanIterator& rhs) const {
+    return !(*this == rhs);
+  }
+
+  /**
+   * Dereferences the iterator, returning the current page in its buffer
+   * frame.  The page stays pinned until the iterator moves on.  Pages are
+   * unpinned clean, so they must not be modified through the iterator.
+   *
+   * @return  Page in buffer pool.
+   */
+  inline Page& operator*() const {
+    assert(current_page_ != NULL);
+    return *current_page_;
+  }
+
+  inline Page* operator->() const {
+    assert(current_page_ != NULL);
+    return current_page_;
+  }
+
+ private:
+  /**
+   * Pins the current page (if any) and prefetches the one after it.
+   */
+  void pin() {
+    if (current_page_number_ == Page::INVALID_NUMBER) {
+      return;
+    }
+    buf_mgr_->readPage(file_, current_page_number_, current_page_);
+
+    const PageId next_page_number = current_page_->next_page_number();
+    if (next_page_number == Page::INVALID_NUMBER ||
+        buf_mgr_->prefetchPage(file_, next_page_number)) {
+      return;
+    }
+    // Used pages mostly follow each other in page number order, so read
+    // ahead a window starting at the next page unless it was already asked for.
+    if (next_page_number < advised_begin_ || next_page_number >= advised_end_) {
+      file_->prefetchPages(next_page_number, READAHEAD_PAGES);
+      advised_begin_ = next_page_number;
+      advised_end_ = next_page_number + READAHEAD_PAGES;
+    }
+  }
+
+  /**
+   * Unpins the current page, if it is pinned.
+   */
+  void release() {
+    if (current_page_ != NULL) {
+      buf_mgr_->unPinPage(file_, current_page_number_, false);
+      current_page_ = NULL;
+    }
+  }
+
+  /**
+   * Buffer pool pages are read through.
+   */
+  BufMgr* buf_mgr_;
+
+  /**
+   * File we're iterating over.
+   */
+  File* file_;
+
+  /**
+   * Number of page in file iterator is currently pointing to.
+   */
+  PageId current_page_number_;
+
+  /**
+   * Frame holding the current page, or NULL if no page is pinned.
+   */
+  Page* current_page_;
+
+  /**
+   * Range of page numbers the operating system was last asked to read ahead.
+   */
+  PageId advised_begin_;
+  PageId advised_end_;
+};
+
+}
@@ -0,0 +1,298 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "slot_scan.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BADGERDB_SLOT_SCAN_X86 1
+#endif
+
+namespace badgerdb {
+
+namespace {
+
+static_assert(sizeof(CompactPageSlot) == 4 &&
+              offsetof(CompactPageSlot, item_offset) == 0,
+              "Vector scan expects 4-byte compact slots led by the offset.");
+static_assert(sizeof(PageSlot) == 6 && offsetof(PageSlot, used) == 0,
+              "Vector scan expects 6-byte standard slots led by the used flag.");
+
+/**
+ * Slots tested per block by the vector implementations.
+ */
+const std::size_t kCompactBlock = 16;
+const std::size_t kStandardBlock = 8;
+
+/**
+ * A block mask has one bit per byte of a standard block; the used flag of
+ * slot k is bit 6k.
+ */
+const std::uint64_t kStandardUsedBits = 0x041041041041ULL;
+
+/**
+ * Slots tested one at a time before a search switches to whole blocks.  On
+ * dense pages the next used slot is almost always among them.
+ */
+const std::size_t kProbeSlots = 4;
+
+/**
+ * Vector search loops, shared by the instruction sets.  <Masks> provides
+ * compact() and standard(), which return a mask of the used slots in the
+ * block starting at their argument: bit k (compact) or bit 6k (standard) is
+ * set if slot k of the block is used.  Instantiated only inside functions
+ * compiled for the matching instruction set, so the masks can inline.
+ */
+template <typename Masks>
+inline __attribute__((always_inline))
+SlotId findNextUsedBlocks(const char* directory, const PageFormat format,
+                          const SlotId start, const SlotId num_slots) {
+  std::size_t i = start;
+  for (const std::size_t probe_end = i + kProbeSlots;
+       i < probe_end && i < num_slots; ++i) {
+    if (SlotScan::isUsed(directory, format, i)) {
+      return static_cast<SlotId>(i + 1);
+    }
+  }
+  if (format == PageFormat::COMPACT) {
+    for (; i + kCompactBlock <= num_slots; i += kCompactBlock) {
+      const std::uint64_t used =
+          Masks::compact(directory + i * sizeof(CompactPageSlot));
+      if (used != 0) {
+        return static_cast<SlotId>(i + __builtin_ctzll(used) + 1);
+      }
+    }
+  } else {
+    for (; i + kStandardBlock <= num_slots; i += kStandardBlock) {
+      const std::uint64_t used =
+          Masks::standard(directory + i * sizeof(PageSlot));
+      if (used != 0) {
+        return static_cast<SlotId>(
+            i + __builtin_ctzll(used) / sizeof(PageSlot) + 1);
+      }
+    }
+  }
+  for (; i < num_slots; ++i) {
+    if (SlotScan::isUsed(directory, format, i)) {
+      return static_cast<SlotId>(i + 1);
+    }
+  }
+  return Page::INVALID_SLOT;
+}
+
+template <typename Masks>
+inline __attribute__((always_inline))
+std::size_t collectUsedBlocks(const char* directory, const PageFormat format,
+                              const SlotId num_slots, SlotId* slots) {
+  const bool compact = format == PageFormat::COMPACT;
+  const std::size_t block_slots = compact ? kCompactBlock : kStandardBlock;
+  const std::size_t slot_size =
+      compact ? sizeof(CompactPageSlot) : sizeof(PageSlot);
+  const unsigned bits_per_slot = compact ? 1 : sizeof(PageSlot);
+  const std::uint64_t all_used = compact ? 0xFFFF : kStandardUsedBits;
+
+  std::size_t count = 0;
+  std::size_t i = 0;
+  for (; i + block_slots <= num_slots; i += block_slots) {
+    const char* block = directory + i * slot_size;
+    std::uint64_t used = compact ? Masks::compact(block)
+                                 : Masks::standard(block);
+    if (used == all_used) {
+      for (std::size_t k = 0; k < block_slots; ++k) {
+        slots[count++] = static_cast<SlotId>(i + k + 1);
+      }
+      continue;
+    }
+    while (used != 0) {
+      slots[count++] =
+          static_cast<SlotId>(i + __builtin_ctzll(used) / bits_per_slot + 1);
+      used &= used - 1;
+    }
+  }
+  for (; i < num_slots; ++i) {
+    if (SlotScan::isUsed(directory, format, i)) {
+      slots[count++] = static_cast<SlotId>(i + 1);
+    }
+  }
+  return count;
+}
+
+#if defined(BADGERDB_SLOT_SCAN_X86)
+
+struct Sse2Masks {
+  static inline __attribute__((target("sse2")))
+  std::uint64_t compact(const char* block) {
+    const __m128i offset_bits = _mm_set1_epi32(0xFFFF);
+    const __m128i zero = _mm_setzero_si128();
+    std::uint64_t used = 0;
+    for (int j = 0; j < 4; ++j) {
+      const __m128i slots =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * j));
+      const __m128i unused =
+          _mm_cmpeq_epi32(_mm_and_si128(slots, offset_bits), zero);
+      used |= static_cast<std::uint64_t>(
+          ~_mm_movemask_ps(_mm_castsi128_ps(unused)) & 0xF) << (4 * j);
+    }
+    return used;
+  }
+
+  static inline __attribute__((target("sse2")))
+  std::uint64_t standard(const char* block) {
+    const __m128i zero = _mm_setzero_si128();
+    std::uint64_t nonzero = 0;
+    for (int j = 0; j < 3; ++j) {
+      const __m128i bytes =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * j));
+      nonzero |= static_cast<std::uint64_t>(
+          ~_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, zero)) & 0xFFFF) << (16 * j);
+    }
+    return nonzero & kStandardUsedBits;
+  }
+};
+
+struct Avx2Masks {
+  static inline __attribute__((target("avx2")))
+  std::uint64_t compact(const char* block) {
+    const __m256i offset_bits = _mm256_set1_epi32(0xFFFF);
+    const __m256i zero = _mm256_setzero_si256();
+    std::uint64_t used = 0;
+    for (int j = 0; j < 2; ++j) {
+      const __m256i slots = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(block + 32 * j));
+      const __m256i unused =
+          _mm256_cmpeq_epi32(_mm256_and_si256(slots, offset_bits), zero);
+      used |= static_cast<std::uint64_t>(
+          ~_mm256_movemask_ps(_mm256_castsi256_ps(unused)) & 0xFF) << (8 * j);
+    }
+    return used;
+  }
+
+  static inline __attribute__((target("avx2")))
+  std::uint64_t standard(const char* block) {
+    const __m256i head =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m128i tail =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 32));
+    const std::uint64_t head_nonzero = static_cast<std::uint32_t>(
+        ~_mm256_movemask_epi8(_mm256_cmpeq_epi8(head, _mm256_setzero_si256())));
+    const std::uint64_t tail_nonzero =
+        ~_mm_movemask_epi8(_mm_cmpeq_epi8(tail, _mm_setzero_si128())) & 0xFFFF;
+    return (head_nonzero | (tail_nonzero << 32)) & kStandardUsedBits;
+  }
+};
+
+__attribute__((target("sse2")))
+SlotId findNextUsedSse2(const char* directory, const PageFormat format,
+                        const SlotId start, const SlotId num_slots) {
+  return findNextUsedBlocks<Sse2Masks>(directory, format, start, num_slots);
+}
+
+__attribute__((target("sse2")))
+std::size_t collectUsedSse2(const char* directory, const PageFormat format,
+                            const SlotId num_slots, SlotId* slots) {
+  return collectUsedBlocks<Sse2Masks>(directory, format, num_slots, slots);
+}
+
+__attribute__((target("avx2")))
+SlotId findNextUsedAvx2(const char* directory, const PageFormat format,
+                        const SlotId start, const SlotId num_slots) {
+  return findNextUsedBlocks<Avx2Masks>(directory, format, start, num_slots);
+}
+
+__attribute__((target("avx2")))
+std::size_t collectUsedAvx2(const char* directory, const PageFormat format,
+                            const SlotId num_slots, SlotId* slots) {
+  return collectUsedBlocks<Avx2Masks>(directory, format, num_slots, slots);
+}
+
+#endif
+
+typedef SlotId (*FindNextUsedFunction)(const char*, PageFormat, SlotId, SlotId);
+typedef std::size_t (*CollectUsedFunction)(const char*, PageFormat, SlotId,
+                                           SlotId*);
+
+/**
+ * Functions of the implementation chosen for this CPU.
+ */
+struct Kernels {
+  FindNextUsedFunction find_next_used;
+  CollectUsedFunction collect_used;
+  const char* name;
+};
+
+Kernels chooseKernels() {
+#if defined(BADGERDB_SLOT_SCAN_X86)
+  // Runs during static initialization, possibly before the CPU model is.
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    const Kernels avx2 = {findNextUsedAvx2, collectUsedAvx2, "avx2"};
+    return avx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    const Kernels sse2 = {findNextUsedSse2, collectUsedSse2, "sse2"};
+    return sse2;
+  }
+#endif
+  const Kernels portable = {SlotScan::findNextUsedPortable,
+                            SlotScan::collectUsedPortable, "portable"};
+  return portable;
+}
+
+/**
+ * Chosen once at startup rather than on first use, so that the per-call cost
+ * of a search is a single indirect call; searches are often very short.
+ */
+const Kernels kKernels = chooseKernels();
+
+}
+
+SlotId SlotScan::findNextUsedAfter(const char* directory,
+                                   const PageFormat format, const SlotId start,
+                                   const SlotId num_slots) {
+  return kKernels.find_next_used(directory, format, start, num_slots);
+}
+
+std::size_t SlotScan::collectUsed(const char* directory,
+                                  const PageFormat format,
+                                  const SlotId num_slots, SlotId* slots) {
+  return kKernels.collect_used(directory, format, num_slots, slots);
+}
+
+SlotId SlotScan::findNextUsedPortable(const char* directory,
+                                      const PageFormat format,
+                                      const SlotId start,
+                                      const SlotId num_slots) {
+  for (std::size_t i = start; i < num_slots; ++i) {
+    if (SlotScan::isUsed(directory, format, i)) {
+      return static_cast<SlotId>(i + 1);
+    }
+  }
+  return Page::INVALID_SLOT;
+}
+
+std::size_t SlotScan::collectUsedPortable(const char* directory,
+                                          const PageFormat format,
+                                          const SlotId num_slots,
+                                          SlotId* slots) {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < num_slots; ++i) {
+    if (SlotScan::isUsed(directory, format, i)) {
+      slots[count++] = static_cast<SlotId>(i + 1);
+    }
+  }
+  return count;
+}
+
+const char* SlotScan::implementation() {
+  return kKernels.name;
+}
+
+}
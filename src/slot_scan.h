@@ -0,0 +1,118 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Finds used slots in a page's slot directory.
+ *
+ * Tests many slots per instruction with AVX2 or SSE2 when the CPU supports
+ * them (16 compact slots or 8 standard slots at a time), and one slot at a
+ * time otherwise.  All implementations produce identical results.
+ *
+ * Slot directories are passed as a pointer to the start of a page's data
+ * area, where slot 1 lives, along with the page's format and slot count.
+ * Only bytes of the directory itself are read.
+ */
+class SlotScan {
+ public:
+  /**
+   * Returns the first used slot after the given slot.
+   *
+   * @param directory   Start of the slot directory.
+   * @param format      Layout of the slot directory.
+   * @param start       Slot to start search after, or Page::INVALID_SLOT to
+   *                    search from the first slot.
+   * @param num_slots   Number of slots in the directory.
+   * @return  Number of the next used slot, or Page::INVALID_SLOT if none is
+   *          used after <start>.
+   */
+  static SlotId findNextUsed(const char* directory, const PageFormat format,
+                             const SlotId start, const SlotId num_slots) {
+    // On dense pages the very next slot is usually used; settle that case
+    // without a call.
+    if (start < num_slots && isUsed(directory, format, start)) {
+      return start + 1;
+    }
+    return findNextUsedAfter(directory, format, start, num_slots);
+  }
+
+  /**
+   * Writes the numbers of all used slots, in increasing order, to <slots>.
+   *
+   * @param directory   Start of the slot directory.
+   * @param format      Layout of the slot directory.
+   * @param num_slots   Number of slots in the directory.
+   * @param slots       Output array with room for <num_slots> entries.
+   * @return  Number of used slots written.
+   */
+  static std::size_t collectUsed(const char* directory, const PageFormat format,
+                                 const SlotId num_slots, SlotId* slots);
+
+  /**
+   * Same as findNextUsed(), but tests one slot at a time.
+   */
+  static SlotId findNextUsedPortable(const char* directory,
+                                     const PageFormat format,
+                                     const SlotId start,
+                                     const SlotId num_slots);
+
+  /**
+   * Same as collectUsed(), but tests one slot at a time.
+   */
+  static std::size_t collectUsedPortable(const char* directory,
+                                         const PageFormat format,
+                                         const SlotId num_slots,
+                                         SlotId* slots);
+
+  /**
+   * Returns true if the slot at the given index (slot number - 1) is used.
+   *
+   * @param directory   Start of the slot directory.
+   * @param format      Layout of the slot directory.
+   * @param index       Index of slot in the directory.
+   * @return  Whether the slot is used.
+   */
+  static bool isUsed(const char* directory, const PageFormat format,
+                     const std::size_t index) {
+    if (format == PageFormat::COMPACT) {
+      std::uint16_t item_offset;
+      std::memcpy(&item_offset, directory + index * sizeof(CompactPageSlot),
+                  sizeof(item_offset));
+      return item_offset != 0;
+    }
+    return directory[index * sizeof(PageSlot)] != 0;
+  }
+
+  /**
+   * Returns the name of the implementation used on this CPU: "avx2", "sse2"
+   * or "portable".
+   *
+   * @return  Implementation name.
+   */
+  static const char* implementation();
+
+ private:
+  /**
+   * Vectorized part of findNextUsed(), which has already found slot
+   * <start> + 1 unused.
+   */
+  static SlotId findNextUsedAfter(const char* directory,
+                                  const PageFormat format, const SlotId start,
+                                  const SlotId num_slots);
+};
+
+}
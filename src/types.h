@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <cstddef>
+
 namespace badgerdb {
 
 /**
@@ -59,4 +61,20 @@ struct RecordId {
   }
 };
 
+/**
+ * @brief Read-only view of a record's bytes where they are stored, such as
+ * in a page pinned in the buffer pool.  Only valid while that storage is.
+ */
+struct RecordView {
+  /**
+   * First byte of the record.
+   */
+  const char* data;
+
+  /**
+   * Length of the record in bytes.
+   */
+  std::size_t length;
+};
+
 }
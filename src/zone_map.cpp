@@ -0,0 +1,132 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "zone_map.h"
+
+#include <cstring>
+#include <limits>
+
+#include "record_predicate.h"
+
+namespace badgerdb {
+
+ZoneMap::ZoneMap(const std::string& filename, const std::size_t key_offset,
+                 const ZoneKeyType key_type)
+    : key_offset_(key_offset),
+      key_type_(key_type),
+      file_(File::open(filename)),
+      synced_writes_(0) {
+  file_.startCountingPageWrites();
+  synced_writes_ = file_.pageWrites();
+  const std::string map_filename = File::zoneMapFilename(filename);
+  if (File::exists(map_filename)) {
+    stream_.open(map_filename, std::fstream::in | std::fstream::out |
+                                   std::fstream::binary);
+    ZoneMapHeader existing;
+    stream_.read(reinterpret_cast<char*>(&existing), sizeof(existing));
+    if (stream_ && existing.key_offset == key_offset &&
+        existing.key_type == key_type &&
+        existing.page_writes == synced_writes_) {
+      ZoneEntry entry;
+      while (stream_.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
+        entries_.push_back(entry);
+      }
+      stream_.clear();
+      return;
+    }
+    stream_.close();
+  }
+  // New, summarizing a different key, or missing a write to the file: start
+  // with no page summarized.
+  stream_.open(map_filename, std::fstream::in | std::fstream::out |
+                                 std::fstream::binary | std::fstream::trunc);
+  writeHeader();
+}
+
+void ZoneMap::writeHeader() {
+  const ZoneMapHeader header = {static_cast<std::uint32_t>(key_offset_),
+                                key_type_, synced_writes_};
+  stream_.seekp(0, std::ios::beg);
+  stream_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  stream_.flush();
+}
+
+void ZoneMap::summarize(const Page& page) {
+  ZoneEntry entry = {std::numeric_limits<std::int64_t>::max(),
+                     std::numeric_limits<std::int64_t>::min(), 1};
+  const std::size_t width = static_cast<std::size_t>(key_type_);
+  std::vector<SlotId> slots;
+  page.getUsedSlots(slots);
+  for (std::size_t i = 0; i < slots.size(); ++i) {
+    const RecordId record_id = {page.page_number(), slots[i]};
+    const RecordView record = page.getRecordView(record_id);
+    if (record.length < key_offset_ || record.length - key_offset_ < width) {
+      continue;
+    }
+    std::int64_t key;
+    if (key_type_ == ZoneKeyType::INT32) {
+      std::int32_t key32;
+      std::memcpy(&key32, record.data + key_offset_, sizeof(key32));
+      key = key32;
+    } else {
+      std::memcpy(&key, record.data + key_offset_, sizeof(key));
+    }
+    if (key < entry.min) {
+      entry.min = key;
+    }
+    if (key > entry.max) {
+      entry.max = key;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  const PageId page_number = page.page_number();
+  if (page_number >= entries_.size()) {
+    const ZoneEntry unsummarized = {0, 0, 0};
+    entries_.resize(page_number + 1, unsummarized);
+  }
+  entries_[page_number] = entry;
+  stream_.seekp(static_cast<std::streamoff>(sizeof(ZoneMapHeader)) +
+                    static_cast<std::streamoff>(page_number) * sizeof(entry),
+                std::ios::beg);
+  stream_.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+  ++synced_writes_;
+  if (inSync()) {
+    writeHeader();
+  } else {
+    stream_.flush();
+  }
+}
+
+bool ZoneMap::mayMatch(const PageId page_number,
+                       const RecordPredicate& predicate) const {
+  ZoneEntry summary;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!inSync() || page_number >= entries_.size()) {
+      return true;
+    }
+    summary = entries_[page_number];
+  }
+  if (!summary.summarized) {
+    return true;
+  }
+  return predicate.mayMatchRange(key_offset_,
+                                 static_cast<std::size_t>(key_type_),
+                                 summary.min, summary.max);
+}
+
+ZoneEntry ZoneMap::entry(const PageId page_number) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (page_number >= entries_.size()) {
+    const ZoneEntry unsummarized = {0, 0, 0};
+    return unsummarized;
+  }
+  return entries_[page_number];
+}
+
+}
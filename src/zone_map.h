@@ -0,0 +1,207 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+class RecordPredicate;
+
+/**
+ * @brief Type of the key a zone map summarizes.
+ */
+enum class ZoneKeyType : std::uint32_t {
+  /**
+   * 32-bit signed integer, as compared by RecordPredicate::int32At().
+   */
+  INT32 = 4,
+
+  /**
+   * 64-bit signed integer, as compared by RecordPredicate::int64At().
+   */
+  INT64 = 8
+};
+
+/**
+ * @brief Summary of one page in a zone map.
+ */
+struct ZoneEntry {
+  /**
+   * Smallest key on the page.  Greater than <max> if no record on the page
+   * is long enough to hold a key.
+   */
+  std::int64_t min;
+
+  /**
+   * Largest key on the page.
+   */
+  std::int64_t max;
+
+  /**
+   * Nonzero if the page has been summarized.  Pages that have not been are
+   * never skipped.
+   */
+  std::uint32_t summarized;
+};
+
+/**
+ * @brief Per-page minimum and maximum of an integer key stored at a fixed
+ * offset in a file's records, used to skip pages that cannot hold records
+ * matching a predicate on that key.
+ *
+ * A zone map is kept in a side file next to the data file (see
+ * File::zoneMapFilename()) and is filled in by summarize() as pages are
+ * written.  Attach it to a BufMgr with BufMgr::setWriteBackHook() so that
+ * every page the pool writes back is summarized.  Filtered scans given the
+ * zone map (BufMgr::filterFile(), ParallelScan::forEachMatch()) then skip
+ * pages whose summary rules out a match without reading them.
+ *
+ * The zone map counts the pages it summarizes against the data file's count
+ * of page writes (File::pageWrites()), which opening it starts.  While a page
+ * written to the file has not been summarized, no page is skipped, and a side
+ * file whose count does not match the data file's when opened is discarded,
+ * so a page written without the zone map is never skipped on a stale
+ * summary.  Open the zone map before other threads write pages of the file,
+ * so that none of their writes goes uncounted.
+ *
+ * Summaries describe pages as last written.  Scans still read any page that
+ * is in the buffer pool, so changes not yet written back are never missed.
+ *
+ * Safe to use from several threads at once.
+ */
+class ZoneMap {
+ public:
+  /**
+   * Opens the zone map of a file, creating it if it does not exist.  An
+   * existing zone map of a different key, or one that missed a write to the
+   * file, is discarded.  Starts counting the file's page writes.
+   *
+   * @param filename    Name of the data file, which must exist.
+   * @param key_offset  Offset of the key in each record.
+   * @param key_type    Type of the key.
+   * @throws  FileNotFoundException  If the data file does not exist.
+   */
+  ZoneMap(const std::string& filename, const std::size_t key_offset,
+          const ZoneKeyType key_type);
+
+  /**
+   * Records the range of keys on a page, replacing its previous summary.
+   * Must be called once for every page written to the file, after the write.
+   *
+   * @param page  Page as written to the file.
+   */
+  void summarize(const Page& page);
+
+  /**
+   * Returns false if no record on the page, as last summarized, can match
+   * the predicate.  Only integer compares on this zone map's key can rule a
+   * page out, and only while every page written to the file has been
+   * summarized.
+   *
+   * @param page_number Number of page.
+   * @param predicate   Condition records must satisfy.
+   * @return  Whether the page may hold a matching record.
+   */
+  bool mayMatch(const PageId page_number,
+                const RecordPredicate& predicate) const;
+
+  /**
+   * Returns the summary of a page.
+   *
+   * @param page_number Number of page.
+   * @return  The page's summary; <summarized> is 0 if it has none.
+   */
+  ZoneEntry entry(const PageId page_number) const;
+
+  /**
+   * Returns the offset of the key in each record.
+   *
+   * @return  Key offset.
+   */
+  std::size_t key_offset() const { return key_offset_; }
+
+  /**
+   * Returns the type of the key.
+   *
+   * @return  Key type.
+   */
+  ZoneKeyType key_type() const { return key_type_; }
+
+ private:
+  /**
+   * Layout of the start of the side file, identifying the key summarized and
+   * the data file's count of page writes the summaries are up to date with.
+   */
+  struct ZoneMapHeader {
+    std::uint32_t key_offset;
+    ZoneKeyType key_type;
+    std::uint64_t page_writes;
+  };
+
+  /**
+   * Returns true if every page written to the file has been summarized;
+   * mutex_ must be held.
+   */
+  bool inSync() const { return synced_writes_ == file_.pageWrites(); }
+
+  /**
+   * Writes the header of the side file with the current count of page
+   * writes; mutex_ must be held.
+   */
+  void writeHeader();
+
+  /**
+   * Offset of the key in each record.
+   */
+  std::size_t key_offset_;
+
+  /**
+   * Type of the key.
+   */
+  ZoneKeyType key_type_;
+
+  /**
+   * The data file, for its count of page writes.
+   */
+  File file_;
+
+  /**
+   * Count of page writes the summaries account for: the file's count when
+   * the zone map was opened, plus the pages summarized since.
+   */
+  std::uint64_t synced_writes_;
+
+  /**
+   * Summaries of all pages, indexed by page number.  Pages past the end have
+   * not been summarized.
+   */
+  std::vector<ZoneEntry> entries_;
+
+  /**
+   * Stream to the side file.  Every summary is written through as soon as
+   * it changes.
+   */
+  std::fstream stream_;
+
+  /**
+   * Guards entries_, synced_writes_ and stream_.
+   */
+  mutable std::mutex mutex_;
+};
+
+}